@@ -0,0 +1,99 @@
+#include "AdaptiveCompressionLevel.h"
+#include "ConfigurationParameters.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace cce::tf;
+
+AdaptiveCompressionLevel::AdaptiveCompressionLevel(int iMinLevel, int iMaxLevel, int iInitialLevel, unsigned int iTargetQueueDepth, unsigned int iUpdateInterval):
+  minLevel_{iMinLevel},
+  maxLevel_{iMaxLevel},
+  targetQueueDepth_{iTargetQueueDepth},
+  updateInterval_{iUpdateInterval},
+  level_{std::clamp(iInitialLevel, iMinLevel, iMaxLevel)},
+  nCompressed_(iMaxLevel-iMinLevel+1),
+  compressionTime_(iMaxLevel-iMinLevel+1)
+{
+  for(auto& n: nCompressed_) {
+    n.store(0);
+  }
+  for(auto& t: compressionTime_) {
+    t.store(0);
+  }
+}
+
+void AdaptiveCompressionLevel::takenByWriter() {
+  --queueDepth_;
+  auto now = std::chrono::steady_clock::now();
+  if(lastTaken_ != std::chrono::steady_clock::time_point()) {
+    summedTakenInterval_ += std::chrono::duration_cast<std::chrono::microseconds>(now - lastTaken_).count();
+    ++nTakenIntervals_;
+  }
+  lastTaken_ = now;
+}
+
+void AdaptiveCompressionLevel::compressed(int iLevel, std::chrono::microseconds iTime) {
+  nCompressed_[iLevel-minLevel_] += 1;
+  compressionTime_[iLevel-minLevel_] += iTime.count();
+
+  summedQueueDepth_ += queueDepth_.load();
+  if(++nSinceUpdate_ == updateInterval_) {
+    //other threads may add samples while this is done, that only makes the average approximate
+    nSinceUpdate_ = 0;
+    update(double(summedQueueDepth_.exchange(0))/updateInterval_);
+  }
+}
+
+void AdaptiveCompressionLevel::update(double iAverageQueueDepth) {
+  auto const takenInterval = summedTakenInterval_.exchange(0);
+  auto const nTakenIntervals = nTakenIntervals_.exchange(0);
+
+  auto level = level_.load();
+  if(iAverageQueueDepth < 1. and level > minLevel_) {
+    level_ = level-1;
+  } else if(iAverageQueueDepth > targetQueueDepth_ and level < maxLevel_) {
+    //if the writer took nothing since the last update it is too slow to matter
+    if(nTakenIntervals != 0) {
+      auto const drainTime = double(takenInterval)/nTakenIntervals*targetQueueDepth_;
+      auto index = level+1-minLevel_;
+      if(nCompressed_[index].load() == 0) {
+        index = level-minLevel_;
+      }
+      auto const n = nCompressed_[index].load();
+      if(n != 0 and double(compressionTime_[index].load())/n > drainTime) {
+        ++nRaisesRefused_;
+        return;
+      }
+    }
+    level_ = level+1;
+  }
+}
+
+void AdaptiveCompressionLevel::printSummary(std::ostream& iOS) const {
+  for(int level = minLevel_; level <= maxLevel_; ++level) {
+    auto n = nCompressed_[level-minLevel_].load();
+    if(n != 0) {
+      iOS <<"  compression level "<<level<<": "<<n<<" buffers, average compression time "<<compressionTime_[level-minLevel_].load()/n<<"us\n";
+    }
+  }
+  if(nRaisesRefused_.load() != 0) {
+    iOS <<"  compression level not raised because of the compression time: "<<nRaisesRefused_.load()<<" times\n";
+  }
+}
+
+std::optional<std::unique_ptr<AdaptiveCompressionLevel>> cce::tf::makeAdaptiveCompressionLevel(ConfigurationParameters const& params, pds::Compression iCompression, int iCompressionLevel) {
+  if(not params.get<bool>("adaptiveCompression", false)) {
+    return std::unique_ptr<AdaptiveCompressionLevel>();
+  }
+  if(iCompression != pds::Compression::kZSTD and iCompression != pds::Compression::kZSTDLong) {
+    std::cout <<"adaptiveCompression can only be used with ZSTD or LongZSTD compression"<<std::endl;
+    return std::nullopt;
+  }
+  auto minLevel = params.get<int>("minCompressionLevel", 1);
+  auto maxLevel = params.get<int>("maxCompressionLevel", 19);
+  if(minLevel > maxLevel) {
+    std::cout <<"minCompressionLevel must not be greater than maxCompressionLevel"<<std::endl;
+    return std::nullopt;
+  }
+  return std::make_unique<AdaptiveCompressionLevel>(minLevel, maxLevel, iCompressionLevel, params.get<unsigned int>("targetQueueDepth", 2));
+}
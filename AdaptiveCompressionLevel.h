@@ -0,0 +1,85 @@
+#if !defined(AdaptiveCompressionLevel_h)
+#define AdaptiveCompressionLevel_h
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include "pds_common.h"
+
+namespace cce::tf {
+  /*---------------------------------------
+  AdaptiveCompressionLevel chooses the compression level at run time for an
+  outputer whose buffers are compressed concurrently and then written by a
+  serial writer. The outputer tells it when a buffer is handed to the writer's
+  queue and when the writer takes it, and how long each compression took.
+  If a buffer is compressed in parts, e.g. one data product at a time, the
+  times of the parts must be summed and given once for the buffer so the
+  averages are per buffer just as the queue depth is.
+  Every iUpdateInterval compressions the average number of buffers waiting
+  for the writer is checked: if it is below 1 the writer is waiting on the
+  compression so the level is lowered, if it is above iTargetQueueDepth the
+  compression is keeping ahead of the writer so the level is raised. This
+  gives the best compression ratio which still keeps the writer busy.
+
+  The level is not raised if a buffer would then take longer to compress
+  than the writer needs to empty a queue of iTargetQueueDepth buffers. The
+  compression time is the average measured for the higher level, or for the
+  present level if the higher one has not been used yet. The writer's time
+  per buffer is the average time between the buffers it took since the last
+  check. Otherwise a level could be reached where one slow compression
+  leaves the writer idle even though the queue was long.
+
+  The level is always within [iMinLevel, iMaxLevel].
+  ---------------------------------------*/
+  class AdaptiveCompressionLevel {
+  public:
+    AdaptiveCompressionLevel(int iMinLevel, int iMaxLevel, int iInitialLevel, unsigned int iTargetQueueDepth, unsigned int iUpdateInterval = 16);
+
+    AdaptiveCompressionLevel(AdaptiveCompressionLevel const&) = delete;
+    AdaptiveCompressionLevel& operator=(AdaptiveCompressionLevel const&) = delete;
+
+    //level to use for the next compression
+    int level() const { return level_.load(); }
+
+    void pushedToWriter() { ++queueDepth_; }
+    //must be called by the serial writer
+    void takenByWriter();
+
+    //iLevel is the level which was used for the buffer
+    void compressed(int iLevel, std::chrono::microseconds iTime);
+
+    //the number of buffers and average compression time for each level used
+    void printSummary(std::ostream&) const;
+  private:
+    void update(double iAverageQueueDepth);
+
+    int const minLevel_;
+    int const maxLevel_;
+    unsigned int const targetQueueDepth_;
+    unsigned int const updateInterval_;
+    std::atomic<int> level_;
+    std::atomic<int> queueDepth_{0};
+    std::atomic<long long> summedQueueDepth_{0};
+    std::atomic<unsigned int> nSinceUpdate_{0};
+    //time between buffers taken by the writer since the last update
+    std::chrono::steady_clock::time_point lastTaken_;
+    std::atomic<std::chrono::microseconds::rep> summedTakenInterval_{0};
+    std::atomic<unsigned int> nTakenIntervals_{0};
+    std::atomic<unsigned long long> nRaisesRefused_{0};
+    //indexed by level - minLevel_
+    std::vector<std::atomic<unsigned long long>> nCompressed_;
+    std::vector<std::atomic<std::chrono::microseconds::rep>> compressionTime_;
+  };
+
+  class ConfigurationParameters;
+
+  //Reads adaptiveCompression, minCompressionLevel, maxCompressionLevel and targetQueueDepth. Returns a nullptr
+  // if adaptiveCompression is off and nullopt if the parameters can not be used with iCompression.
+  std::optional<std::unique_ptr<AdaptiveCompressionLevel>> makeAdaptiveCompressionLevel(ConfigurationParameters const& params, pds::Compression iCompression, int iCompressionLevel);
+}
+
+#endif
@@ -0,0 +1,59 @@
+#include <vector>
+#include <iostream>
+#include "EventIdentifier.h"
+#include "DataProductRetriever.h"
+#include "TaskHolder.h"
+#include "TimerService.h"
+#include "WaiterBase.h"
+#include "WaiterFactory.h"
+#include "EventSleepTimes.h"
+
+
+namespace cce::tf {
+  //Same timing as EventSleepWaiter but the wait is handled by the TimerService
+  // so no TBB worker thread is occupied while waiting.
+  class AsyncSleepWaiter : public WaiterBase {
+ public:
+
+    AsyncSleepWaiter(std::vector<double> iEventSleepTimes, std::size_t iNDataProducts):
+      sleepTimes_(std::move(iEventSleepTimes)),
+      nDataProducts_{iNDataProducts} {}
+
+    void waitAsync(unsigned int iLaneIndex, EventIdentifier const& iEventID, long iEventIndex,
+                   std::vector<DataProductRetriever> const& iRetrievers, unsigned int index,
+                   TaskHolder iCallback) const final {
+      using namespace std::chrono_literals;
+      auto eventIndex = iEventIndex % sleepTimes_.size();
+      auto sleep = std::chrono::duration_cast<TimerService::clock::duration>((sleepTimes_[eventIndex]/nDataProducts_)*1us);
+      timer_.callAfter(sleep, std::move(iCallback));
+    }
+
+ private:
+    std::vector<double> sleepTimes_;
+    std::size_t nDataProducts_;
+    mutable TimerService timer_;
+};
+}
+
+namespace {
+
+  using namespace cce::tf;
+  class Maker : public WaiterMakerBase {
+  public:
+    Maker(): WaiterMakerBase("AsyncSleepWaiter") {}
+
+    std::unique_ptr<WaiterBase> create(unsigned int iNLanes, std::vector<DataProductRetriever> const& iDataProducts, ConfigurationParameters const& params) const final {
+      auto const nDataProducts = iDataProducts.size();
+
+      auto sleepTimes = readEventSleepTimes(params, "AsyncSleepWaiter");
+      if(not sleepTimes) {
+        return {};
+      }
+
+      return std::make_unique<AsyncSleepWaiter>(std::move(*sleepTimes), nDataProducts);
+    }
+
+  };
+
+  Maker s_maker;
+}
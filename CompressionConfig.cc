@@ -0,0 +1,46 @@
+#include "CompressionConfig.h"
+#include "ConfigurationParameters.h"
+#include <iostream>
+#include <limits>
+
+#include "zstd.h"
+
+namespace {
+  //0 keeps what ZSTD chooses so it is always allowed
+  bool inBounds(ZSTD_cParameter iParameter, int iValue, const char* iName) {
+    if(iValue == 0) {
+      return true;
+    }
+    auto bounds = ZSTD_cParam_getBounds(iParameter);
+    if(ZSTD_isError(bounds.error) or iValue < bounds.lowerBound or iValue > bounds.upperBound) {
+      std::cout <<iName<<" must be 0 or in the range ["<<bounds.lowerBound<<","<<bounds.upperBound<<"]"<<std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+namespace cce::tf {
+  std::optional<pds::ZSTDParameters> parseZSTDParameters(ConfigurationParameters const& params) {
+    pds::ZSTDParameters parameters;
+    parameters.windowLog = params.get<int>("zstdWindowLog", parameters.windowLog);
+    parameters.strategy = params.get<int>("zstdStrategy", parameters.strategy);
+    parameters.longDistanceMatching = params.get<bool>("zstdLongDistanceMatching", parameters.longDistanceMatching);
+
+    if(not inBounds(ZSTD_c_windowLog, parameters.windowLog, "zstdWindowLog") or
+       not inBounds(ZSTD_c_strategy, parameters.strategy, "zstdStrategy")) {
+      return std::nullopt;
+    }
+    return parameters;
+  }
+
+  std::optional<uint32_t> parseCompressionBlockSize(ConfigurationParameters const& params) {
+    //negative values wrap around when converted so they are also rejected
+    auto blockSize = params.get<std::size_t>("compressionBlockSize", 0);
+    if(blockSize > std::numeric_limits<uint32_t>::max()) {
+      std::cout <<"compressionBlockSize must not be greater than "<<std::numeric_limits<uint32_t>::max()<<std::endl;
+      return std::nullopt;
+    }
+    return blockSize;
+  }
+}
@@ -0,0 +1,19 @@
+#if !defined(CompressionConfig_h)
+#define CompressionConfig_h
+
+#include <optional>
+#include <cstdint>
+
+#include "pds_common.h"
+
+namespace cce::tf {
+  class ConfigurationParameters;
+
+  //reads zstdWindowLog, zstdStrategy and zstdLongDistanceMatching, returns nullopt if a value is out of ZSTD's range
+  std::optional<pds::ZSTDParameters> parseZSTDParameters(ConfigurationParameters const& params);
+
+  //reads compressionBlockSize, which is stored as a uint32_t, returns nullopt if the value does not fit
+  std::optional<uint32_t> parseCompressionBlockSize(ConfigurationParameters const& params);
+}
+
+#endif
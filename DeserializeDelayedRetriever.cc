@@ -0,0 +1,57 @@
+#include "DeserializeDelayedRetriever.h"
+
+using namespace cce::tf;
+
+void DeserializeDelayedRetriever::getAsync(DataProductRetriever& iDataProduct, int index, TaskHolder iTask) {
+  if(not lazy_) {
+    return;
+  }
+  auto group = iTask.group();
+  group->run([this, &iDataProduct, index, task = std::move(iTask)]() {
+      if(not compressedProducts_.empty()) {
+        uncompress(index);
+      }
+      auto start = std::chrono::high_resolution_clock::now();
+      auto product = products_[index];
+      if(product.data() != nullptr) {
+        iDataProduct.setSize( (*deserializers_)[index].deserialize(product.data(), product.size(), *iDataProduct.address()) );
+      }
+      deserializeTimes_[index] += 
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+    });
+}
+
+void DeserializeDelayedRetriever::uncompress(int index) {
+  auto const& compressed = compressedProducts_[index];
+  if(compressed.compressed_.data() == nullptr) {
+    products_[index] = Span<char const>();
+    return;
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  auto& buffer = uncompressedProducts_[index];
+  products_[index] = pds::uncompressedProduct(compression_, compressed, buffer, dictionary_, shuffleSizes_[index]);
+  uncompressTimes_[index] += 
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+}
+
+void DeserializeDelayedRetriever::uncompressAll() {
+  for(int index = 0; index < static_cast<int>(compressedProducts_.size()); ++index) {
+    uncompress(index);
+  }
+}
+
+std::chrono::microseconds DeserializeDelayedRetriever::uncompressTime() const {
+  auto time = std::chrono::microseconds::zero();
+  for(auto t: uncompressTimes_) {
+    time += t;
+  }
+  return time;
+}
+
+std::chrono::microseconds DeserializeDelayedRetriever::deserializeTime() const {
+  auto time = std::chrono::microseconds::zero();
+  for(auto t: deserializeTimes_) {
+    time += t;
+  }
+  return time;
+}
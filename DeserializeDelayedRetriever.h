@@ -0,0 +1,84 @@
+#if !defined(DeserializeDelayedRetriever_h)
+#define DeserializeDelayedRetriever_h
+
+#include <chrono>
+#include <vector>
+
+#include "DelayedProductRetriever.h"
+#include "DataProductRetriever.h"
+#include "DeserializeStrategy.h"
+#include "Span.h"
+#include "UninitializedBuffer.h"
+#include "pds_reading.h"
+
+namespace cce::tf {
+  /*---------------------------------------
+  Used by the sources which read a whole event as one (uncompressed) buffer.
+  When lazy, the source only records where each data product is within that
+  buffer and a data product is deserialized, as its own task, the first time
+  getAsync is called for it. The buffer must stay valid until all data products
+  for the event have been retrieved. When not lazy, the source deserializes
+  everything when reading the event, possibly using deserializeAllAsync, and
+  getAsync has nothing to do.
+  For events where each data product was compressed separately (pds::Layout::kProduct),
+  the source calls setCompression and fills compressedProducts() instead. A lazy
+  data product is then uncompressed in the same task which deserializes it so only the
+  data products asked for are uncompressed. Otherwise the source calls uncompressAll.
+  ---------------------------------------*/
+  class DeserializeDelayedRetriever : public DelayedProductRetriever {
+  public:
+    DeserializeDelayedRetriever(bool iLazy, DeserializeStrategy const* iDeserializers, std::size_t iNProducts):
+      deserializers_{iDeserializers},
+      products_(iNProducts),
+      deserializeTimes_(iNProducts, std::chrono::microseconds::zero()),
+      lazy_{iLazy} {}
+
+    //iShuffleSizes holds pds::ProductInfo::shuffleSize() for each data product
+    void setCompression(pds::Compression iCompression, pds::DecompressionDictionary const* iDictionary, std::vector<uint32_t> iShuffleSizes) {
+      compression_ = iCompression;
+      dictionary_ = iDictionary;
+      shuffleSizes_ = std::move(iShuffleSizes);
+      compressedProducts_.resize(products_.size());
+      uncompressedProducts_.resize(products_.size());
+      uncompressTimes_.resize(products_.size(), std::chrono::microseconds::zero());
+    }
+
+    void getAsync(DataProductRetriever&, int index, TaskHolder) final;
+
+    bool lazy() const { return lazy_;}
+
+    //Where each data product is for the present event. A Span with a nullptr
+    // data() means the data product is not stored in the event.
+    std::vector<Span<char const>>& products() { return products_;}
+
+    //Where each compressed data product is for the present event, only used after setCompression
+    std::vector<pds::CompressedProduct>& compressedProducts() { return compressedProducts_;}
+    //uncompresses all compressedProducts() and sets products() to the results
+    void uncompressAll();
+
+    //deserializes all data products in products() using separate tasks, see pds::deserializeDataProductsAsync
+    void deserializeAllAsync(std::vector<DataProductRetriever>& iDataProducts, std::size_t iGroupBytes, TaskHolder iTask) {
+      pds::deserializeDataProductsAsync(products_, iDataProducts, *deserializers_, deserializeTimes_, iGroupBytes, std::move(iTask));
+    }
+
+    std::chrono::microseconds deserializeTime() const;
+    std::chrono::microseconds uncompressTime() const;
+  private:
+    void uncompress(int index);
+
+    DeserializeStrategy const* deserializers_;
+    std::vector<Span<char const>> products_;
+    //each data product has its own time since they are deserialized concurrently
+    std::vector<std::chrono::microseconds> deserializeTimes_;
+    std::vector<pds::CompressedProduct> compressedProducts_;
+    //reused for each event
+    std::vector<UninitializedBuffer<uint32_t>> uncompressedProducts_;
+    std::vector<std::chrono::microseconds> uncompressTimes_;
+    pds::Compression compression_ = pds::Compression::kNone;
+    pds::DecompressionDictionary const* dictionary_ = nullptr;
+    std::vector<uint32_t> shuffleSizes_;
+    bool lazy_;
+  };
+}
+
+#endif
@@ -4,19 +4,34 @@
 #include "TaskHolder.h"
 
 #include <vector>
+#include <atomic>
 #include "TClass.h"
 
 #include "ProxyVector.h"
+#include "allocation_counting.h"
 
 namespace cce::tf {
 class DeserializeProxyBase {
  public:
  DeserializeProxyBase() = default;
+ DeserializeProxyBase(DeserializeProxyBase&& iOther): allocations_{iOther.allocations_.load()} {}
 
  virtual ~DeserializeProxyBase();
 
   virtual int deserialize(std::vector<char> const& iBuffer, void* iWriteTo) const = 0;
   virtual int deserialize(char const * iBuffer, size_t iBufferSize, void* iWriteTo) const = 0;
+  //collections of builtins larger than iBytes are deserialized using multiple tasks, 0 turns this off
+  virtual void setParallelChunkSize(std::size_t iBytes) = 0;
+  //if true, collections in the object are refilled reusing their elements and capacity where the
+  // deserializer has a choice
+  virtual void setRecycle(bool iRecycle) = 0;
+
+  //number of allocations made by all calls to deserialize
+  std::size_t allocations() const { return allocations_.load(); }
+ protected:
+  void addAllocations(std::size_t iN) const { allocations_.fetch_add(iN, std::memory_order_relaxed); }
+ private:
+  mutable std::atomic<std::size_t> allocations_{0};
 };
 
 
@@ -27,11 +42,19 @@ class DeserializeProxy final : public DeserializeProxyBase {
   deserializer_{tClass} {}
 
   int deserialize(std::vector<char> const& iBuffer, void* iWriteTo) const {
-    return deserializer_.deserialize(iBuffer, iWriteTo);
+    auto const start = alloc::count();
+    auto size = deserializer_.deserialize(iBuffer, iWriteTo);
+    addAllocations(alloc::count() - start);
+    return size;
   }
   int deserialize(char const * iBuffer, size_t iBufferSize, void* iWriteTo) const {
-    return deserializer_.deserialize(iBuffer, iBufferSize, iWriteTo);
+    auto const start = alloc::count();
+    auto size = deserializer_.deserialize(iBuffer, iBufferSize, iWriteTo);
+    addAllocations(alloc::count() - start);
+    return size;
   }
+  void setParallelChunkSize(std::size_t iBytes) { deserializer_.setParallelChunkSize(iBytes); }
+  void setRecycle(bool iRecycle) { deserializer_.setRecycle(iRecycle); }
  private:
   D deserializer_;
 };
@@ -4,26 +4,39 @@
 #include <vector>
 #include "TBufferFile.h"
 #include "TClass.h"
+#include "tbb/enumerable_thread_specific.h"
 
 namespace cce::tf {
 class Deserializer {
 public:
-  explicit Deserializer(TClass* iClass) : class_{iClass} {}
+  explicit Deserializer(TClass* iClass) : class_{iClass}, bufferFiles_{TBuffer::kRead} {}
+
+  Deserializer(Deserializer&& iOther): class_{iOther.class_}, bufferFiles_{TBuffer::kRead} {}
+  Deserializer(Deserializer const& iOther): class_{iOther.class_}, bufferFiles_{TBuffer::kRead} {}
 
   int deserialize(std::vector<char> const& iBuffer, void* iWriteTo) const {
     return deserialize(&iBuffer.front(), iBuffer.size(), iWriteTo);
   }
+  //Thread safe as long as the same iWriteTo is not used concurrently
   int deserialize(char const * iBuffer, size_t iBufferSize, void* iWriteTo) const{
-    TBufferFile bufferFile{TBuffer::kRead};
-
+    auto& bufferFile = bufferFiles_.local();
     bufferFile.SetBuffer( const_cast<char*>(iBuffer), iBufferSize, kFALSE);
+    bufferFile.Reset();
 
     class_->ReadBuffer(bufferFile, iWriteTo);
     return bufferFile.Length();
   }
 
+  //ROOT streams the object as a whole so it can not be split
+  void setParallelChunkSize(std::size_t) {}
+  //ROOT decides how collections are refilled
+  void setRecycle(bool) {}
+
 private:
   TClass* class_;
+  //constructing a TBufferFile is costly compared to reading a small data product
+  // so each thread reuses its own
+  mutable tbb::enumerable_thread_specific<TBufferFile> bufferFiles_;
 };
 }
 #endif
@@ -0,0 +1,73 @@
+#include "EventArena.h"
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+using namespace cce::tf;
+
+namespace {
+  //TBuffer only tells the reallocation function the old address so the
+  // arena presently being written by this thread is kept here
+  thread_local EventArena* t_fillingArena = nullptr;
+
+  //guarantees TBuffer always gets more than its reserved extra space
+  constexpr std::size_t kMinSliceSize = 1024;
+}
+
+EventArena::EventArena(): buffer_{TBuffer::kWrite} {}
+
+std::size_t EventArena::append(std::size_t iNBytes) {
+  if(size_+iNBytes > capacity_) {
+    reserve(size_+iNBytes, size_);
+  }
+  auto offset = size_;
+  size_ += iNBytes;
+  return offset;
+}
+
+void EventArena::padTo(std::size_t iAlignment) {
+  auto const remainder = size_ % iAlignment;
+  if(remainder != 0) {
+    auto offset = append(iAlignment - remainder);
+    std::memset(storage_.get()+offset, 0, iAlignment - remainder);
+  }
+}
+
+TBufferFile& EventArena::beginSlice() {
+  assert(t_fillingArena == nullptr);
+  if(capacity_ - size_ < kMinSliceSize) {
+    reserve(size_+kMinSliceSize, size_);
+  }
+  t_fillingArena = this;
+  buffer_.SetBuffer(storage_.get()+size_, capacity_-size_, kFALSE, &EventArena::growSlice);
+  buffer_.Reset();
+  return buffer_;
+}
+
+std::size_t EventArena::endSlice() {
+  assert(t_fillingArena == this);
+  assert(buffer_.Buffer() == storage_.get()+size_);
+  t_fillingArena = nullptr;
+  std::size_t nBytes = buffer_.Length();
+  size_ += nBytes;
+  return nBytes;
+}
+
+void EventArena::reserve(std::size_t iCapacity, std::size_t iKeep) {
+  //grow geometrically so repeated small overflows stay cheap
+  auto newCapacity = std::max(iCapacity, 2*capacity_);
+  std::unique_ptr<char[]> newStorage{new char[newCapacity]};
+  if(iKeep != 0) {
+    std::memcpy(newStorage.get(), storage_.get(), iKeep);
+  }
+  storage_ = std::move(newStorage);
+  capacity_ = newCapacity;
+}
+
+char* EventArena::growSlice(char* iSlice, std::size_t iNewSize, std::size_t iOldSize) {
+  auto arena = t_fillingArena;
+  assert(arena != nullptr);
+  assert(iSlice == arena->storage_.get()+arena->size_);
+  arena->reserve(arena->size_+iNewSize, arena->size_+std::min(iOldSize, arena->capacity_-arena->size_));
+  return arena->storage_.get()+arena->size_;
+}
@@ -0,0 +1,63 @@
+#if !defined(EventArena_h)
+#define EventArena_h
+
+#include <memory>
+#include <cstddef>
+#include "TBufferFile.h"
+#include "Span.h"
+
+namespace cce::tf {
+  /*---------------------------------------
+  EventArena is a growable, uninitialized byte buffer which is reused from
+  event to event. Data products are serialized one after another directly
+  into the arena: beginSlice() hands out a TBufferFile whose storage is the
+  unused end of the arena and endSlice() appends what was written. If a
+  data product does not fit, the arena (including everything already
+  appended) is moved to larger storage while the TBufferFile is writing.
+
+  Offsets, not pointers, should be kept into the arena since appending
+  may move the storage.
+
+  An EventArena must only be filled by one thread at a time.
+  ---------------------------------------*/
+  class EventArena {
+  public:
+    EventArena();
+
+    EventArena(EventArena const&) = delete;
+    EventArena& operator=(EventArena const&) = delete;
+
+    //start a new event, the storage is kept
+    void clear() { size_ = 0;}
+
+    //append iNBytes uninitialized bytes and return their offset
+    std::size_t append(std::size_t iNBytes);
+
+    //append zeros until the size is a multiple of iAlignment
+    void padTo(std::size_t iAlignment);
+
+    //the returned buffer writes to the end of the arena until endSlice is called
+    TBufferFile& beginSlice();
+    //returns the number of bytes written since beginSlice
+    std::size_t endSlice();
+
+    char* data() { return storage_.get(); }
+    char const* data() const { return storage_.get(); }
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
+    Span<char const> span() const { return Span<char const>(storage_.get(), size_); }
+
+  private:
+    //iKeep is the number of bytes of the old storage to move to the new storage
+    void reserve(std::size_t iCapacity, std::size_t iKeep);
+
+    //signature of ReAllocCharFun_t used by TBuffer when it needs more space
+    static char* growSlice(char* iSlice, std::size_t iNewSize, std::size_t iOldSize);
+
+    std::unique_ptr<char[]> storage_;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+    TBufferFile buffer_;
+  };
+}
+#endif
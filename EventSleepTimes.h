@@ -0,0 +1,38 @@
+#if !defined(EventSleepTimes_h)
+#define EventSleepTimes_h
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include "ConfigurationParameters.h"
+
+namespace cce::tf {
+  //Reads the time, in microseconds, to wait for each event from the file given by the 'filename'
+  // parameter. Returns nullopt, after saying why, if no file is given or it holds no times.
+  inline std::optional<std::vector<double>> readEventSleepTimes(ConfigurationParameters const& params, char const* iWaiterName) {
+    auto filename = params.get<std::string>("filename");
+    if(not filename) {
+      std::cout <<"no file name give for "<<iWaiterName<<std::endl;
+      return std::nullopt;
+    }
+
+    std::ifstream file(*filename);
+    if(not file.is_open()) {
+      std::cout <<"unable to open file "<<*filename<<" with sleep times"<<std::endl;
+      return std::nullopt;
+    }
+    double value;
+    std::vector<double> sleepTimes;
+    while(file >> value) {
+      sleepTimes.push_back(value);
+    }
+    if(sleepTimes.empty()) {
+      std::cout <<"file "<<*filename<<" contained no event times"<<std::endl;
+      return std::nullopt;
+    }
+    return sleepTimes;
+  }
+}
+#endif
@@ -1,6 +1,5 @@
 
 #include <vector>
-#include <fstream>
 #include <thread>
 #include <iostream>
 #include "EventIdentifier.h"
@@ -8,6 +7,7 @@
 #include "TaskHolder.h"
 #include "WaiterBase.h"
 #include "WaiterFactory.h"
+#include "EventSleepTimes.h"
 
 
 namespace cce::tf {
@@ -44,30 +44,15 @@ namespace {
   public:
     Maker(): WaiterMakerBase("EventSleepWaiter") {}
 
-    std::unique_ptr<WaiterBase> create(unsigned int iNLanes, std::size_t iNDataProducts, ConfigurationParameters const& params) const final {
+    std::unique_ptr<WaiterBase> create(unsigned int iNLanes, std::vector<DataProductRetriever> const& iDataProducts, ConfigurationParameters const& params) const final {
+      auto const nDataProducts = iDataProducts.size();
 
-      auto filename = params.get<std::string>("filename");
-      if(not filename) {
-        std::cout <<"no file name give for EventSleepWaiter"<<std::endl;
+      auto sleepTimes = readEventSleepTimes(params, "EventSleepWaiter");
+      if(not sleepTimes) {
         return {};
       }
 
-      std::ifstream file(*filename);
-      if(not file.is_open()) {
-        std::cout <<"unable to open file "<<*filename<<" with sleep times";
-        return {};
-      }
-      double value;
-      std::vector<double> sleepTimes;
-      while(file >> value) {
-        sleepTimes.push_back(value);
-      }
-      if(sleepTimes.empty()) {
-        std::cout <<"file "<<*filename<<" contained no event times"<<std::endl;
-        return {};
-      }
-
-      return std::make_unique<EventSleepWaiter>(std::move(sleepTimes), iNDataProducts);
+      return std::make_unique<EventSleepWaiter>(std::move(*sleepTimes), nDataProducts);
     }
     
   };
@@ -1,6 +1,5 @@
 
 #include <vector>
-#include <fstream>
 #include <thread>
 #include <iostream>
 #include "EventIdentifier.h"
@@ -8,6 +7,7 @@
 #include "TaskHolder.h"
 #include "WaiterBase.h"
 #include "WaiterFactory.h"
+#include "EventSleepTimes.h"
 
 
 namespace cce::tf {
@@ -48,40 +48,28 @@ namespace {
   public:
     Maker(): WaiterMakerBase("EventUnevenSleepWaiter") {}
 
-    std::unique_ptr<WaiterBase> create(unsigned int iNLanes, std::size_t iNDataProducts, ConfigurationParameters const& params) const final {
+    std::unique_ptr<WaiterBase> create(unsigned int iNLanes, std::vector<DataProductRetriever> const& iDataProducts, ConfigurationParameters const& params) const final {
+      auto const nDataProducts = iDataProducts.size();
       auto scale = params.get<float>("scale", 1.);
 
-      auto filename = params.get<std::string>("filename");
-      if(not filename) {
-        std::cout <<"no file name give for EventUnevenSleepWaiter"<<std::endl;
+      auto sleepTimes = readEventSleepTimes(params, "EventUnevenSleepWaiter");
+      if(not sleepTimes) {
         return {};
       }
-
-      std::ifstream file(*filename);
-      if(not file.is_open()) {
-        std::cout <<"unable to open file "<<*filename<<" with sleep times";
-        return {};
-      }
-      double value;
-      std::vector<double> sleepTimes;
-      while(file >> value) {
-        sleepTimes.push_back(value*scale);
-      }
-      if(sleepTimes.empty()) {
-        std::cout <<"file "<<*filename<<" contained no event times"<<std::endl;
-        return {};
+      for(auto& time: *sleepTimes) {
+        time *= scale;
       }
 
       int divideBetween = params.get<int>("divideBetween",0);
       if(0 == divideBetween) {
-        divideBetween = iNDataProducts;
+        divideBetween = nDataProducts;
       }
-      if(divideBetween > iNDataProducts) {
-        std::cout <<"value of 'divideBetween' "<<divideBetween<<" is greater than number of products "<<iNDataProducts<<std::endl;
+      if(divideBetween > nDataProducts) {
+        std::cout <<"value of 'divideBetween' "<<divideBetween<<" is greater than number of products "<<nDataProducts<<std::endl;
         return {};
       }     
 
-      return std::make_unique<EventUnevenSleepWaiter>(std::move(sleepTimes), divideBetween, iNDataProducts);
+      return std::make_unique<EventUnevenSleepWaiter>(std::move(*sleepTimes), divideBetween, nDataProducts);
     }
     
   };
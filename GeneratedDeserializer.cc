@@ -0,0 +1,34 @@
+#include "GeneratedDeserializer.h"
+#include "UnrolledSerializer.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace cce::tf;
+
+GeneratedDeserializer::GeneratedDeserializer(TClass* iClass):
+  class_{iClass}, entry_{generated::find(iClass)}, unrolled_{iClass} {}
+
+int GeneratedDeserializer::check(int nBytesRead, char const* iBuffer, size_t iBufferSize, void* iWriteTo) const {
+  std::lock_guard<std::mutex> guard(checkMutex_);
+  if(checked_) {
+    //another thread did the check while this one was reading
+    if(not entry_.load()) {
+      return unrolled_.deserialize(iBuffer, iBufferSize, iWriteTo);
+    }
+    return nBytesRead;
+  }
+
+  UnrolledSerializer serializer{class_};
+  auto written = serializer.serialize(iWriteTo);
+  //PDS passes the data product padded to a whole number of words so iBuffer can extend beyond what was read
+  if(nBytesRead < 0 or static_cast<std::size_t>(nBytesRead) > iBufferSize or
+     written.size() != static_cast<std::size_t>(nBytesRead) or
+     not std::equal(written.begin(), written.end(), iBuffer)) {
+    std::cout <<"generated deserializer for "<<class_->GetName()<<" does not match the unrolled deserializer, using unrolled instead"<<std::endl;
+    entry_ = nullptr;
+    checked_ = true;
+    return unrolled_.deserialize(iBuffer, iBufferSize, iWriteTo);
+  }
+  checked_ = true;
+  return nBytesRead;
+}
@@ -0,0 +1,73 @@
+#if !defined(GeneratedDeserializer_h)
+#define GeneratedDeserializer_h
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include "TBufferFile.h"
+#include "TClass.h"
+#include "GeneratedSerializers.h"
+#include "UnrolledDeserializer.h"
+#include "tbb/enumerable_thread_specific.h"
+
+namespace cce::tf {
+  /*---------------------------------------
+  GeneratedDeserializer reads data written by either GeneratedSerializer or
+  UnrolledSerializer. It uses the functions written by generate_serializers
+  for the class if they exist, otherwise it uses UnrolledDeserializer.
+  The first object read is written back out and compared to the input; if
+  they differ the object is read again by UnrolledDeserializer and the
+  generated code is no longer used.
+  The check is serialized so one instance can be shared by all threads.
+  ---------------------------------------*/
+class GeneratedDeserializer {
+public:
+  GeneratedDeserializer(TClass*);
+
+  GeneratedDeserializer(GeneratedDeserializer&& iOther):
+    class_{iOther.class_}, entry_{iOther.entry_.load()}, unrolled_(std::move(iOther.unrolled_)),
+    checked_{iOther.checked_.load()}, recycle_{iOther.recycle_} {}
+
+  GeneratedDeserializer(GeneratedDeserializer const& ) = delete;
+
+  int deserialize(std::vector<char> const& iBuffer, void* iWriteTo) const {
+    return deserialize(&iBuffer.front(), iBuffer.size(), iWriteTo);
+  }
+  //Thread safe as long as the same iWriteTo is not used concurrently
+  int deserialize(char const * iBuffer, size_t iBufferSize, void* iWriteTo) const {
+    auto entry = entry_.load();
+    if(not entry) {
+      return unrolled_.deserialize(iBuffer, iBufferSize, iWriteTo);
+    }
+    auto& bufferFile = bufferFiles_.local();
+    bufferFile.SetBuffer( const_cast<char*>(iBuffer), iBufferSize, kFALSE);
+    bufferFile.Reset();
+    entry->read_(bufferFile, static_cast<char*>(iWriteTo), recycle_);
+    if(not checked_) {
+      return check(bufferFile.Length(), iBuffer, iBufferSize, iWriteTo);
+    }
+    return bufferFile.Length();
+  }
+
+  bool usesGeneratedCode() const { return entry_.load() != nullptr;}
+
+  //only used when falling back to the unrolled code
+  void setParallelChunkSize(std::size_t iBytes) { unrolled_.setParallelChunkSize(iBytes); }
+
+  //if true, std::vectors are resized without first clearing them so their elements are reused
+  void setRecycle(bool iRecycle) { recycle_ = iRecycle; }
+
+private:
+  int check(int iBytesRead, char const* iBuffer, size_t iBufferSize, void* iWriteTo) const;
+
+  TClass* class_;
+  mutable std::atomic<generated::Entry const*> entry_;
+  UnrolledDeserializer unrolled_;
+  //constructing a TBufferFile is costly compared to reading a small data product
+  mutable tbb::enumerable_thread_specific<TBufferFile> bufferFiles_{TBuffer::kRead};
+  mutable std::atomic<bool> checked_{false};
+  mutable std::mutex checkMutex_;
+  bool recycle_ = false;
+};
+}
+#endif
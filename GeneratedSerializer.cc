@@ -0,0 +1,21 @@
+#include "GeneratedSerializer.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace cce::tf;
+
+GeneratedSerializer::GeneratedSerializer(TClass* iClass):
+  class_{iClass}, entry_{generated::find(iClass)}, unrolled_{iClass}, bufferFile_{TBuffer::kWrite} {}
+
+void GeneratedSerializer::check(void const* address) {
+  checked_ = true;
+  auto unrolled = unrolled_.serialize(address);
+
+  bufferFile_.Reset();
+  entry_->write_(bufferFile_, static_cast<char const*>(address));
+  if(unrolled.size() != static_cast<std::size_t>(bufferFile_.Length()) or
+     not std::equal(unrolled.begin(), unrolled.end(), bufferFile_.Buffer())) {
+    std::cout <<"generated serializer for "<<class_->GetName()<<" does not match the unrolled serializer, using unrolled instead"<<std::endl;
+    entry_ = nullptr;
+  }
+}
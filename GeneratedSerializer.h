@@ -0,0 +1,69 @@
+#if !defined(GeneratedSerializer_h)
+#define GeneratedSerializer_h
+
+#include "TBufferFile.h"
+#include "TClass.h"
+#include "GeneratedSerializers.h"
+#include "UnrolledSerializer.h"
+#include "Span.h"
+
+namespace cce::tf {
+  /*---------------------------------------
+  GeneratedSerializer uses the functions written by generate_serializers
+  for the class if they exist, otherwise it uses UnrolledSerializer. Both
+  write the same bytes. As a safe guard, the first object serialized is
+  also serialized by UnrolledSerializer and if the results differ the
+  generated code is no longer used.
+  ---------------------------------------*/
+class GeneratedSerializer {
+public:
+  GeneratedSerializer(TClass*);
+
+  GeneratedSerializer(GeneratedSerializer&& iOther):
+    class_{iOther.class_}, entry_{iOther.entry_}, unrolled_(std::move(iOther.unrolled_)),
+    bufferFile_{TBuffer::kWrite}, checked_{iOther.checked_} {}
+
+  GeneratedSerializer(GeneratedSerializer const& ) = delete;
+
+  //The returned Span refers to the internal buffer which is reused by the next call
+  Span<char const> serialize(void const* address) {
+    if(not entry_) {
+      return unrolled_.serialize(address);
+    }
+    if(not checked_) {
+      check(address);
+    }
+    bufferFile_.Reset();
+    entry_->write_(bufferFile_, static_cast<char const*>(address));
+    return Span<char const>(bufferFile_.Buffer(), bufferFile_.Length());
+  }
+
+  //writes to the end of iBuffer rather than to the internal buffer
+  void serialize(void const* address, TBufferFile& iBuffer) {
+    if(entry_ and not checked_) {
+      check(address);
+    }
+    if(not entry_) {
+      unrolled_.serialize(address, iBuffer);
+      return;
+    }
+    entry_->write_(iBuffer, static_cast<char const*>(address));
+  }
+
+  bool usesGeneratedCode() const { return entry_ != nullptr;}
+
+  //only used when falling back to the unrolled code
+  void setParallelChunkSize(std::size_t iBytes) { unrolled_.setParallelChunkSize(iBytes); }
+
+private:
+  //compares the generated output to the unrolled output
+  void check(void const* address);
+
+  TClass* class_;
+  generated::Entry const* entry_;
+  UnrolledSerializer unrolled_;
+  TBufferFile bufferFile_;
+  bool checked_ = false;
+};
+}
+#endif
@@ -0,0 +1,61 @@
+#if !defined(GeneratedSerializerWrapper_h)
+#define GeneratedSerializerWrapper_h
+
+#include <vector>
+#include <chrono>
+#include "TClass.h"
+
+#include "tbb/task_group.h"
+#include "GeneratedSerializer.h"
+#include "TaskHolder.h"
+#include "Span.h"
+#include "EventArena.h"
+
+namespace cce::tf {
+class GeneratedSerializerWrapper {
+public:
+ GeneratedSerializerWrapper(std::string_view iName,  TClass* tClass):
+  name_{iName}, class_(tClass), serializer_{tClass},
+  accumulatedTime_{std::chrono::microseconds::zero()} {}
+
+  void doWorkAsync(tbb::task_group& iGroup, void** iAddress, TaskHolder iCallback) {
+    iGroup.run([this, iAddress, callback=std::move(iCallback)] () {
+	{
+          //gDebug=3;
+	  auto start = std::chrono::high_resolution_clock::now();
+	  blob_ = serializer_.serialize(*iAddress);
+          //gDebug=0;
+	  accumulatedTime_ += std::chrono::duration_cast<decltype(accumulatedTime_)>(std::chrono::high_resolution_clock::now() - start);
+	}
+	const_cast<TaskHolder&>(callback).doneWaiting();
+      });
+  }
+  //Synchronously appends the serialized data product to iArena and returns the number of bytes
+  // written. blob() is left empty as the arena may move while more data products are appended.
+  std::size_t serialize(void** iAddress, EventArena& iArena) {
+    auto start = std::chrono::high_resolution_clock::now();
+    serializer_.serialize(*iAddress, iArena.beginSlice());
+    auto nBytes = iArena.endSlice();
+    blob_ = {};
+    accumulatedTime_ += std::chrono::duration_cast<decltype(accumulatedTime_)>(std::chrono::high_resolution_clock::now() - start);
+    return nBytes;
+  }
+
+  //see UnrolledSerializer::setParallelChunkSize
+  void setParallelChunkSize(std::size_t iBytes) { serializer_.setParallelChunkSize(iBytes); }
+
+  //only valid until the next call to doWorkAsync
+  Span<char const> blob() const {return blob_;}
+
+  std::string_view  name() const {return name_;}
+  char const* className() const { return class_->GetName(); }
+  std::chrono::microseconds accumulatedTime() const { return accumulatedTime_;}
+private:
+  Span<char const> blob_;
+  std::string_view name_;
+  TClass const* class_;
+  GeneratedSerializer serializer_;
+  std::chrono::microseconds accumulatedTime_;
+};
+}
+#endif
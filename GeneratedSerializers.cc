@@ -0,0 +1,25 @@
+#include "GeneratedSerializers.h"
+#include "TClass.h"
+#include <unordered_map>
+
+namespace cce::tf::generated {
+  Entry const* find(TClass const* iClass) {
+    //compare TClass pointers since ROOT may spell the same class name differently
+    static std::unordered_map<TClass const*, Entry const*> const s_classToEntry = []() {
+      std::unordered_map<TClass const*, Entry const*> classToEntry;
+      for(auto const& e: entries()) {
+        auto cls = TClass::GetClass(e.className_);
+        if(cls) {
+          classToEntry.emplace(cls, &e);
+        }
+      }
+      return classToEntry;
+    }();
+
+    auto itFound = s_classToEntry.find(iClass);
+    if(itFound == s_classToEntry.end()) {
+      return nullptr;
+    }
+    return itFound->second;
+  }
+}
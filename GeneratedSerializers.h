@@ -0,0 +1,27 @@
+#if !defined(GeneratedSerializers_h)
+#define GeneratedSerializers_h
+
+#include "Span.h"
+
+class TBufferFile;
+class TClass;
+
+namespace cce::tf::generated {
+  //functions written by generate_serializers
+  using WriteFunction = void(*)(TBufferFile&, char const*);
+  //the bool is true if std::vectors should be resized without clearing them first
+  using ReadFunction = void(*)(TBufferFile&, char*, bool);
+
+  struct Entry {
+    char const* className_;
+    WriteFunction write_;
+    ReadFunction read_;
+  };
+
+  //defined in the file written by generate_serializers
+  Span<Entry const> entries();
+
+  //returns nullptr if no code was generated for iClass
+  Entry const* find(TClass const* iClass);
+}
+#endif
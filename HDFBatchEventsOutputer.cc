@@ -1,7 +1,10 @@
 #include "HDFBatchEventsOutputer.h"
 #include "OutputerFactory.h"
 #include "ConfigurationParameters.h"
+#include "CompressionConfig.h"
 #include "UnrolledSerializerWrapper.h"
+#include "GeneratedSerializerWrapper.h"
+#include "NativeSerializerWrapper.h"
 #include "SerializerWrapper.h"
 #include "summarize_serializers.h"
 #include "FunctorTask.h"
@@ -24,6 +27,7 @@ namespace {
   constexpr const char* const COMPRESSION_ANAME="Compression";
   constexpr const char* const COMPRESSION_LEVEL_ANAME="CompressionLevel";
   constexpr const char* const COMPRESSION_CHOICE_ANAME="CompressionChoice";
+  constexpr const char* const COMPRESSION_BLOCK_SIZE_ANAME="CompressionBlockSize";
   template <typename T> 
   void 
   write_ds(hid_t gid, 
@@ -49,7 +53,7 @@ namespace {
   }
 }
 
-HDFBatchEventsOutputer::HDFBatchEventsOutputer(std::string const& iFileName, unsigned int iNLanes, int iChunkSize, pds::Compression iCompression, int iCompressionLevel, CompressionChoice iChoice, pds::Serialization iSerialization, uint32_t iBatchSize) : 
+HDFBatchEventsOutputer::HDFBatchEventsOutputer(std::string const& iFileName, unsigned int iNLanes, int iChunkSize, pds::Compression iCompression, int iCompressionLevel, pds::ZSTDParameters const& iZSTDParameters, CompressionChoice iChoice, pds::Serialization iSerialization, uint32_t iBatchSize, uint32_t iCompressionBlockSize) : 
   file_(hdf5::File::create(iFileName.c_str())),
   group_(hdf5::Group::create(file_, GNAME)),
   chunkSize_{iChunkSize},
@@ -58,8 +62,10 @@ HDFBatchEventsOutputer::HDFBatchEventsOutputer(std::string const& iFileName, uns
   waitingEventsInBatch_(iNLanes),
   presentEventEntry_(0),
   batchSize_(iBatchSize),
+  compressionBlockSize_(iCompressionBlockSize),
   compression_{iCompression},
   compressionLevel_{iCompressionLevel},
+  zstdParameters_{iZSTDParameters},
   compressionChoice_{iChoice},
   serialization_{iSerialization},
   serialTime_{std::chrono::microseconds::zero()},
@@ -82,6 +88,13 @@ void HDFBatchEventsOutputer::setupForLane(unsigned int iLaneIndex, std::vector<D
     {   s = SerializeStrategy::make<SerializeProxy<SerializerWrapper>>(); break; }
   case pds::Serialization::kRootUnrolled:
     {   s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>(); break; }
+  case pds::Serialization::kGenerated:
+    {   s = SerializeStrategy::make<SerializeProxy<GeneratedSerializerWrapper>>(); break; }
+  case pds::Serialization::kNative:
+    {   s = SerializeStrategy::make<SerializeProxy<NativeSerializerWrapper>>(); break; }
+  }
+  if(iLaneIndex == 0) {
+    serializerSetupTime_ = prepareSharedSerializers(serialization_, iDPs);
   }
   s.reserve(iDPs.size());
   for(auto const& dp: iDPs) {
@@ -152,7 +165,8 @@ void HDFBatchEventsOutputer::printSummary() const  {
   auto writeTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
 
   std::cout <<"HDFBatchEventsOutputer\n  total serial time at end event: "<<serialTime_.count()<<"us\n"
-    "  total parallel time at end event: "<<parallelTime_.load()<<"us\n";
+    "  total parallel time at end event: "<<parallelTime_.load()<<"us\n"
+    "  serializer setup time: "<<serializerSetupTime_.count()<<"us\n";
   std::cout << "  end of job file write time: "<<writeTime.count()<<"us\n";
 
   summarize_serializers(serializers_);
@@ -195,7 +209,11 @@ void HDFBatchEventsOutputer::finishBatchAsync(unsigned int iBatchIndex, TaskHold
 
   std::vector<char> bufferToWrite;
   if(compressionChoice_ == CompressionChoice::kBatch or compressionChoice_ == CompressionChoice::kBoth) {
-    bufferToWrite  = pds::compressBuffer(0,0, compression_, compressionLevel_, batchBlob);
+    if(compressionBlockSize_ != 0) {
+      bufferToWrite = pds::compressBufferInBlocks(compression_, compressionLevel_, batchBlob, compressionBlockSize_, zstdParameters_);
+    } else {
+      bufferToWrite  = pds::compressBuffer(0,0, compression_, compressionLevel_, std::move(batchBlob), zstdParameters_);
+    }
     batchBlob = std::vector<char>();
   } else {
     bufferToWrite = std::move(batchBlob);
@@ -228,6 +246,8 @@ HDFBatchEventsOutputer::output(std::vector<EventIdentifier> iEventIDs,
     level.write(compressionLevel_); 
     auto choice = hdf5::Attribute::open(group_, COMPRESSION_CHOICE_ANAME);
     choice.write(static_cast<int>(compressionChoice_)); 
+    auto blockSize = hdf5::Attribute::open(group_, COMPRESSION_BLOCK_SIZE_ANAME);
+    blockSize.write(compressionBlockSize_);
   }
   std::vector<unsigned long long> ids;
   ids.reserve(iEventIDs.size());
@@ -257,6 +277,7 @@ HDFBatchEventsOutputer::writeFileHeader(SerializeStrategy const& iSerializers) {
   hdf5::Attribute::create<int>(group_, LUMISEC_ANAME, scalar_space);
   hdf5::Attribute::create<int>(group_, COMPRESSION_LEVEL_ANAME, scalar_space);
   hdf5::Attribute::create<int>(group_, COMPRESSION_CHOICE_ANAME, scalar_space);
+  hdf5::Attribute::create<unsigned int>(group_, COMPRESSION_BLOCK_SIZE_ANAME, scalar_space);
   constexpr hsize_t     str_dims[ndims] = {10};
   auto const attr_type = H5Tcopy (H5T_C_S1);
   H5Tset_size(attr_type, H5T_VARIABLE);
@@ -295,7 +316,7 @@ std::pair<std::vector<uint32_t>, std::vector<char>> HDFBatchEventsOutputer::writ
   }
 
   if(compressionChoice_ == CompressionChoice::kEvents or compressionChoice_ == CompressionChoice::kBoth) {
-    auto cBuffer  = pds::compressBuffer(0,0, compression_, compressionLevel_, buffer);
+    auto cBuffer  = pds::compressBuffer(0,0, compression_, compressionLevel_, std::move(buffer), zstdParameters_);
 
     return {std::move(offsets), std::move(cBuffer)};
   }
@@ -316,6 +337,10 @@ namespace {
 
       auto chunkSize = params.get<int>("hdfchunkSize", 10485760);
       int compressionLevel = params.get<int>("compressionLevel", 18);
+      auto zstdParameters = parseZSTDParameters(params);
+      if(not zstdParameters) {
+        return {};
+      }
       auto compressionName = params.get<std::string>("compressionAlgorithm", "ZSTD");
       auto compression = pds::toCompression(compressionName);
       if(not compression) {
@@ -343,8 +368,12 @@ namespace {
       }
 
       auto batchSize = params.get<int>("batchSize",1);
+      auto compressionBlockSize = parseCompressionBlockSize(params);
+      if(not compressionBlockSize) {
+        return {};
+      }
 
-      return std::make_unique<HDFBatchEventsOutputer>(*fileName, iNLanes, chunkSize, *compression, compressionLevel, compressionChoice, *serialization, batchSize);
+      return std::make_unique<HDFBatchEventsOutputer>(*fileName, iNLanes, chunkSize, *compression, compressionLevel, *zstdParameters, compressionChoice, *serialization, batchSize, *compressionBlockSize);
     }
   };
 
@@ -29,7 +29,7 @@ namespace cce::tf {
         kBoth
     };
 
-    HDFBatchEventsOutputer(std::string const& iFileName, unsigned int iNLanes, int iChunkSize, pds::Compression iCompression, int iCompressionLevel, CompressionChoice iChoice, pds::Serialization iSerialization, uint32_t iBatchSize);
+    HDFBatchEventsOutputer(std::string const& iFileName, unsigned int iNLanes, int iChunkSize, pds::Compression iCompression, int iCompressionLevel, pds::ZSTDParameters const& iZSTDParameters, CompressionChoice iChoice, pds::Serialization iSerialization, uint32_t iBatchSize, uint32_t iCompressionBlockSize);
     HDFBatchEventsOutputer(HDFBatchEventsOutputer&&) = default;
     HDFBatchEventsOutputer(HDFBatchEventsOutputer const&) = default;
 
@@ -65,11 +65,16 @@ private:
   mutable std::atomic<uint64_t> presentEventEntry_;
 
   uint32_t batchSize_;
+  //if not 0, the batch is compressed as independent blocks of this many bytes using multiple tasks
+  uint32_t compressionBlockSize_;
   bool firstEvent_ = true;
   pds::Compression compression_;
   int compressionLevel_;
+  pds::ZSTDParameters zstdParameters_;
   CompressionChoice compressionChoice_;
   pds::Serialization serialization_;
+  //time spent building what the serializers of all lanes share
+  std::chrono::microseconds serializerSetupTime_ = std::chrono::microseconds::zero();
   mutable std::chrono::microseconds serialTime_;
   mutable std::atomic<std::chrono::microseconds::rep> parallelTime_;
   };    
@@ -1,7 +1,10 @@
 #include "HDFEventOutputer.h"
 #include "OutputerFactory.h"
 #include "ConfigurationParameters.h"
+#include "CompressionConfig.h"
 #include "UnrolledSerializerWrapper.h"
+#include "GeneratedSerializerWrapper.h"
+#include "NativeSerializerWrapper.h"
 #include "SerializerWrapper.h"
 #include "summarize_serializers.h"
 #include "lz4.h"
@@ -44,13 +47,14 @@ namespace {
   }
 }
 
-HDFEventOutputer::HDFEventOutputer(std::string const& iFileName, unsigned int iNLanes, int iChunkSize, pds::Compression iCompression, int iCompressionLevel, pds::Serialization iSerialization) : 
+HDFEventOutputer::HDFEventOutputer(std::string const& iFileName, unsigned int iNLanes, int iChunkSize, pds::Compression iCompression, int iCompressionLevel, pds::ZSTDParameters const& iZSTDParameters, pds::Serialization iSerialization) : 
   file_(hdf5::File::create(iFileName.c_str())),
   group_(hdf5::Group::create(file_, GNAME)),
   chunkSize_{iChunkSize},
   serializers_{std::size_t(iNLanes)},
   compression_{iCompression},
   compressionLevel_{iCompressionLevel},
+  zstdParameters_{iZSTDParameters},
   serialization_{iSerialization},
   serialTime_{std::chrono::microseconds::zero()},
   parallelTime_{0}
@@ -64,6 +68,13 @@ void HDFEventOutputer::setupForLane(unsigned int iLaneIndex, std::vector<DataPro
     {   s = SerializeStrategy::make<SerializeProxy<SerializerWrapper>>(); break; }
   case pds::Serialization::kRootUnrolled:
     {   s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>(); break; }
+  case pds::Serialization::kGenerated:
+    {   s = SerializeStrategy::make<SerializeProxy<GeneratedSerializerWrapper>>(); break; }
+  case pds::Serialization::kNative:
+    {   s = SerializeStrategy::make<SerializeProxy<NativeSerializerWrapper>>(); break; }
+  }
+  if(iLaneIndex == 0) {
+    serializerSetupTime_ = prepareSharedSerializers(serialization_, iDPs);
   }
   s.reserve(iDPs.size());
   offsetsAndBlob_.first.resize(iDPs.size()+1, 0);
@@ -96,7 +107,8 @@ void HDFEventOutputer::outputAsync(unsigned int iLaneIndex, EventIdentifier cons
 
 void HDFEventOutputer::printSummary() const  {
   std::cout <<"HDFEventOutputer\n  total serial time at end event: "<<serialTime_.count()<<"us\n"
-    "  total parallel time at end event: "<<parallelTime_.load()<<"us\n";
+    "  total parallel time at end event: "<<parallelTime_.load()<<"us\n"
+    "  serializer setup time: "<<serializerSetupTime_.count()<<"us\n";
   summarize_serializers(serializers_);
 }
 
@@ -178,9 +190,9 @@ std::pair<std::vector<uint32_t>, std::vector<char>> HDFEventOutputer::writeDataP
     assert(buffer.size() == offsets[index]);
   }
 
-  auto cBuffer  = pds::compressBuffer(0,0, compression_, compressionLevel_, buffer);
+  auto cBuffer  = pds::compressBuffer(0,0, compression_, compressionLevel_, std::move(buffer), zstdParameters_);
 
-  return {offsets, cBuffer};
+  return {std::move(offsets), std::move(cBuffer)};
 }
 namespace {
   class HDFEventMaker : public OutputerMakerBase {
@@ -196,6 +208,10 @@ namespace {
 
       auto chunkSize = params.get<int>("hdfchunkSize", 128);
       int compressionLevel = params.get<int>("compressionLevel", 18);
+      auto zstdParameters = parseZSTDParameters(params);
+      if(not zstdParameters) {
+        return {};
+      }
       auto compressionName = params.get<std::string>("compressionAlgorithm", "ZSTD");
       auto compression = pds::toCompression(compressionName);
       if(not compression) {
@@ -209,7 +225,7 @@ namespace {
         return {};
       }
 
-      return std::make_unique<HDFEventOutputer>(*fileName, iNLanes, chunkSize, *compression, compressionLevel, *serialization);
+      return std::make_unique<HDFEventOutputer>(*fileName, iNLanes, chunkSize, *compression, compressionLevel, *zstdParameters, *serialization);
     }
   };
 
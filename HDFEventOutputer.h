@@ -22,7 +22,7 @@
 namespace cce::tf {
   class HDFEventOutputer : public OutputerBase {
     public:
-    HDFEventOutputer(std::string const& iFileName, unsigned int iNLanes, int iChunkSize, pds::Compression iCompression, int iCompressionLevel, pds::Serialization iSerialization);
+    HDFEventOutputer(std::string const& iFileName, unsigned int iNLanes, int iChunkSize, pds::Compression iCompression, int iCompressionLevel, pds::ZSTDParameters const& iZSTDParameters, pds::Serialization iSerialization);
     HDFEventOutputer(HDFEventOutputer&&) = default;
     HDFEventOutputer(HDFEventOutputer const&) = default;
 
@@ -50,7 +50,10 @@ private:
   bool firstEvent_ = true;
   pds::Compression compression_;
   int compressionLevel_;
+  pds::ZSTDParameters zstdParameters_;
   pds::Serialization serialization_;
+  //time spent building what the serializers of all lanes share
+  std::chrono::microseconds serializerSetupTime_ = std::chrono::microseconds::zero();
   mutable std::chrono::microseconds serialTime_;
   mutable std::atomic<std::chrono::microseconds::rep> parallelTime_;
   };    
@@ -140,7 +140,7 @@ HDFOutputer::output(EventIdentifier const& iEventID,
   }
   // accumulate events before writing, go through all the data products in the curret event
   for(auto& s: iSerializers) 
-     products_.push_back(s.blob());
+     products_.emplace_back(s.blob().begin(), s.blob().end());
   events_.push_back(iEventID.event);
 
   ++batch_;
@@ -0,0 +1,23 @@
+#include "NativeDeserializer.h"
+
+using namespace cce::tf;
+
+NativeDeserializer::NativeDeserializer(TClass* iClass):
+  layout_{native::buildLayout(*iClass)} {
+  if(layout_.m_kind == native::Kind::kUnrolled) {
+    unrolled_ = std::make_unique<UnrolledDeserializer>(iClass);
+  }
+}
+
+NativeDeserializer::ThreadState::ThreadState(TVirtualCollectionProxy* iProxy):
+  bufferFile_{TBuffer::kRead},
+  collProxy_{iProxy ? iProxy->Generate() : nullptr} {}
+
+NativeDeserializer::ThreadState& NativeDeserializer::threadState() const {
+  auto& state = threadStates_.local();
+  if(not state) {
+    std::lock_guard<std::mutex> guard(copyProxyMutex_);
+    state = std::make_unique<ThreadState>(layout_.m_collProxy.get());
+  }
+  return *state;
+}
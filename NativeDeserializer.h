@@ -0,0 +1,90 @@
+#if !defined(NativeDeserializer_h)
+#define NativeDeserializer_h
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstring>
+#include "TBufferFile.h"
+#include "TClass.h"
+#include "common_native.h"
+#include "UnrolledDeserializer.h"
+#include "parallel_chunks.h"
+#include "tbb/enumerable_thread_specific.h"
+
+namespace cce::tf {
+  //reads data written by NativeSerializer
+class NativeDeserializer {
+public:
+  NativeDeserializer(TClass*);
+
+  NativeDeserializer(NativeDeserializer&& iOther):
+    layout_(std::move(iOther.layout_)), unrolled_(std::move(iOther.unrolled_)),
+    parallelChunkSize_{iOther.parallelChunkSize_} {}
+
+  NativeDeserializer(NativeDeserializer const& ) = delete;
+
+  int deserialize(std::vector<char> const& iBuffer, void* iWriteTo) const {
+    return deserialize(&iBuffer.front(), iBuffer.size(), iWriteTo);
+  }
+  //Thread safe as long as the same iWriteTo is not used concurrently
+  int deserialize(char const * iBuffer, size_t iBufferSize, void* iWriteTo) const {
+    if(unrolled_) {
+      return unrolled_->deserialize(iBuffer, iBufferSize, iWriteTo);
+    }
+    auto& state = threadState();
+    auto& bufferFile = state.bufferFile_;
+    bufferFile.SetBuffer( const_cast<char*>(iBuffer), iBufferSize, kFALSE);
+    bufferFile.Reset();
+
+    if(layout_.m_kind == native::Kind::kObject) {
+      bufferFile.ReadBuf(iWriteTo, layout_.m_size);
+    } else {
+      Int_t size;
+      bufferFile.ReadBuf(&size, sizeof(size));
+      auto collProxy = state.collProxy_.get();
+      TVirtualCollectionProxy::TPushPop helper(collProxy, iWriteTo);
+      collProxy->Allocate(size, true);
+      std::size_t const nBytes = size*layout_.m_size;
+      if(size != 0 and bufferFile.Length()+nBytes <= static_cast<std::size_t>(bufferFile.BufferSize())) {
+        auto to = static_cast<char*>(collProxy->At(0));
+        char const* from = bufferFile.Buffer()+bufferFile.Length();
+        forEachChunk(nBytes, 1, parallelChunkSize_, [to, from](std::size_t iBegin, std::size_t iEnd) {
+            std::memcpy(to+iBegin, from+iBegin, iEnd-iBegin);
+          });
+        bufferFile.SetBufferOffset(bufferFile.Length()+nBytes);
+      }
+    }
+    return bufferFile.Length();
+  }
+
+  //collections taking more than iBytes are copied using multiple tasks. 0 turns this off.
+  void setParallelChunkSize(std::size_t iBytes) {
+    parallelChunkSize_ = iBytes;
+    if(unrolled_) {
+      unrolled_->setParallelChunkSize(iBytes);
+    }
+  }
+
+  //the collection proxy already resizes a std::vector in place, see UnrolledDeserializer
+  void setRecycle(bool) {}
+
+private:
+  //a collection proxy can only be used by one thread at a time
+  struct ThreadState {
+    ThreadState(TVirtualCollectionProxy* iProxy);
+    //constructing a TBufferFile is costly compared to reading a small data product
+    TBufferFile bufferFile_;
+    std::unique_ptr<TVirtualCollectionProxy> collProxy_;
+  };
+  ThreadState& threadState() const;
+
+  native::Layout layout_;
+  std::unique_ptr<UnrolledDeserializer> unrolled_;
+  mutable tbb::enumerable_thread_specific<std::unique_ptr<ThreadState>> threadStates_;
+  //copying the proxy is not thread safe
+  mutable std::mutex copyProxyMutex_;
+  std::size_t parallelChunkSize_ = 0;
+};
+}
+#endif
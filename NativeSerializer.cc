@@ -0,0 +1,11 @@
+#include "NativeSerializer.h"
+
+using namespace cce::tf;
+
+NativeSerializer::NativeSerializer(TClass* iClass):
+  bufferFile_{TBuffer::kWrite},
+  layout_{native::buildLayout(*iClass)} {
+  if(layout_.m_kind == native::Kind::kUnrolled) {
+    unrolled_ = std::make_unique<UnrolledSerializer>(iClass);
+  }
+}
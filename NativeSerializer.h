@@ -0,0 +1,89 @@
+#if !defined(NativeSerializer_h)
+#define NativeSerializer_h
+
+#include <memory>
+#include <cstring>
+#include "TBufferFile.h"
+#include "TClass.h"
+#include "common_native.h"
+#include "UnrolledSerializer.h"
+#include "Span.h"
+#include "parallel_chunks.h"
+
+namespace cce::tf {
+  /*---------------------------------------
+  NativeSerializer copies trivially copyable data products, and std::vectors
+  of trivially copyable elements, into the buffer with memcpy instead of
+  byte swapping each value as ROOT does. The data is therefore only readable
+  on machines with the same byte order and the same class layout. Other
+  data products use UnrolledSerializer.
+  ---------------------------------------*/
+class NativeSerializer {
+public:
+  NativeSerializer(TClass*);
+
+  NativeSerializer(NativeSerializer&& iOther):
+    bufferFile_{TBuffer::kWrite}, layout_(std::move(iOther.layout_)), unrolled_(std::move(iOther.unrolled_)),
+    parallelChunkSize_{iOther.parallelChunkSize_} {}
+
+  NativeSerializer(NativeSerializer const& ) = delete;
+
+  //The returned Span refers to the internal buffer which is reused by the next call
+  Span<char const> serialize(void const* address) {
+    if(unrolled_) {
+      return unrolled_->serialize(address);
+    }
+    bufferFile_.Reset();
+    serialize(address, bufferFile_);
+    return Span<char const>(bufferFile_.Buffer(), bufferFile_.Length());
+  }
+
+  //writes to the end of iBuffer rather than to the internal buffer
+  void serialize(void const* address, TBufferFile& iBuffer) {
+    switch(layout_.m_kind) {
+    case native::Kind::kObject:
+      {
+        iBuffer.WriteBuf(address, layout_.m_size);
+        break;
+      }
+    case native::Kind::kVector:
+      {
+        TVirtualCollectionProxy::TPushPop helper(layout_.m_collProxy.get(), const_cast<void*>(address));
+        Int_t size = layout_.m_collProxy->Size();
+        iBuffer.WriteBuf(&size, sizeof(size));
+        if(size != 0) {
+          std::size_t const nBytes = size*layout_.m_size;
+          iBuffer.AutoExpand(iBuffer.Length()+nBytes);
+          char* to = iBuffer.Buffer()+iBuffer.Length();
+          auto from = static_cast<char const*>(layout_.m_collProxy->At(0));
+          forEachChunk(nBytes, 1, parallelChunkSize_, [to, from](std::size_t iBegin, std::size_t iEnd) {
+              std::memcpy(to+iBegin, from+iBegin, iEnd-iBegin);
+            });
+          iBuffer.SetBufferOffset(iBuffer.Length()+nBytes);
+        }
+        break;
+      }
+    case native::Kind::kUnrolled:
+      {
+        unrolled_->serialize(address, iBuffer);
+        break;
+      }
+    }
+  }
+
+  //collections taking more than iBytes are copied using multiple tasks. 0 turns this off.
+  void setParallelChunkSize(std::size_t iBytes) {
+    parallelChunkSize_ = iBytes;
+    if(unrolled_) {
+      unrolled_->setParallelChunkSize(iBytes);
+    }
+  }
+
+private:
+  TBufferFile bufferFile_;
+  native::Layout layout_;
+  std::unique_ptr<UnrolledSerializer> unrolled_;
+  std::size_t parallelChunkSize_ = 0;
+};
+}
+#endif
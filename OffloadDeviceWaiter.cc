@@ -0,0 +1,161 @@
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <algorithm>
+#include <iostream>
+#include "EventIdentifier.h"
+#include "DataProductRetriever.h"
+#include "TaskHolder.h"
+#include "FunctorTask.h"
+#include "TimerService.h"
+#include "WaiterBase.h"
+#include "WaiterFactory.h"
+
+
+namespace cce::tf {
+  /*---------------------------------------
+  OffloadDeviceWaiter emulates an asynchronous device (e.g. an accelerator or a
+  remote service). The device can work on at most nSlots requests at once,
+  additional requests wait in a FIFO queue. The time a request occupies a slot is
+     latency + size/bandwidth
+  where size comes from DataProductRetriever::size(). The TimerService hands the
+  request back to the TBB arena which submitted it once its slot time is over,
+  the freed slot is then given to the next request in the queue.
+  ---------------------------------------*/
+  class OffloadDeviceWaiter : public WaiterBase {
+ public:
+    using clock = TimerService::clock;
+
+    OffloadDeviceWaiter(unsigned int iNSlots, double iLatency, double iBandwidth):
+      nSlots_{iNSlots},
+      latency_{iLatency},
+      bandwidth_{iBandwidth} {}
+
+    void waitAsync(unsigned int iLaneIndex, EventIdentifier const& iEventID, long iEventIndex,
+                   std::vector<DataProductRetriever> const& iRetrievers, unsigned int index,
+                   TaskHolder iCallback) const final {
+      using namespace std::chrono_literals;
+      double time = latency_;
+      if(bandwidth_ > 0.) {
+        time += iRetrievers[index].size()/bandwidth_;
+      }
+      auto const now = clock::now();
+      Request request{now, std::chrono::duration_cast<clock::duration>(time*1us), std::move(iCallback)};
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        ++nRequests_;
+        bool const queued = busySlots_ == nSlots_;
+        if(queued) {
+          pending_.push_back(std::move(request));
+        } else {
+          ++busySlots_;
+        }
+        summedQueueDepth_ += pending_.size();
+        maxQueueDepth_ = std::max(maxQueueDepth_, pending_.size());
+        if(queued) {
+          return;
+        }
+      }
+      start(std::move(request), now);
+    }
+
+    void printSummary() const final {
+      std::lock_guard<std::mutex> guard(mutex_);
+      std::cout <<"OffloadDeviceWaiter\n"
+        "  # slots: "<<nSlots_<<"\n"
+        "  # requests: "<<nRequests_<<"\n"
+        "  max queue depth: "<<maxQueueDepth_<<"\n"
+        "  average queue depth at submission: "<<(nRequests_ == 0 ? 0. : double(summedQueueDepth_)/nRequests_)<<"\n"
+        "  total queue wait time: "<<std::chrono::duration_cast<std::chrono::microseconds>(queueWaitTime_).count()<<"us\n"
+        "  total device busy time: "<<std::chrono::duration_cast<std::chrono::microseconds>(deviceTime_).count()<<"us\n"
+        "  average queue wait time: "<<(nRequests_ == 0 ? 0 : std::chrono::duration_cast<std::chrono::microseconds>(queueWaitTime_).count()/nRequests_)<<"us"<<std::endl;
+    }
+
+ private:
+    struct Request {
+      clock::time_point submitted_;
+      clock::duration duration_;
+      TaskHolder callback_;
+    };
+
+    //iRequest occupies a slot from iStart on. Must be called from a thread in the TBB arena of the request.
+    void start(Request iRequest, clock::time_point iStart) const {
+      auto const finish = iStart + iRequest.duration_;
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        queueWaitTime_ += iStart - iRequest.submitted_;
+        deviceTime_ += iRequest.duration_;
+      }
+      auto group = iRequest.callback_.group();
+      timer_.callAt(finish, TaskHolder(*group, make_functor_task([this, finish, callback = std::move(iRequest.callback_)]() mutable {
+              finished(finish);
+              callback.doneWaiting();
+            })));
+    }
+
+    //a request which was using a slot until iFinish is done
+    void finished(clock::time_point iFinish) const {
+      std::optional<Request> next;
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if(pending_.empty()) {
+          --busySlots_;
+          return;
+        }
+        next.emplace(std::move(pending_.front()));
+        pending_.pop_front();
+      }
+      //the slot became free at iFinish, not when this task got to run
+      auto const start = std::max(iFinish, next->submitted_);
+      this->start(std::move(*next), start);
+    }
+
+    unsigned int nSlots_;
+    double latency_;
+    double bandwidth_;
+
+    mutable std::mutex mutex_;
+    mutable std::deque<Request> pending_;
+    mutable unsigned int busySlots_ = 0;
+
+    //statistics, guarded by mutex_
+    mutable unsigned long long nRequests_ = 0;
+    mutable unsigned long long summedQueueDepth_ = 0;
+    mutable std::size_t maxQueueDepth_ = 0;
+    mutable clock::duration queueWaitTime_ = clock::duration::zero();
+    mutable clock::duration deviceTime_ = clock::duration::zero();
+
+    mutable TimerService timer_;
+};
+}
+
+namespace {
+
+  using namespace cce::tf;
+  class Maker : public WaiterMakerBase {
+  public:
+    Maker(): WaiterMakerBase("OffloadDeviceWaiter") {}
+
+    std::unique_ptr<WaiterBase> create(unsigned int iNLanes, std::vector<DataProductRetriever> const& iDataProducts, ConfigurationParameters const& params) const final {
+
+      auto nSlots = params.get<int>("slots", 1);
+      if(nSlots < 1) {
+        std::cout <<"value of 'slots' "<<nSlots<<" must be at least 1"<<std::endl;
+        return {};
+      }
+      auto latency = params.get<float>("latency", 0.);
+      auto bandwidth = params.get<float>("bandwidth", 0.);
+      if(latency < 0. or bandwidth < 0.) {
+        std::cout <<"values of 'latency' and 'bandwidth' can not be negative"<<std::endl;
+        return {};
+      }
+
+      return std::make_unique<OffloadDeviceWaiter>(nSlots, latency, bandwidth);
+    }
+
+  };
+
+  Maker s_maker;
+}
@@ -1,10 +1,15 @@
 #include "PDSOutputer.h"
 #include "OutputerFactory.h"
 #include "ConfigurationParameters.h"
+#include "CompressionConfig.h"
 #include "UnrolledSerializerWrapper.h"
+#include "common_unrolling.h"
+#include "GeneratedSerializerWrapper.h"
+#include "NativeSerializerWrapper.h"
 #include "SerializerWrapper.h"
 #include "summarize_serializers.h"
-#include "pds_writer.h"
+#include "FunctorTask.h"
+#include "TVirtualCollectionProxy.h"
 #include <iostream>
 #include <cstring>
 #include <set>
@@ -19,25 +24,128 @@ void PDSOutputer::setupForLane(unsigned int iLaneIndex, std::vector<DataProductR
     {   s = SerializeStrategy::make<SerializeProxy<SerializerWrapper>>(); break; }
   case Serialization::kRootUnrolled:
     {   s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>(); break; }
+  case Serialization::kGenerated:
+    {   s = SerializeStrategy::make<SerializeProxy<GeneratedSerializerWrapper>>(); break; }
+  case Serialization::kNative:
+    {   s = SerializeStrategy::make<SerializeProxy<NativeSerializerWrapper>>(); break; }
+  }
+  if(iLaneIndex == 0) {
+    serializerSetupTime_ = prepareSharedSerializers(serialization_, iDPs);
   }
   s.reserve(iDPs.size());
   for(auto const& dp: iDPs) {
-    s.emplace_back(dp.name(), dp.classType());
+    s.emplace_back(dp.name(), dp.classType()).setParallelChunkSize(parallelChunkSize_);
+  }
+  if(useEventArena_) {
+    addresses_[iLaneIndex].resize(iDPs.size(), nullptr);
+  }
+  if(layout_ == Layout::kProduct) {
+    compressedProducts_[iLaneIndex].resize(iDPs.size());
+    productLevels_[iLaneIndex] = chooseCompressionLevel();
+    productCompressionTimes_[iLaneIndex].store(0);
+  }
+  if(iLaneIndex == 0 and layout_ == Layout::kProduct) {
+    shuffleSizes_.reserve(iDPs.size());
+    for(auto const& dp: iDPs) {
+      shuffleSizes_.push_back(shuffle_ ? shuffleSize(*dp.classType()) : 0);
+    }
   }
 }
 
+uint32_t PDSOutputer::shuffleSize(TClass& iClass) {
+  //only collections of builtins, e.g. std::vector<float>, are known to end with an array of same sized values
+  auto proxy = iClass.GetCollectionProxy();
+  if(not proxy or proxy->GetValueClass()) {
+    return 0;
+  }
+  auto size = unrolling::bulkBuiltinSize(proxy->GetType());
+  return size > 1 ? size : 0;
+}
+
 void PDSOutputer::productReadyAsync(unsigned int iLaneIndex, DataProductRetriever const& iDataProduct, TaskHolder iCallback) const {
+  if(useEventArena_) {
+    //serialization is done in outputAsync, iCallback is released when it goes out of scope
+    addresses_[iLaneIndex][iDataProduct.index()] = iDataProduct.address();
+    return;
+  }
   auto& laneSerializers = serializers_[iLaneIndex];
   auto group = iCallback.group();
+  if(layout_ == Layout::kProduct) {
+    //compress in a task run once the serialization is done, iCallback is released after that task
+    auto index = iDataProduct.index();
+    TaskHolder compressTask(*group, make_functor_task([this, iLaneIndex, index, callback=std::move(iCallback)]() {
+          compressDataProduct(iLaneIndex, index);
+        }));
+    laneSerializers[index].doWorkAsync(*group, iDataProduct.address(), std::move(compressTask));
+    return;
+  }
   laneSerializers[iDataProduct.index()].doWorkAsync(*group, iDataProduct.address(), std::move(iCallback));
 }
 
+void PDSOutputer::compressDataProduct(unsigned int iLaneIndex, unsigned int iProductIndex) const {
+  if(storesSerializedBlob(iProductIndex)) {
+    return;
+  }
+  auto blob = serializers_[iLaneIndex][iProductIndex].blob();
+  auto level = productLevels_[iLaneIndex];
+  auto start = std::chrono::high_resolution_clock::now();
+  compressedProducts_[iLaneIndex][iProductIndex] = pds::compressBuffer(0, 0, compression_, level, blob, zstdParameters_, nullptr, shuffleSizes_[iProductIndex]);
+  if(adaptiveLevel_) {
+    //the adaptive level is given the time for the whole event by outputAsync
+    productCompressionTimes_[iLaneIndex] += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+  }
+}
+
+Span<char const> PDSOutputer::storedProduct(unsigned int iLaneIndex, unsigned int iProductIndex) const {
+  if(storesSerializedBlob(iProductIndex)) {
+    return serializers_[iLaneIndex][iProductIndex].blob();
+  }
+  auto const& product = compressedProducts_[iLaneIndex][iProductIndex];
+  return Span<char const>(product.data(), product.size());
+}
+
+void PDSOutputer::compressionDone(int iLevel, std::chrono::high_resolution_clock::time_point iStart) const {
+  if(adaptiveLevel_) {
+    adaptiveLevel_->compressed(iLevel, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - iStart));
+  }
+}
+
+PDSOutputer::~PDSOutputer() {
+  if(not pendingEvents_.empty()) {
+    //fewer events than dictionaryTrainingEvents_ were processed
+    writePendingEvents(serializers_[0]);
+  }
+}
+
 void PDSOutputer::outputAsync(unsigned int iLaneIndex, EventIdentifier const& iEventID, TaskHolder iCallback) const {
   auto start = std::chrono::high_resolution_clock::now();
-  auto tempBuffer = std::make_unique<std::vector<uint32_t>>(writeDataProductsToOutputBuffer(serializers_[iLaneIndex]));
-  queue_.push(*iCallback.group(), [this, iEventID, iLaneIndex, callback=std::move(iCallback), buffer=std::move(tempBuffer)]() mutable {
+  //until the dictionary is trained the events are held uncompressed
+  bool const compress = not useDictionary() or dictionaryReady_.load();
+  //all compressions of an event use the same level so it can be recorded in the event header
+  int level;
+  if(layout_ == Layout::kProduct) {
+    level = productLevels_[iLaneIndex];
+    if(adaptiveLevel_) {
+      //the writer's queue holds events so the compression time is reported per event, not per data product
+      adaptiveLevel_->compressed(level, std::chrono::microseconds(productCompressionTimes_[iLaneIndex].exchange(0)));
+    }
+    //the data products of the lane's next event are compressed using the level chosen now
+    productLevels_[iLaneIndex] = chooseCompressionLevel();
+  } else {
+    level = chooseCompressionLevel();
+  }
+  auto tempBuffer = std::make_unique<std::vector<uint32_t>>(layout_ == Layout::kProduct ? writeCompressedDataProductsToOutputBuffer(iLaneIndex) :
+                                                            useEventArena_ ? writeDataProductsToEventArena(iLaneIndex, compress, level) :
+                                                            writeDataProductsToOutputBuffer(serializers_[iLaneIndex], compress, level));
+  if(adaptiveLevel_) {
+    adaptiveLevel_->pushedToWriter();
+  }
+  queue_.push(*iCallback.group(), [this, iEventID, iLaneIndex, compress, level, callback=std::move(iCallback), buffer=std::move(tempBuffer)]() mutable {
+      if(adaptiveLevel_) {
+        adaptiveLevel_->takenByWriter();
+      }
       auto start = std::chrono::high_resolution_clock::now();
-      const_cast<PDSOutputer*>(this)->output(iEventID, serializers_[iLaneIndex],*buffer);
+      const_cast<PDSOutputer*>(this)->output(iEventID, serializers_[iLaneIndex],*buffer, compress, level);
       buffer.reset();
         serialTime_ += std::chrono::duration_cast<decltype(serialTime_)>(std::chrono::high_resolution_clock::now() - start);
       callback.doneWaiting();
@@ -47,14 +155,38 @@ void PDSOutputer::outputAsync(unsigned int iLaneIndex, EventIdentifier const& iE
 }
 
 void PDSOutputer::printSummary() const  {
+  if(not pendingEvents_.empty()) {
+    const_cast<PDSOutputer*>(this)->writePendingEvents(serializers_[0]);
+  }
   std::cout <<"PDSOutputer\n  total serial time at end event: "<<serialTime_.count()<<"us\n"
-    "  total parallel time at end event: "<<parallelTime_.load()<<"us\n";
+    "  total parallel time at end event: "<<parallelTime_.load()<<"us\n"
+    "  serializer setup time: "<<serializerSetupTime_.count()<<"us\n";
+  if(compressedBytes_.load() != 0) {
+    std::cout <<"  compression ratio: "<<double(uncompressedBytes_.load())/compressedBytes_.load()<<"\n";
+  }
+  if(adaptiveLevel_) {
+    adaptiveLevel_->printSummary(std::cout);
+  }
   summarize_serializers(serializers_);
 }
 
 
 
-void PDSOutputer::output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t>const& iBuffer) {
+void PDSOutputer::output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t>const& iBuffer, bool iCompressed, int iLevel) {
+  if(not iCompressed) {
+    if(dictionaryReady_.load()) {
+      //was serialized before the dictionary was trained
+      writeEventHeader(iEventID, iLevel);
+      auto record = makeEventRecord(iBuffer, iLevel);
+      file_.write(reinterpret_cast<char const*>(record.data()), (record.size())*4);
+      return;
+    }
+    pendingEvents_.emplace_back(iEventID, iBuffer);
+    if(pendingEvents_.size() >= dictionaryTrainingEvents_) {
+      writePendingEvents(iSerializers);
+    }
+    return;
+  }
   if(firstTime_) {
     writeFileHeader(iSerializers);
     firstTime_ = false;
@@ -63,7 +195,7 @@ void PDSOutputer::output(EventIdentifier const& iEventID, SerializeStrategy cons
   
   //std::cout <<"   run:"s+std::to_string(iEventID.run)+" lumi:"s+std::to_string(iEventID.lumi)+" event:"s+std::to_string(iEventID.event)+"\n"<<std::flush;
   
-  writeEventHeader(iEventID);
+  writeEventHeader(iEventID, iLevel);
   file_.write(reinterpret_cast<char const*>(iBuffer.data()), (iBuffer.size())*4);
   /*
     for(auto& s: iSerializers) {
@@ -72,6 +204,26 @@ void PDSOutputer::output(EventIdentifier const& iEventID, SerializeStrategy cons
   */
 }
 
+void PDSOutputer::writePendingEvents(SerializeStrategy const& iSerializers) {
+  std::vector<Span<char const>> samples;
+  samples.reserve(pendingEvents_.size());
+  for(auto const& e: pendingEvents_) {
+    samples.emplace_back(reinterpret_cast<char const*>(e.second.data()), e.second.size()*4);
+  }
+  dictionary_ = pds::CompressionDictionary::train(samples, dictionarySize_, compressionLevel_);
+  dictionaryReady_.store(true);
+
+  writeFileHeader(iSerializers);
+  firstTime_ = false;
+  for(auto const& e: pendingEvents_) {
+    writeEventHeader(e.first, compressionLevel_);
+    auto record = makeEventRecord(e.second, compressionLevel_);
+    file_.write(reinterpret_cast<char const*>(record.data()), (record.size())*4);
+  }
+  pendingEvents_.clear();
+  pendingEvents_.shrink_to_fit();
+}
+
 void PDSOutputer::writeFileHeader(SerializeStrategy const& iSerializers) {
   std::set<std::string> typeNamesSet;
   for(auto const& w: iSerializers) {
@@ -102,6 +254,9 @@ void PDSOutputer::writeFileHeader(SerializeStrategy const& iSerializers) {
       dataProducts.back().second.push_back('\0');
     }
     nCharactersInDataProducts += 4 + dataProducts.back().second.size();
+    if(layout_ == Layout::kProduct) {
+      nCharactersInDataProducts += 4;
+    }
   }
   
   std::array<char, 8> transitions = {'E','v','e','n','t','\0','\0','\0'};
@@ -109,7 +264,9 @@ void PDSOutputer::writeFileHeader(SerializeStrategy const& iSerializers) {
   size_t bufferPosition = 0;
   std::vector<uint32_t> buffer;
   const auto nWordsInTypeNames = bytesToWords(nCharactersInTypeNames);
-  buffer.resize(1+transitions.size()/4+1+nWordsInTypeNames+1+1+nCharactersInDataProducts/4);
+  auto const& dictionary = dictionary_.bytes();
+  const size_t nWordsInDictionary = dictionary.empty() ? 0 : 1+bytesToWords(dictionary.size());
+  buffer.resize(1+transitions.size()/4+1+nWordsInTypeNames+1+1+nCharactersInDataProducts/4+nWordsInDictionary);
   
   //The different record types stored
   buffer[bufferPosition++] = transitions.size()/4;
@@ -134,19 +291,30 @@ void PDSOutputer::writeFileHeader(SerializeStrategy const& iSerializers) {
   
   //The different data products to be stored
   buffer[bufferPosition++] = dataProducts.size();
-  for(auto const& dp : dataProducts) {
+  for(size_t productIndex = 0; productIndex < dataProducts.size(); ++productIndex) {
+    auto const& dp = dataProducts[productIndex];
     buffer[bufferPosition++] = dp.first;
+    if(layout_ == Layout::kProduct) {
+      buffer[bufferPosition++] = shuffleSizes_[productIndex];
+    }
     std::memcpy(reinterpret_cast<char*>(buffer.data()+bufferPosition), dp.second.data(), dp.second.size());
     assert(0 == dp.second.size() % 4);
     bufferPosition += dp.second.size()/4;
   }
+
+  //The optional ZSTD dictionary used for all events
+  if(not dictionary.empty()) {
+    buffer[bufferPosition++] = dictionary.size();
+    std::memcpy(reinterpret_cast<char*>(buffer.data()+bufferPosition), dictionary.data(), dictionary.size());
+    bufferPosition += bytesToWords(dictionary.size());
+  }
+  assert(bufferPosition == buffer.size());
   
   {
-    //The file type identifier
-    uint32_t comp = 0;
-    if(serialization_ == Serialization::kRootUnrolled) {
-      comp = 1;
-    }
+    //The file type identifier, the serialization is in the lowest 4 bits, the layout in the next 3
+    // and the highest bit is set if each event header ends with the event's compression level
+    const uint32_t comp = static_cast<uint32_t>(serialization_) + (static_cast<uint32_t>(layout_) << 4) +
+      (recordsCompressionLevel() ? 0x80 : 0);
     const uint32_t id = 3141592*256+1 + comp;
     file_.write(reinterpret_cast<char const*>(&id), 4);
   }
@@ -174,18 +342,20 @@ void PDSOutputer::writeFileHeader(SerializeStrategy const& iSerializers) {
   file_.write(reinterpret_cast<char const*>(&bufferSize), 4);
 }
 
-void PDSOutputer::writeEventHeader(EventIdentifier const& iEventID) {
-  constexpr unsigned int headerBufferSizeInWords = 5;
+void PDSOutputer::writeEventHeader(EventIdentifier const& iEventID, int iCompressionLevel) {
+  constexpr unsigned int headerBufferSizeInWords = 6;
   std::array<uint32_t,headerBufferSizeInWords> buffer;
   buffer[0] = 0; //Record index for Event
   buffer[1] = iEventID.run;
   buffer[2] = iEventID.lumi;
   buffer[3] = (iEventID.event >> 32) & 0xFFFFFFFF;
   buffer[4] = iEventID.event & 0xFFFFFFFF;
-  file_.write(reinterpret_cast<char const*>(buffer.data()), headerBufferSizeInWords*4);
+  //stored as a signed value since ZSTD allows negative levels
+  buffer[5] = static_cast<uint32_t>(iCompressionLevel);
+  file_.write(reinterpret_cast<char const*>(buffer.data()), (recordsCompressionLevel() ? 6 : 5)*4);
 }
 
-std::vector<uint32_t> PDSOutputer::writeDataProductsToOutputBuffer(SerializeStrategy const& iSerializers) const{
+std::vector<uint32_t> PDSOutputer::writeDataProductsToOutputBuffer(SerializeStrategy const& iSerializers, bool iCompress, int iLevel) const{
   //Calculate buffer size needed
   uint32_t bufferSize = 0;
   for(auto const& s: iSerializers) {
@@ -193,11 +363,15 @@ std::vector<uint32_t> PDSOutputer::writeDataProductsToOutputBuffer(SerializeStra
     auto const blobSize = s.blob().size();
     bufferSize += bytesToWords(blobSize); //handles padding
   }
+  //without compression the event record is filled directly rather than copied by makeEventRecord
+  bool const inPlaceRecord = iCompress and compression_ == pds::Compression::kNone;
+  unsigned int const leadPadding = inPlaceRecord ? 2 : 0;
+  unsigned int const trailingPadding = inPlaceRecord ? 1 : 0;
   //initialize with 0
-  std::vector<uint32_t> buffer(size_t(bufferSize), 0);
+  std::vector<uint32_t> buffer(size_t(leadPadding+bufferSize+trailingPadding), 0);
   
   {
-    uint32_t bufferIndex = 0;
+    uint32_t bufferIndex = leadPadding;
     uint32_t dataProductIndex = 0;
     for(auto const& s: iSerializers) {
       buffer[bufferIndex++]=dataProductIndex++;
@@ -207,28 +381,110 @@ std::vector<uint32_t> PDSOutputer::writeDataProductsToOutputBuffer(SerializeStra
       std::copy(s.blob().begin(), s.blob().end(), reinterpret_cast<char*>( &(*(buffer.begin()+bufferIndex)) ) );
       bufferIndex += sizeInWords;
     }
-    assert(buffer.size() == bufferIndex);
+    assert(buffer.size() == bufferIndex+trailingPadding);
+  }
+
+  if(inPlaceRecord) {
+    return finishEventRecord(std::move(buffer), bufferSize*4, bufferSize);
+  }
+  if(not iCompress) {
+    return buffer;
+  }
+  return makeEventRecord(buffer, iLevel);
+}
+
+std::vector<uint32_t> PDSOutputer::writeDataProductsToEventArena(unsigned int iLaneIndex, bool iCompress, int iLevel) const {
+  auto& arena = arenas_[iLaneIndex];
+  auto const& addresses = addresses_[iLaneIndex];
+  arena.clear();
+
+  uint32_t dataProductIndex = 0;
+  for(auto& s: serializers_[iLaneIndex]) {
+    auto const headerOffset = arena.append(2*4);
+    auto const blobSize = s.serialize(addresses[dataProductIndex], arena);
+    arena.padTo(4);
+    std::array<uint32_t, 2> header = {dataProductIndex, uint32_t(bytesToWords(blobSize))};
+    std::memcpy(arena.data()+headerOffset, header.data(), 2*4);
+    ++dataProductIndex;
   }
+  assert(arena.size() % 4 == 0);
 
-  auto [cBuffer,cSize] = compressBuffer(2, 1, buffer);
+  Span<uint32_t const> buffer(reinterpret_cast<uint32_t const*>(arena.data()), arena.size()/4);
+  if(not iCompress) {
+    //the arena is reused by the lane's next event
+    return std::vector<uint32_t>(buffer.begin(), buffer.end());
+  }
+  return makeEventRecord(buffer, iLevel);
+}
+
+std::vector<uint32_t> PDSOutputer::makeEventRecord(Span<uint32_t const> buffer, int iLevel) const {
+  auto [cBuffer,cSize] = compressBuffer(2, 1, buffer, iLevel);
+  return finishEventRecord(std::move(cBuffer), cSize, buffer.size());
+}
 
-  //std::cout <<"compressed "<<cSize<<" uncompressed "<<buffer.size()*4<<std::endl;
-  //std::cout <<"compressed "<<(buffer.size()*4)/float(cSize)<<std::endl;
+std::vector<uint32_t> PDSOutputer::finishEventRecord(std::vector<uint32_t> cBuffer, int cSize, std::size_t iUncompressedWords) const {
+  //std::cout <<"compressed "<<cSize<<" uncompressed "<<iUncompressedWords*4<<std::endl;
+  //std::cout <<"compressed "<<(iUncompressedWords*4)/float(cSize)<<std::endl;
   uint32_t const recordSize = bytesToWords(cSize)+1;
   cBuffer[0] = recordSize;
   //Record the actual number of bytes used in the last word of the compression buffer in the lowest
   // 2 bits of the word
-  cBuffer[1] = buffer.size()*4 + (cSize % 4);
+  cBuffer[1] = iUncompressedWords*4 + (cSize % 4);
   if(cBuffer.size() != recordSize+2) {
     std::cout <<"BAD BUFFER SIZE: want: "<<recordSize+2<<" got "<<cBuffer.size()<<std::endl;
   }
   assert(cBuffer.size() == recordSize+2);
   cBuffer[recordSize+1]=recordSize;
+  uncompressedBytes_ += iUncompressedWords*4;
+  compressedBytes_ += cSize;
   return cBuffer;
 }
 
-std::pair<std::vector<uint32_t>,int> PDSOutputer::compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<uint32_t> const& iBuffer) const {
-  return pds::compressBuffer(iLeadPadding, iTrailingPadding, compression_, compressionLevel_, iBuffer);
+std::vector<uint32_t> PDSOutputer::writeCompressedDataProductsToOutputBuffer(unsigned int iLaneIndex) const {
+  //number of data products, then a table of (product index, uncompressed bytes, compressed bytes)
+  // followed by the compressed data products each padded to a word
+  auto const& serializers = serializers_[iLaneIndex];
+  uint32_t const nProducts = compressedProducts_[iLaneIndex].size();
+  std::vector<Span<char const>> products;
+  products.reserve(nProducts);
+  for(uint32_t productIndex = 0; productIndex < nProducts; ++productIndex) {
+    products.push_back(storedProduct(iLaneIndex, productIndex));
+  }
+  uint32_t recordSize = 1 + 3*products.size();
+  for(auto const& p: products) {
+    recordSize += bytesToWords(p.size());
+  }
+  //first and last word hold the record size
+  std::vector<uint32_t> record(size_t(recordSize+2), 0);
+  record[0] = recordSize;
+  uint32_t index = 1;
+  record[index++] = products.size();
+  std::size_t uncompressedBytes = 0;
+  std::size_t compressedBytes = 0;
+  for(uint32_t productIndex = 0; productIndex < products.size(); ++productIndex) {
+    auto const blobSize = serializers[productIndex].blob().size();
+    record[index++] = productIndex;
+    record[index++] = blobSize;
+    record[index++] = products[productIndex].size();
+    uncompressedBytes += blobSize;
+    compressedBytes += products[productIndex].size();
+  }
+  for(auto const& p: products) {
+    std::memcpy(reinterpret_cast<char*>(record.data()+index), p.data(), p.size());
+    index += bytesToWords(p.size());
+  }
+  assert(index == recordSize+1);
+  record[index] = recordSize;
+  uncompressedBytes_ += uncompressedBytes;
+  compressedBytes_ += compressedBytes;
+  return record;
+}
+
+std::pair<std::vector<uint32_t>,int> PDSOutputer::compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Span<uint32_t const> iBuffer, int iLevel) const {
+  auto start = std::chrono::high_resolution_clock::now();
+  auto result = pds::compressBuffer(iLeadPadding, iTrailingPadding, compression_, iLevel, iBuffer, zstdParameters_, &dictionary_);
+  compressionDone(iLevel, start);
+  return result;
 }
 
 namespace {
@@ -246,6 +502,10 @@ namespace {
       }
 
       int compressionLevel = params.get<int>("compressionLevel", 18);
+      auto zstdParameters = parseZSTDParameters(params);
+      if(not zstdParameters) {
+        return {};
+      }
 
       auto compressionName = params.get<std::string>("compressionAlgorithm", "ZSTD");
       auto serializationName = params.get<std::string>("serializationAlgorithm", "ROOT");
@@ -262,7 +522,43 @@ namespace {
         return {};
       }
       
-      return std::make_unique<PDSOutputer>(*fileName,iNLanes, *compression, compressionLevel, *serialization);
+      auto useEventArena = params.get<bool>("useEventArena", false);
+      auto parallelChunkSize = params.get<std::size_t>("parallelChunkSize", 0);
+
+      auto dictionarySize = params.get<std::size_t>("dictionarySize", 0);
+      auto dictionaryTrainingEvents = params.get<unsigned int>("dictionaryTrainingEvents", 100);
+      auto perProductCompression = params.get<bool>("perProductCompression", false);
+      if(perProductCompression and (useEventArena or dictionarySize != 0)) {
+        std::cout <<"perProductCompression can not be used with useEventArena or dictionarySize"<<std::endl;
+        return {};
+      }
+      auto shuffle = params.get<bool>("shuffle", false);
+      if(shuffle and not perProductCompression) {
+        std::cout <<"shuffle can only be used with perProductCompression"<<std::endl;
+        return {};
+      }
+      if(dictionarySize != 0 and *compression != pds::Compression::kZSTD) {
+        std::cout <<"dictionarySize can only be used with ZSTD compression"<<std::endl;
+        return {};
+      }
+      if(dictionarySize != 0 and dictionaryTrainingEvents == 0) {
+        std::cout <<"dictionaryTrainingEvents must be greater than 0"<<std::endl;
+        return {};
+      }
+
+      auto adaptiveLevel = makeAdaptiveCompressionLevel(params, *compression, compressionLevel);
+      if(not adaptiveLevel) {
+        return {};
+      }
+      if(*adaptiveLevel and dictionarySize != 0) {
+        //the dictionary is prepared for one compression level
+        std::cout <<"adaptiveCompression can not be used with dictionarySize"<<std::endl;
+        return {};
+      }
+      
+      return std::make_unique<PDSOutputer>(*fileName,iNLanes, *compression, compressionLevel, *zstdParameters, *serialization, useEventArena, parallelChunkSize,
+                                           dictionarySize, dictionaryTrainingEvents, perProductCompression ? pds::Layout::kProduct : pds::Layout::kEvent,
+                                           std::move(*adaptiveLevel), shuffle);
     }
     
   };
@@ -5,28 +5,52 @@
 #include <string>
 #include <cstdint>
 #include <fstream>
+#include <atomic>
+#include <memory>
 
 #include "OutputerBase.h"
 #include "EventIdentifier.h"
 #include "SerializeStrategy.h"
 #include "DataProductRetriever.h"
+#include "EventArena.h"
+#include "Span.h"
 #include "pds_common.h"
+#include "pds_writer.h"
+#include "AdaptiveCompressionLevel.h"
 
 #include "SerialTaskQueue.h"
 
 namespace cce::tf {
 class PDSOutputer :public OutputerBase {
  public:
- PDSOutputer(std::string const& iFileName, unsigned int iNLanes, pds::Compression iCompression, int iCompressionLevel, 
-             pds::Serialization iSerialization ): 
+ PDSOutputer(std::string const& iFileName, unsigned int iNLanes, pds::Compression iCompression, int iCompressionLevel, pds::ZSTDParameters const& iZSTDParameters, 
+             pds::Serialization iSerialization, bool iUseEventArena, std::size_t iParallelChunkSize,
+             std::size_t iDictionarySize, unsigned int iDictionaryTrainingEvents, pds::Layout iLayout,
+             std::unique_ptr<AdaptiveCompressionLevel> iAdaptiveLevel, bool iShuffle): 
   file_(iFileName, std::ios_base::out| std::ios_base::binary),
   serializers_{std::size_t(iNLanes)},
+  arenas_(iUseEventArena ? std::size_t(iNLanes) : std::size_t(0)),
+  addresses_{std::size_t(iNLanes)},
+  compressedProducts_(iLayout == pds::Layout::kProduct ? std::size_t(iNLanes) : std::size_t(0)),
+  productLevels_(iLayout == pds::Layout::kProduct ? std::size_t(iNLanes) : std::size_t(0), iCompressionLevel),
+  productCompressionTimes_(iLayout == pds::Layout::kProduct ? std::size_t(iNLanes) : std::size_t(0)),
   compression_{iCompression},
   compressionLevel_{iCompressionLevel},
+  adaptiveLevel_{std::move(iAdaptiveLevel)},
+  zstdParameters_{iZSTDParameters},
   serialization_{iSerialization},
+  useEventArena_{iUseEventArena},
+  layout_{iLayout},
+  shuffle_{iShuffle},
+  parallelChunkSize_{iParallelChunkSize},
+  dictionarySize_{iDictionarySize},
+  dictionaryTrainingEvents_{iDictionaryTrainingEvents},
   serialTime_{std::chrono::microseconds::zero()},
-  parallelTime_{0}
+  parallelTime_{0},
+  uncompressedBytes_{0},
+  compressedBytes_{0}
   {}
+  ~PDSOutputer();
 
   void setupForLane(unsigned int iLaneIndex, std::vector<DataProductRetriever> const& iDPs) final;
 
@@ -42,13 +66,37 @@ class PDSOutputer :public OutputerBase {
     return nBytes/4 + ( (nBytes % 4) == 0 ? 0 : 1);
   }
 
-  void output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> const& iBuffer);
+  //iCompressed is false if iBuffer holds the uncompressed data products of an event waiting for the dictionary
+  void output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> const& iBuffer, bool iCompressed, int iLevel);
   void writeFileHeader(SerializeStrategy const& iSerializers);
+  //trains the dictionary from the pending events then writes them
+  void writePendingEvents(SerializeStrategy const& iSerializers);
+  bool useDictionary() const { return dictionarySize_ != 0; }
 
-  void writeEventHeader(EventIdentifier const& iEventID);
-  std::vector<uint32_t> writeDataProductsToOutputBuffer(SerializeStrategy const& iSerializers) const;
+  //iCompressionLevel is only written if recordsCompressionLevel()
+  void writeEventHeader(EventIdentifier const& iEventID, int iCompressionLevel);
+  //only files written with an adaptive level need the level of each event
+  bool recordsCompressionLevel() const { return static_cast<bool>(adaptiveLevel_); }
+  //if iCompress is false the uncompressed data products are returned instead of the event record
+  std::vector<uint32_t> writeDataProductsToOutputBuffer(SerializeStrategy const& iSerializers, bool iCompress, int iLevel) const;
+  //serializes all data products of the lane directly into the lane's EventArena
+  std::vector<uint32_t> writeDataProductsToEventArena(unsigned int iLaneIndex, bool iCompress, int iLevel) const;
+  std::vector<uint32_t> makeEventRecord(Span<uint32_t const> iBuffer, int iLevel) const;
+  //fills in the record words around the cSize bytes stored from the 3rd word of cBuffer
+  std::vector<uint32_t> finishEventRecord(std::vector<uint32_t> cBuffer, int cSize, std::size_t iUncompressedWords) const;
+  //used for Layout::kProduct, each data product is compressed as soon as it is serialized
+  void compressDataProduct(unsigned int iLaneIndex, unsigned int iProductIndex) const;
+  //without compression or shuffling the serialized blob is written as is rather than copied to compressedProducts_
+  bool storesSerializedBlob(unsigned int iProductIndex) const { return compression_ == pds::Compression::kNone and shuffleSizes_[iProductIndex] <= 1; }
+  //the bytes written to the file for the data product
+  Span<char const> storedProduct(unsigned int iLaneIndex, unsigned int iProductIndex) const;
+  std::vector<uint32_t> writeCompressedDataProductsToOutputBuffer(unsigned int iLaneIndex) const;
+  //size of the values a data product of type iClass ends with, 0 if not known
+  static uint32_t shuffleSize(TClass& iClass);
 
-  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, std::vector<uint32_t> const& iBuffer) const;
+  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Span<uint32_t const> iBuffer, int iLevel) const;
+  int chooseCompressionLevel() const { return adaptiveLevel_ ? adaptiveLevel_->level() : compressionLevel_; }
+  void compressionDone(int iLevel, std::chrono::high_resolution_clock::time_point iStart) const;
 
 private:
   std::ofstream file_;
@@ -56,12 +104,40 @@ private:
   mutable SerialTaskQueue queue_;
   std::vector<std::pair<std::string, uint32_t>> dataProductIndices_;
   mutable std::vector<SerializeStrategy> serializers_;
+  mutable std::vector<EventArena> arenas_;
+  mutable std::vector<std::vector<void**>> addresses_;
+  mutable std::vector<std::vector<std::vector<char>>> compressedProducts_;
+  //for Layout::kProduct, the level used for all data products of the lane's present event
+  mutable std::vector<int> productLevels_;
+  //for Layout::kProduct with an adaptive level, the time spent compressing the data products of the lane's present event
+  mutable std::vector<std::atomic<std::chrono::microseconds::rep>> productCompressionTimes_;
   pds::Compression compression_;
   int compressionLevel_;
+  //nullptr unless the compression level is changed at run time
+  std::unique_ptr<AdaptiveCompressionLevel> adaptiveLevel_;
+  pds::ZSTDParameters zstdParameters_;
   pds::Serialization serialization_;
+  bool useEventArena_;
+  pds::Layout layout_;
+  //for Layout::kProduct, shuffle the bytes of data products which are collections of builtins before compressing
+  bool shuffle_;
+  //value size given to pds::compressBuffer for each data product, 0 if it is not shuffled
+  std::vector<uint32_t> shuffleSizes_;
+  std::size_t parallelChunkSize_;
+  //if not 0, the maximum size in bytes of the ZSTD dictionary trained from the first events
+  std::size_t dictionarySize_;
+  unsigned int dictionaryTrainingEvents_;
+  //set once dictionary_ is filled, after which it is never changed
+  std::atomic<bool> dictionaryReady_{false};
+  pds::CompressionDictionary dictionary_;
+  std::vector<std::pair<EventIdentifier, std::vector<uint32_t>>> pendingEvents_;
   bool firstTime_ = true;
+  //time spent building what the serializers of all lanes share
+  std::chrono::microseconds serializerSetupTime_ = std::chrono::microseconds::zero();
   mutable std::chrono::microseconds serialTime_;
   mutable std::atomic<std::chrono::microseconds::rep> parallelTime_;
+  mutable std::atomic<std::size_t> uncompressedBytes_;
+  mutable std::atomic<std::size_t> compressedBytes_;
 };
 }
 #endif
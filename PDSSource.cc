@@ -5,6 +5,8 @@
 
 #include "Deserializer.h"
 #include "UnrolledDeserializer.h"
+#include "GeneratedDeserializer.h"
+#include "NativeDeserializer.h"
 
 using namespace cce::tf;
 using namespace cce::tf::pds;
@@ -12,7 +14,7 @@ using namespace cce::tf::pds;
 
 bool PDSSource::readEvent(long iEventIndex) {
   while(iEventIndex != presentEventIndex_) {
-    auto skipped = skipToNextEvent(file_);
+    auto skipped = skipToNextEvent(file_, eventHeaderSizeInWords_);
     if(not skipped) {return false;}
     ++presentEventIndex_;
   }
@@ -25,13 +27,16 @@ bool PDSSource::readEvent(long iEventIndex) {
 
 bool PDSSource::readEventContent() {
   std::vector<uint32_t> buffer;
-  if(not readCompressedEventBuffer(file_, eventID_, buffer)) {
+  if(not readCompressedEventBuffer(file_, eventID_, buffer, eventHeaderSizeInWords_)) {
     return false;
   }
   //last entry in buffer is a crosscheck on its size
   buffer.pop_back();
-  std::vector<uint32_t> uBuffer = uncompressEventBuffer(compression_, buffer);
-  deserializeDataProducts(uBuffer.begin(), uBuffer.end(), dataProducts_, deserializers_);
+  if(layout_ == Layout::kProduct) {
+    uncompressAndDeserializeDataProducts(compression_, buffer, dataProducts_, deserializers_, &dictionary_, shuffleSizes_);
+    return true;
+  }
+  deserializeDataProducts(uncompressEventBuffer(compression_, buffer, uncompressedBuffer_, &dictionary_), dataProducts_, deserializers_);
 
   return true;
 }
@@ -41,7 +46,9 @@ PDSSource::PDSSource(std::string const& iName) :
   file_{iName, std::ios_base::binary}
 {
   pds::Serialization serialization;
-  auto productInfo = readFileHeader(file_, compression_, serialization);
+  std::vector<char> dictionary;
+  auto productInfo = readFileHeader(file_, compression_, serialization, layout_, dictionary, eventHeaderSizeInWords_);
+  dictionary_ = pds::DecompressionDictionary(dictionary);
 
   switch(serialization) {
   case pds::Serialization::kRoot: { 
@@ -50,6 +57,12 @@ PDSSource::PDSSource(std::string const& iName) :
   case pds::Serialization::kRootUnrolled: {
     deserializers_ = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
   }
+  case pds::Serialization::kGenerated: {
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<GeneratedDeserializer>>(); break;
+  }
+  case pds::Serialization::kNative: {
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<NativeDeserializer>>(); break;
+  }
   }
 
   dataProducts_.reserve(productInfo.size());
@@ -67,6 +80,7 @@ PDSSource::PDSSource(std::string const& iName) :
                                cls,
 			       &delayedRetriever_);
     deserializers_.emplace_back(cls);
+    shuffleSizes_.push_back(pi.shuffleSize());
     ++index;
   }
 }
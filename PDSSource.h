@@ -36,6 +36,13 @@ private:
   bool readEventContent();
 
   pds::Compression compression_;
+  pds::Layout layout_;
+  std::size_t eventHeaderSizeInWords_ = pds::kEventHeaderSizeInWords;
+  pds::DecompressionDictionary dictionary_;
+  //for Layout::kProduct, the size used to shuffle the bytes of each data product
+  std::vector<uint32_t> shuffleSizes_;
+  //reused for each event
+  UninitializedBuffer<uint32_t> uncompressedBuffer_;
   std::ifstream file_;
   long presentEventIndex_ = 0;
   EventIdentifier eventID_;
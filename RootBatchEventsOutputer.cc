@@ -1,7 +1,10 @@
 #include "RootBatchEventsOutputer.h"
 #include "OutputerFactory.h"
 #include "ConfigurationParameters.h"
+#include "CompressionConfig.h"
 #include "UnrolledSerializerWrapper.h"
+#include "GeneratedSerializerWrapper.h"
+#include "NativeSerializerWrapper.h"
 #include "SerializerWrapper.h"
 #include "summarize_serializers.h"
 #include "FunctorTask.h"
@@ -14,18 +17,23 @@
 using namespace cce::tf;
 using namespace cce::tf::pds;
 
-RootBatchEventsOutputer::RootBatchEventsOutputer(std::string const& iFileName, unsigned int iNLanes, Compression iCompression, int iCompressionLevel, 
+RootBatchEventsOutputer::RootBatchEventsOutputer(std::string const& iFileName, unsigned int iNLanes, Compression iCompression, int iCompressionLevel, ZSTDParameters const& iZSTDParameters, 
                                                  Serialization iSerialization, int autoFlush, int maxVirtualSize,
                                                  std::string const& iTFileCompression, int iTFileCompressionLevel,
-                                                 uint32_t iBatchSize): 
+                                                 uint32_t iBatchSize, uint32_t iCompressionBlockSize,
+                                                 std::unique_ptr<AdaptiveCompressionLevel> iAdaptiveLevel): 
   file_(iFileName.c_str(), "recreate", "", iTFileCompressionLevel),
   serializers_{iNLanes},
+  compressionLevelUsed_(iCompressionLevel),
   eventBatches_{iNLanes},
   waitingEventsInBatch_(iNLanes),
   presentEventEntry_(0),
   batchSize_(iBatchSize),
+  compressionBlockSize_(iCompressionBlockSize),
   compression_{iCompression},
   compressionLevel_{iCompressionLevel},
+  adaptiveLevel_{std::move(iAdaptiveLevel)},
+  zstdParameters_{iZSTDParameters},
   serialization_{iSerialization},
   serialTime_{std::chrono::microseconds::zero()},
   parallelTime_{0}
@@ -58,6 +66,9 @@ RootBatchEventsOutputer::RootBatchEventsOutputer(std::string const& iFileName, u
 
     eventsTree_->Branch("offsetsAndBlob", &offsetsAndBlob_);
     eventsTree_->Branch("EventIDs", &eventIDs_);
+    if(adaptiveLevel_) {
+      eventsTree_->Branch("compressionLevel", &compressionLevelUsed_);
+    }
 
     //Turn off auto save
     eventsTree_->SetAutoSave(std::numeric_limits<Long64_t>::max());
@@ -80,6 +91,13 @@ void RootBatchEventsOutputer::setupForLane(unsigned int iLaneIndex, std::vector<
     {   s = SerializeStrategy::make<SerializeProxy<SerializerWrapper>>(); break; }
   case Serialization::kRootUnrolled:
     {   s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>(); break; }
+  case Serialization::kGenerated:
+    {   s = SerializeStrategy::make<SerializeProxy<GeneratedSerializerWrapper>>(); break; }
+  case Serialization::kNative:
+    {   s = SerializeStrategy::make<SerializeProxy<NativeSerializerWrapper>>(); break; }
+  }
+  if(iLaneIndex == 0) {
+    serializerSetupTime_ = prepareSharedSerializers(serialization_, iDPs);
   }
   s.reserve(iDPs.size());
   offsetsAndBlob_.first.resize(iDPs.size()+1,0);
@@ -160,7 +178,11 @@ void RootBatchEventsOutputer::printSummary() const  {
 
 
   std::cout <<"RootBatchEventsOutputer\n  total serial time at end event: "<<serialTime_.count()<<"us\n"
-    "  total parallel time at end event: "<<parallelTime_.load()<<"us\n";
+    "  total parallel time at end event: "<<parallelTime_.load()<<"us\n"
+    "  serializer setup time: "<<serializerSetupTime_.count()<<"us\n";
+  if(adaptiveLevel_) {
+    adaptiveLevel_->printSummary(std::cout);
+  }
 
 
   start = std::chrono::high_resolution_clock::now();
@@ -205,22 +227,29 @@ void RootBatchEventsOutputer::finishBatchAsync(unsigned int iBatchIndex, TaskHol
     blob = std::vector<char>();
   }
 
-  auto compressedBlob = compressBuffer(batchBlob);
+  int const level = adaptiveLevel_ ? adaptiveLevel_->level() : compressionLevel_;
+  auto compressedBlob = compressBuffer(std::move(batchBlob), level);
   batchBlob = std::vector<char>();
 
-  
-  queue_.push(*iCallback.group(), [this, eventIDs=std::move(batchEventIDs), offsets = std::move(batchOffsets), buffer = std::move(compressedBlob),  callback=std::move(iCallback)]() mutable {
+  if(adaptiveLevel_) {
+    adaptiveLevel_->pushedToWriter();
+  }
+  queue_.push(*iCallback.group(), [this, level, eventIDs=std::move(batchEventIDs), offsets = std::move(batchOffsets), buffer = std::move(compressedBlob),  callback=std::move(iCallback)]() mutable {
+      if(adaptiveLevel_) {
+        adaptiveLevel_->takenByWriter();
+      }
       auto start = std::chrono::high_resolution_clock::now();
-      const_cast<RootBatchEventsOutputer*>(this)->output(std::move(eventIDs), std::move(buffer), std::move(offsets));
+      const_cast<RootBatchEventsOutputer*>(this)->output(std::move(eventIDs), std::move(buffer), std::move(offsets), level);
         serialTime_ += std::chrono::duration_cast<decltype(serialTime_)>(std::chrono::high_resolution_clock::now() - start);
       callback.doneWaiting();
     });
   
 }
 
-void RootBatchEventsOutputer::output(std::vector<EventIdentifier> iEventIDs, std::vector<char>  iBuffer, std::vector<uint32_t> iOffsets) {
+void RootBatchEventsOutputer::output(std::vector<EventIdentifier> iEventIDs, std::vector<char>  iBuffer, std::vector<uint32_t> iOffsets, int iCompressionLevel) {
 
   eventIDs_ = std::move(iEventIDs);
+  compressionLevelUsed_ = iCompressionLevel;
   offsetsAndBlob_ = {std::move(iOffsets), std::move(iBuffer)};
 
   eventsTree_->Fill();
@@ -244,6 +273,9 @@ void RootBatchEventsOutputer::writeMetaData(SerializeStrategy const& iSerializer
   meta->Branch("DataProducts",&typeAndNames, 0, 0);
   meta->Branch("objectSerializationUsed",&objectSerializationUsed);
   meta->Branch("compressionAlgorithm",&compression,0,0);
+  //0 means the batch was compressed as one frame
+  uint32_t compressionBlockSize = compressionBlockSize_;
+  meta->Branch("compressionBlockSize",&compressionBlockSize);
 
   meta->Fill();
 
@@ -276,11 +308,18 @@ std::pair<std::vector<uint32_t>, std::vector<char>> RootBatchEventsOutputer::wri
 
   //std::cout <<"compressed "<<cSize<<" uncompressed "<<buffer.size()<<std::endl;
   //std::cout <<"compressed "<<(buffer.size())/float(cSize)<<std::endl;
-  return {offsets,buffer};
+  return {std::move(offsets), std::move(buffer)};
 }
 
-std::vector<char> RootBatchEventsOutputer::compressBuffer(std::vector<char> const& iBuffer) const {
-  return pds::compressBuffer(0, 0, compression_, compressionLevel_, iBuffer);
+std::vector<char> RootBatchEventsOutputer::compressBuffer(std::vector<char>&& iBuffer, int iCompressionLevel) const {
+  auto start = std::chrono::high_resolution_clock::now();
+  auto cBuffer = compressionBlockSize_ != 0 ?
+    pds::compressBufferInBlocks(compression_, iCompressionLevel, iBuffer, compressionBlockSize_, zstdParameters_) :
+    pds::compressBuffer(0, 0, compression_, iCompressionLevel, std::move(iBuffer), zstdParameters_);
+  if(adaptiveLevel_) {
+    adaptiveLevel_->compressed(iCompressionLevel, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start));
+  }
+  return cBuffer;
 }
 
 namespace {
@@ -298,6 +337,10 @@ namespace {
       }
 
       int compressionLevel = params.get<int>("compressionLevel", 18);
+      auto zstdParameters = parseZSTDParameters(params);
+      if(not zstdParameters) {
+        return {};
+      }
 
       auto compressionName = params.get<std::string>("compressionAlgorithm", "ZSTD");
       auto serializationName = params.get<std::string>("serializationAlgorithm", "ROOT");
@@ -321,8 +364,18 @@ namespace {
       auto fileLevelCompressionLevel = params.get<int>("tfileCompressionLevel",0);
 
       auto batchSize = params.get<int>("batchSize",1);
+      auto compressionBlockSize = parseCompressionBlockSize(params);
+      if(not compressionBlockSize) {
+        return {};
+      }
+
+      auto adaptiveLevel = makeAdaptiveCompressionLevel(params, *compression, compressionLevel);
+      if(not adaptiveLevel) {
+        return {};
+      }
       
-      return std::make_unique<RootBatchEventsOutputer>(*fileName,iNLanes, *compression, compressionLevel, *serialization, autoFlush, treeMaxVirtualSize, fileLevelCompression, fileLevelCompressionLevel, batchSize);
+      return std::make_unique<RootBatchEventsOutputer>(*fileName,iNLanes, *compression, compressionLevel, *zstdParameters, *serialization, autoFlush, treeMaxVirtualSize, fileLevelCompression, fileLevelCompressionLevel, batchSize, *compressionBlockSize,
+                                                       std::move(*adaptiveLevel));
     }
     
   };
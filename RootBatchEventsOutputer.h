@@ -6,6 +6,7 @@
 #include <cstdint>
 #include <tuple>
 #include <atomic>
+#include <memory>
 #include "TFile.h"
 #include "TTree.h"
 #include "TBranch.h"
@@ -15,16 +16,18 @@
 #include "SerializeStrategy.h"
 #include "DataProductRetriever.h"
 #include "pds_writer.h"
+#include "AdaptiveCompressionLevel.h"
 
 #include "SerialTaskQueue.h"
 
 namespace cce::tf {
 class RootBatchEventsOutputer :public OutputerBase {
  public:
-  RootBatchEventsOutputer(std::string const& iFileName, unsigned int iNLanes, pds::Compression iCompression, int iCompressionLevel, 
+  RootBatchEventsOutputer(std::string const& iFileName, unsigned int iNLanes, pds::Compression iCompression, int iCompressionLevel, pds::ZSTDParameters const& iZSTDParameters, 
                           pds::Serialization iSerialization, int autoFlush, int maxVirtualSize,
                           std::string const& iTFileCompression, int iTFileCompressionLevel,
-                          uint32_t iBatchSize);
+                          uint32_t iBatchSize, uint32_t iCompressionBlockSize,
+                          std::unique_ptr<AdaptiveCompressionLevel> iAdaptiveLevel);
  ~RootBatchEventsOutputer();
 
   void setupForLane(unsigned int iLaneIndex, std::vector<DataProductRetriever> const& iDPs) final;
@@ -39,12 +42,13 @@ class RootBatchEventsOutputer :public OutputerBase {
  private:
   void finishBatchAsync(unsigned int iBatchIndex, TaskHolder iCallback);
 
-  void output(std::vector<EventIdentifier> iEventIDs, std::vector<char>  iBuffer, std::vector<uint32_t> iOffset);
+  void output(std::vector<EventIdentifier> iEventIDs, std::vector<char>  iBuffer, std::vector<uint32_t> iOffset, int iCompressionLevel);
   void writeMetaData(SerializeStrategy const& iSerializers);
 
   std::pair<std::vector<uint32_t>,std::vector<char>> writeDataProductsToOutputBuffer(SerializeStrategy const& iSerializers) const;
 
-  std::vector<char> compressBuffer(std::vector<char> const& iBuffer) const;
+  //without compression iBuffer is passed through rather than copied
+  std::vector<char> compressBuffer(std::vector<char>&& iBuffer, int iCompressionLevel) const;
 
 private:
   mutable TFile file_;
@@ -57,6 +61,8 @@ private:
   //objects used by the TBranches
   mutable std::pair<std::vector<uint32_t>, std::vector<char>> offsetsAndBlob_;
   mutable std::vector<EventIdentifier> eventIDs_;
+  //only stored when adaptiveLevel_ is used
+  int compressionLevelUsed_;
 
   //This is used as a circular buffer of length nLanes but only entries being used exist
   using EventInfo = std::tuple<EventIdentifier, std::vector<uint32_t>, std::vector<char>>;
@@ -66,9 +72,16 @@ private:
   mutable std::atomic<uint64_t> presentEventEntry_;
 
   uint32_t batchSize_;
+  //if not 0, the batch is compressed as independent blocks of this many bytes using multiple tasks
+  uint32_t compressionBlockSize_;
   pds::Compression compression_;
   int compressionLevel_;
+  //nullptr unless the compression level is changed at run time
+  std::unique_ptr<AdaptiveCompressionLevel> adaptiveLevel_;
+  pds::ZSTDParameters zstdParameters_;
   pds::Serialization serialization_;
+  //time spent building what the serializers of all lanes share
+  std::chrono::microseconds serializerSetupTime_ = std::chrono::microseconds::zero();
   mutable std::chrono::microseconds serialTime_;
   mutable std::atomic<std::chrono::microseconds::rep> parallelTime_;
 };
@@ -1,7 +1,10 @@
 #include "RootEventOutputer.h"
 #include "OutputerFactory.h"
 #include "ConfigurationParameters.h"
+#include "CompressionConfig.h"
 #include "UnrolledSerializerWrapper.h"
+#include "GeneratedSerializerWrapper.h"
+#include "NativeSerializerWrapper.h"
 #include "SerializerWrapper.h"
 #include "summarize_serializers.h"
 #include "lz4.h"
@@ -13,16 +16,29 @@
 using namespace cce::tf;
 using namespace cce::tf::pds;
 
-RootEventOutputer::RootEventOutputer(std::string const& iFileName, unsigned int iNLanes, Compression iCompression, int iCompressionLevel, 
+RootEventOutputer::RootEventOutputer(std::string const& iFileName, unsigned int iNLanes, Compression iCompression, int iCompressionLevel, ZSTDParameters const& iZSTDParameters, 
                                      Serialization iSerialization, int autoFlush, int maxVirtualSize,
-                                     std::string const& iTFileCompression, int iTFileCompressionLevel): 
+                                     std::string const& iTFileCompression, int iTFileCompressionLevel, bool iUseEventArena, std::size_t iParallelChunkSize,
+                                     std::size_t iDictionarySize, unsigned int iDictionaryTrainingEvents,
+                                     std::unique_ptr<AdaptiveCompressionLevel> iAdaptiveLevel): 
   file_(iFileName.c_str(), "recreate", "", iTFileCompressionLevel),
   serializers_{std::size_t(iNLanes)},
+  arenas_(iUseEventArena ? std::size_t(iNLanes) : std::size_t(0)),
+  addresses_{std::size_t(iNLanes)},
   compression_{iCompression},
   compressionLevel_{iCompressionLevel},
+  adaptiveLevel_{std::move(iAdaptiveLevel)},
+  compressionLevelUsed_{iCompressionLevel},
+  zstdParameters_{iZSTDParameters},
   serialization_{iSerialization},
+  useEventArena_{iUseEventArena},
+  parallelChunkSize_{iParallelChunkSize},
+  dictionarySize_{iDictionarySize},
+  dictionaryTrainingEvents_{iDictionaryTrainingEvents},
   serialTime_{std::chrono::microseconds::zero()},
-  parallelTime_{0}
+  parallelTime_{0},
+  uncompressedBytes_{0},
+  compressedBytes_{0}
   {
 
   if(not iTFileCompression.empty()) {
@@ -46,6 +62,9 @@ RootEventOutputer::RootEventOutputer(std::string const& iFileName, unsigned int
 
     eventsTree_->Branch("offsetsAndBlob", &offsetsAndBlob_);
     eventsTree_->Branch("EventID", &eventID_, "run/i:lumi/i:event/l");
+    if(adaptiveLevel_) {
+      eventsTree_->Branch("compressionLevel", &compressionLevelUsed_);
+    }
 
     //Turn off auto save
     eventsTree_->SetAutoSave(std::numeric_limits<Long64_t>::max());
@@ -69,11 +88,21 @@ void RootEventOutputer::setupForLane(unsigned int iLaneIndex, std::vector<DataPr
     {   s = SerializeStrategy::make<SerializeProxy<SerializerWrapper>>(); break; }
   case Serialization::kRootUnrolled:
     {   s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>(); break; }
+  case Serialization::kGenerated:
+    {   s = SerializeStrategy::make<SerializeProxy<GeneratedSerializerWrapper>>(); break; }
+  case Serialization::kNative:
+    {   s = SerializeStrategy::make<SerializeProxy<NativeSerializerWrapper>>(); break; }
+  }
+  if(iLaneIndex == 0) {
+    serializerSetupTime_ = prepareSharedSerializers(serialization_, iDPs);
   }
   s.reserve(iDPs.size());
   offsetsAndBlob_.first.resize(iDPs.size()+1,0);
   for(auto const& dp: iDPs) {
-    s.emplace_back(dp.name(), dp.classType());
+    s.emplace_back(dp.name(), dp.classType()).setParallelChunkSize(parallelChunkSize_);
+  }
+  if(useEventArena_) {
+    addresses_[iLaneIndex].resize(iDPs.size(), nullptr);
   }
 
   if(iLaneIndex == 0) {
@@ -83,6 +112,11 @@ void RootEventOutputer::setupForLane(unsigned int iLaneIndex, std::vector<DataPr
 }
 
 void RootEventOutputer::productReadyAsync(unsigned int iLaneIndex, DataProductRetriever const& iDataProduct, TaskHolder iCallback) const {
+  if(useEventArena_) {
+    //serialization is done in outputAsync, iCallback is released when it goes out of scope
+    addresses_[iLaneIndex][iDataProduct.index()] = iDataProduct.address();
+    return;
+  }
   auto& laneSerializers = serializers_[iLaneIndex];
   auto group = iCallback.group();
   laneSerializers[iDataProduct.index()].doWorkAsync(*group, iDataProduct.address(), std::move(iCallback));
@@ -90,10 +124,20 @@ void RootEventOutputer::productReadyAsync(unsigned int iLaneIndex, DataProductRe
 
 void RootEventOutputer::outputAsync(unsigned int iLaneIndex, EventIdentifier const& iEventID, TaskHolder iCallback) const {
   auto start = std::chrono::high_resolution_clock::now();
-  auto [offsets, buffer] = writeDataProductsToOutputBuffer(serializers_[iLaneIndex]);
-  queue_.push(*iCallback.group(), [this, iEventID, iLaneIndex, callback=std::move(iCallback), buffer = std::move(buffer), offsets = std::move(offsets)]() mutable {
+  //until the dictionary is trained the events are held uncompressed
+  bool const compress = not useDictionary() or dictionaryReady_.load();
+  int const level = chooseCompressionLevel();
+  auto [offsets, buffer] = useEventArena_ ? writeDataProductsToEventArena(iLaneIndex, compress, level) :
+                                            writeDataProductsToOutputBuffer(serializers_[iLaneIndex], compress, level);
+  if(adaptiveLevel_) {
+    adaptiveLevel_->pushedToWriter();
+  }
+  queue_.push(*iCallback.group(), [this, iEventID, iLaneIndex, compress, level, callback=std::move(iCallback), buffer = std::move(buffer), offsets = std::move(offsets)]() mutable {
+      if(adaptiveLevel_) {
+        adaptiveLevel_->takenByWriter();
+      }
       auto start = std::chrono::high_resolution_clock::now();
-      const_cast<RootEventOutputer*>(this)->output(iEventID, serializers_[iLaneIndex],std::move(buffer), std::move(offsets));
+      const_cast<RootEventOutputer*>(this)->output(iEventID, serializers_[iLaneIndex],std::move(buffer), std::move(offsets), compress, level);
         serialTime_ += std::chrono::duration_cast<decltype(serialTime_)>(std::chrono::high_resolution_clock::now() - start);
       callback.doneWaiting();
     });
@@ -102,8 +146,19 @@ void RootEventOutputer::outputAsync(unsigned int iLaneIndex, EventIdentifier con
 }
 
 void RootEventOutputer::printSummary() const  {
+  if(not pendingEvents_.empty()) {
+    //fewer events than dictionaryTrainingEvents_ were processed
+    const_cast<RootEventOutputer*>(this)->writePendingEvents();
+  }
   std::cout <<"RootEventOutputer\n  total serial time at end event: "<<serialTime_.count()<<"us\n"
-    "  total parallel time at end event: "<<parallelTime_.load()<<"us\n";
+    "  total parallel time at end event: "<<parallelTime_.load()<<"us\n"
+    "  serializer setup time: "<<serializerSetupTime_.count()<<"us\n";
+  if(compressedBytes_.load() != 0) {
+    std::cout <<"  compression ratio: "<<double(uncompressedBytes_.load())/compressedBytes_.load()<<"\n";
+  }
+  if(adaptiveLevel_) {
+    adaptiveLevel_->printSummary(std::cout);
+  }
 
   auto start = std::chrono::high_resolution_clock::now();
   file_.Write();
@@ -121,12 +176,23 @@ void RootEventOutputer::printSummary() const  {
 
 
 
-void RootEventOutputer::output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<char> iBuffer, std::vector<uint32_t> iOffsets) {
+void RootEventOutputer::output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<char> iBuffer, std::vector<uint32_t> iOffsets, bool iCompressed, int iCompressionLevel) {
+  if(not iCompressed) {
+    if(not dictionaryReady_.load()) {
+      pendingEvents_.push_back({iEventID, std::move(iOffsets), std::move(iBuffer)});
+      if(pendingEvents_.size() >= dictionaryTrainingEvents_) {
+        writePendingEvents();
+      }
+      return;
+    }
+    iBuffer = compressBuffer(std::move(iBuffer), iCompressionLevel);
+  }
   //using namespace std::string_literals;
   
   //std::cout <<"   run:"s+std::to_string(iEventID.run)+" lumi:"s+std::to_string(iEventID.lumi)+" event:"s+std::to_string(iEventID.event)+"\n"<<std::flush;
   
   eventID_ = iEventID;
+  compressionLevelUsed_ = iCompressionLevel;
   offsetsAndBlob_.first = std::move(iOffsets);
   offsetsAndBlob_.second = std::move(iBuffer);
   //std::cout <<"Event "<<eventID_.run<<" "<<eventID_.lumi<<" "<<eventID_.event<<std::endl;
@@ -142,6 +208,25 @@ void RootEventOutputer::output(EventIdentifier const& iEventID, SerializeStrateg
   */
 }
 
+void RootEventOutputer::writePendingEvents() {
+  std::vector<Span<char const>> samples;
+  samples.reserve(pendingEvents_.size());
+  for(auto const& e: pendingEvents_) {
+    samples.emplace_back(e.buffer_);
+  }
+  dictionary_ = pds::CompressionDictionary::train(samples, dictionarySize_, compressionLevel_);
+  dictionaryReady_.store(true);
+  if(not dictionary_.empty()) {
+    file_.WriteObject(&dictionary_.bytes(), "compressionDictionary");
+  }
+
+  auto pending = std::move(pendingEvents_);
+  pendingEvents_.clear();
+  for(auto& e: pending) {
+    output(e.eventID_, serializers_[0], std::move(e.buffer_), std::move(e.offsets_), false, compressionLevel_);
+  }
+}
+
 void RootEventOutputer::writeMetaData(SerializeStrategy const& iSerializers) {
 
   std::vector<std::pair<std::string, std::string>> typeAndNames;
@@ -165,7 +250,7 @@ void RootEventOutputer::writeMetaData(SerializeStrategy const& iSerializers) {
 
 }
 
-std::pair<std::vector<uint32_t>, std::vector<char>> RootEventOutputer::writeDataProductsToOutputBuffer(SerializeStrategy const& iSerializers) const{
+std::pair<std::vector<uint32_t>, std::vector<char>> RootEventOutputer::writeDataProductsToOutputBuffer(SerializeStrategy const& iSerializers, bool iCompress, int iCompressionLevel) const{
   //Calculate buffer size needed
   uint32_t bufferSize = 0;
   std::vector<uint32_t> offsets;
@@ -190,15 +275,58 @@ std::pair<std::vector<uint32_t>, std::vector<char>> RootEventOutputer::writeData
     assert(buffer.size() == offsets[index]);
   }
 
-  auto cBuffer  = compressBuffer(buffer);
+  if(not iCompress) {
+    return {std::move(offsets), std::move(buffer)};
+  }
+  auto cBuffer  = compressBuffer(std::move(buffer), iCompressionLevel);
 
   //std::cout <<"compressed "<<cSize<<" uncompressed "<<buffer.size()<<std::endl;
   //std::cout <<"compressed "<<(buffer.size())/float(cSize)<<std::endl;
-  return {offsets,cBuffer};
+  return {std::move(offsets), std::move(cBuffer)};
 }
 
-std::vector<char> RootEventOutputer::compressBuffer(std::vector<char> const& iBuffer) const {
-  return pds::compressBuffer(0, 0, compression_, compressionLevel_, iBuffer);
+std::pair<std::vector<uint32_t>, std::vector<char>> RootEventOutputer::writeDataProductsToEventArena(unsigned int iLaneIndex, bool iCompress, int iCompressionLevel) const {
+  auto& arena = arenas_[iLaneIndex];
+  auto const& addresses = addresses_[iLaneIndex];
+  arena.clear();
+
+  std::vector<uint32_t> offsets;
+  offsets.reserve(addresses.size()+1);
+  uint32_t index = 0;
+  for(auto& s: serializers_[iLaneIndex]) {
+    offsets.push_back(arena.size());
+    s.serialize(addresses[index++], arena);
+  }
+  offsets.push_back(arena.size());
+
+  if(not iCompress) {
+    //the arena is reused by the lane's next event
+    return {std::move(offsets), std::vector<char>(arena.span().begin(), arena.span().end())};
+  }
+  return {std::move(offsets), compressBuffer(arena.span(), iCompressionLevel)};
+}
+
+std::vector<char> RootEventOutputer::compressBuffer(Span<char const> iBuffer, int iCompressionLevel) const {
+  auto start = std::chrono::high_resolution_clock::now();
+  auto cBuffer = pds::compressBuffer(0, 0, compression_, iCompressionLevel, iBuffer, zstdParameters_, &dictionary_);
+  if(adaptiveLevel_) {
+    adaptiveLevel_->compressed(iCompressionLevel, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start));
+  }
+  uncompressedBytes_ += iBuffer.size();
+  compressedBytes_ += cBuffer.size();
+  return cBuffer;
+}
+
+std::vector<char> RootEventOutputer::compressBuffer(std::vector<char>&& iBuffer, int iCompressionLevel) const {
+  auto start = std::chrono::high_resolution_clock::now();
+  auto const uncompressedSize = iBuffer.size();
+  auto cBuffer = pds::compressBuffer(0, 0, compression_, iCompressionLevel, std::move(iBuffer), zstdParameters_, &dictionary_);
+  if(adaptiveLevel_) {
+    adaptiveLevel_->compressed(iCompressionLevel, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start));
+  }
+  uncompressedBytes_ += uncompressedSize;
+  compressedBytes_ += cBuffer.size();
+  return cBuffer;
 }
 
 namespace {
@@ -216,6 +344,10 @@ namespace {
       }
 
       int compressionLevel = params.get<int>("compressionLevel", 18);
+      auto zstdParameters = parseZSTDParameters(params);
+      if(not zstdParameters) {
+        return {};
+      }
 
       auto compressionName = params.get<std::string>("compressionAlgorithm", "ZSTD");
       auto serializationName = params.get<std::string>("serializationAlgorithm", "ROOT");
@@ -237,8 +369,32 @@ namespace {
 
       auto fileLevelCompression = params.get<std::string>("tfileCompressionAlgorithm", "");
       auto fileLevelCompressionLevel = params.get<int>("tfileCompressionLevel",0);
+      auto useEventArena = params.get<bool>("useEventArena", false);
+      auto parallelChunkSize = params.get<std::size_t>("parallelChunkSize", 0);
+
+      auto dictionarySize = params.get<std::size_t>("dictionarySize", 0);
+      auto dictionaryTrainingEvents = params.get<unsigned int>("dictionaryTrainingEvents", 100);
+      if(dictionarySize != 0 and *compression != pds::Compression::kZSTD) {
+        std::cout <<"dictionarySize can only be used with ZSTD compression"<<std::endl;
+        return {};
+      }
+      if(dictionarySize != 0 and dictionaryTrainingEvents == 0) {
+        std::cout <<"dictionaryTrainingEvents must be greater than 0"<<std::endl;
+        return {};
+      }
+
+      auto adaptiveLevel = makeAdaptiveCompressionLevel(params, *compression, compressionLevel);
+      if(not adaptiveLevel) {
+        return {};
+      }
+      if(*adaptiveLevel and dictionarySize != 0) {
+        //the dictionary is prepared for one compression level
+        std::cout <<"adaptiveCompression can not be used with dictionarySize"<<std::endl;
+        return {};
+      }
       
-      return std::make_unique<RootEventOutputer>(*fileName,iNLanes, *compression, compressionLevel, *serialization, autoFlush, treeMaxVirtualSize, fileLevelCompression, fileLevelCompressionLevel);
+      return std::make_unique<RootEventOutputer>(*fileName,iNLanes, *compression, compressionLevel, *zstdParameters, *serialization, autoFlush, treeMaxVirtualSize, fileLevelCompression, fileLevelCompressionLevel, useEventArena, parallelChunkSize,
+                                                 dictionarySize, dictionaryTrainingEvents, std::move(*adaptiveLevel));
     }
     
   };
@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <atomic>
+#include <memory>
 #include "TFile.h"
 #include "TTree.h"
 #include "TBranch.h"
@@ -12,16 +14,21 @@
 #include "EventIdentifier.h"
 #include "SerializeStrategy.h"
 #include "DataProductRetriever.h"
+#include "EventArena.h"
+#include "Span.h"
 #include "pds_writer.h"
+#include "AdaptiveCompressionLevel.h"
 
 #include "SerialTaskQueue.h"
 
 namespace cce::tf {
 class RootEventOutputer :public OutputerBase {
  public:
-  RootEventOutputer(std::string const& iFileName, unsigned int iNLanes, pds::Compression iCompression, int iCompressionLevel, 
+  RootEventOutputer(std::string const& iFileName, unsigned int iNLanes, pds::Compression iCompression, int iCompressionLevel, pds::ZSTDParameters const& iZSTDParameters, 
                     pds::Serialization iSerialization, int autoFlush, int maxVirtualSize,
-                    std::string const& iTFileCompression, int iTFileCompressionLevel);
+                    std::string const& iTFileCompression, int iTFileCompressionLevel, bool iUseEventArena, std::size_t iParallelChunkSize,
+                    std::size_t iDictionarySize, unsigned int iDictionaryTrainingEvents,
+                    std::unique_ptr<AdaptiveCompressionLevel> iAdaptiveLevel);
  ~RootEventOutputer();
 
   void setupForLane(unsigned int iLaneIndex, std::vector<DataProductRetriever> const& iDPs) final;
@@ -34,12 +41,22 @@ class RootEventOutputer :public OutputerBase {
   void printSummary() const final;
 
  private:
-  void output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<char>  iBuffer, std::vector<uint32_t> iOffset);
+  //iCompressed is false if iBuffer holds the uncompressed data products of an event waiting for the dictionary
+  void output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<char>  iBuffer, std::vector<uint32_t> iOffset, bool iCompressed, int iCompressionLevel);
   void writeMetaData(SerializeStrategy const& iSerializers);
+  //trains the dictionary from the pending events, stores it in the file then writes the events
+  void writePendingEvents();
+  bool useDictionary() const { return dictionarySize_ != 0; }
 
-  std::pair<std::vector<uint32_t>,std::vector<char>> writeDataProductsToOutputBuffer(SerializeStrategy const& iSerializers) const;
+  //if iCompress is false the uncompressed data products are returned
+  std::pair<std::vector<uint32_t>,std::vector<char>> writeDataProductsToOutputBuffer(SerializeStrategy const& iSerializers, bool iCompress, int iCompressionLevel) const;
+  //serializes all data products of the lane directly into the lane's EventArena
+  std::pair<std::vector<uint32_t>,std::vector<char>> writeDataProductsToEventArena(unsigned int iLaneIndex, bool iCompress, int iCompressionLevel) const;
 
-  std::vector<char> compressBuffer(std::vector<char> const& iBuffer) const;
+  std::vector<char> compressBuffer(Span<char const> iBuffer, int iCompressionLevel) const;
+  //without compression iBuffer is passed through rather than copied
+  std::vector<char> compressBuffer(std::vector<char>&& iBuffer, int iCompressionLevel) const;
+  int chooseCompressionLevel() const { return adaptiveLevel_ ? adaptiveLevel_->level() : compressionLevel_; }
 
 private:
   mutable TFile file_;
@@ -48,13 +65,38 @@ private:
 
   mutable SerialTaskQueue queue_;
   mutable std::vector<SerializeStrategy> serializers_;
+  mutable std::vector<EventArena> arenas_;
+  mutable std::vector<std::vector<void**>> addresses_;
   mutable std::pair<std::vector<uint32_t>, std::vector<char>> offsetsAndBlob_;
   EventIdentifier eventID_;
   pds::Compression compression_;
   int compressionLevel_;
+  //nullptr unless the compression level is changed at run time
+  std::unique_ptr<AdaptiveCompressionLevel> adaptiveLevel_;
+  //stored with each event when adaptiveLevel_ is used
+  int compressionLevelUsed_;
+  pds::ZSTDParameters zstdParameters_;
   pds::Serialization serialization_;
+  bool useEventArena_;
+  std::size_t parallelChunkSize_;
+  //if not 0, the maximum size in bytes of the ZSTD dictionary trained from the first events
+  std::size_t dictionarySize_;
+  unsigned int dictionaryTrainingEvents_;
+  //set once dictionary_ is filled, after which it is never changed
+  std::atomic<bool> dictionaryReady_{false};
+  pds::CompressionDictionary dictionary_;
+  struct PendingEvent {
+    EventIdentifier eventID_;
+    std::vector<uint32_t> offsets_;
+    std::vector<char> buffer_;
+  };
+  std::vector<PendingEvent> pendingEvents_;
+  //time spent building what the serializers of all lanes share
+  std::chrono::microseconds serializerSetupTime_ = std::chrono::microseconds::zero();
   mutable std::chrono::microseconds serialTime_;
   mutable std::atomic<std::chrono::microseconds::rep> parallelTime_;
+  mutable std::atomic<std::size_t> uncompressedBytes_;
+  mutable std::atomic<std::size_t> compressedBytes_;
 };
 }
 #endif
@@ -39,7 +39,7 @@ namespace {
   public:
     Maker(): WaiterMakerBase("ScaleWaiter") {}
 
-    std::unique_ptr<WaiterBase> create(unsigned int iNLanes, std::size_t iNDataProducts, ConfigurationParameters const& params) const final {
+    std::unique_ptr<WaiterBase> create(unsigned int iNLanes, std::vector<DataProductRetriever> const& iDataProducts, ConfigurationParameters const& params) const final {
 
       auto scale = params.get<float>("scale", 0);
 
@@ -1,3 +1,19 @@
 #include "SerializeStrategy.h"
+#include "common_unrolling.h"
 
 cce::tf::SerializeProxyBase::~SerializeProxyBase() = default;
+
+std::chrono::microseconds cce::tf::prepareSharedSerializers(pds::Serialization iSerialization, std::vector<DataProductRetriever> const& iDPs) {
+  //only the unrolled and generated serializers use the action sequences
+  if(iSerialization != pds::Serialization::kRootUnrolled and iSerialization != pds::Serialization::kGenerated) {
+    return std::chrono::microseconds::zero();
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  std::vector<TClass*> classes;
+  classes.reserve(iDPs.size());
+  for(auto const& dp: iDPs) {
+    classes.push_back(dp.classType());
+  }
+  unrolling::fillWriteActionSequenceCache(classes);
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+}
@@ -10,6 +10,10 @@
 
 #include "TaskHolder.h"
 #include "ProxyVector.h"
+#include "Span.h"
+#include "EventArena.h"
+#include "DataProductRetriever.h"
+#include "pds_common.h"
 
 namespace cce::tf {
 class SerializeProxyBase {
@@ -19,7 +23,10 @@ class SerializeProxyBase {
  virtual ~SerializeProxyBase();
 
  virtual void doWorkAsync(tbb::task_group& iGroup, void** iAddress, TaskHolder iCallback) = 0;
- virtual std::vector<char> const& blob() const = 0;
+ virtual std::size_t serialize(void** iAddress, EventArena& iArena) = 0;
+ virtual Span<char const> blob() const = 0;
+ //collections of builtins larger than iBytes are serialized using multiple tasks, 0 turns this off
+ virtual void setParallelChunkSize(std::size_t iBytes) = 0;
 
  virtual std::string_view  name() const = 0;
  virtual char const* className() const = 0;
@@ -36,7 +43,9 @@ class SerializeProxy final : public SerializeProxyBase {
   void doWorkAsync(tbb::task_group& iGroup, void** iAddress, TaskHolder iCallback) {
     wrapper_.doWorkAsync(iGroup, iAddress, iCallback);
   }
-  std::vector<char> const& blob() const { return wrapper_.blob(); }
+  std::size_t serialize(void** iAddress, EventArena& iArena) { return wrapper_.serialize(iAddress, iArena); }
+  Span<char const> blob() const { return wrapper_.blob(); }
+  void setParallelChunkSize(std::size_t iBytes) { wrapper_.setParallelChunkSize(iBytes); }
 
   std::string_view  name() const { return wrapper_.name();}
   char const* className() const { return wrapper_.className();}
@@ -48,5 +57,9 @@ class SerializeProxy final : public SerializeProxyBase {
 
  using SerializeStrategy = ProxyVector<SerializeProxyBase, std::string_view, TClass*>;
 
+ //Builds, using multiple tasks, the write action sequences the iSerialization serializers of iDPs use.
+ // The sequences are shared by all lanes so this only needs to be called for one lane. Returns the time it took.
+ std::chrono::microseconds prepareSharedSerializers(pds::Serialization iSerialization, std::vector<DataProductRetriever> const& iDPs);
+
 }
 #endif
@@ -1,9 +1,9 @@
 #if !defined(Serializer_h)
 #define Serializer_h
 
-#include <vector>
 #include "TBufferFile.h"
 #include "TClass.h"
+#include "Span.h"
 
 namespace cce::tf {
 class Serializer {
@@ -16,12 +16,17 @@ public:
   Serializer(Serializer const&):
     bufferFile_{TBuffer::kWrite} {}
 
-  std::vector<char> serialize(void const* address, TClass* tClass) {
+  //The returned Span refers to the internal buffer which is reused by the next call
+  Span<char const> serialize(void const* address, TClass* tClass) {
     bufferFile_.Reset();
     tClass->WriteBuffer(bufferFile_, const_cast<void*>(address));
     //The blob contains the serialized data product
-    std::vector<char> blob(bufferFile_.Buffer(), bufferFile_.Buffer()+bufferFile_.Length());
-    return blob;
+    return Span<char const>(bufferFile_.Buffer(), bufferFile_.Length());
+  }
+
+  //writes to the end of iBuffer rather than to the internal buffer
+  void serialize(void const* address, TClass* tClass, TBufferFile& iBuffer) {
+    tClass->WriteBuffer(iBuffer, const_cast<void*>(address));
   }
 
 private:
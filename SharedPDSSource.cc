@@ -2,42 +2,68 @@
 #include "SourceFactory.h"
 #include "Deserializer.h"
 #include "UnrolledDeserializer.h"
+#include "GeneratedDeserializer.h"
+#include "NativeDeserializer.h"
 
 #include "TClass.h"
 
 using namespace cce::tf;
 
-SharedPDSSource::SharedPDSSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iName) :
+SharedPDSSource::SharedPDSSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iName, std::size_t iParallelChunkSize, bool iLazy, std::size_t iDeserializeGroupSize, bool iRecycle) :
                  SharedSourceBase(iNEvents),
                  file_{iName, std::ios_base::binary},
+  deserializeGroupSize_{iDeserializeGroupSize},
   readTime_{std::chrono::microseconds::zero()}
 {
   pds::Serialization serialization;
-  auto productInfo = readFileHeader(file_, compression_, serialization);
+  std::vector<char> dictionary;
+  auto productInfo = readFileHeader(file_, compression_, serialization, layout_, dictionary, eventHeaderSizeInWords_);
+  dictionary_ = pds::DecompressionDictionary(dictionary);
+
+  //the deserializers are thread safe so all lanes share them
+  switch(serialization) {
+  case pds::Serialization::kRoot: { 
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<Deserializer>>(); break;
+  }
+  case pds::Serialization::kRootUnrolled: {
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
+  }
+  case pds::Serialization::kGenerated: {
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<GeneratedDeserializer>>(); break;
+  }
+  case pds::Serialization::kNative: {
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<NativeDeserializer>>(); break;
+  }
+  }
+  deserializers_.reserve(productInfo.size());
+  for(auto const& pi : productInfo) {
+    auto& deserializer = deserializers_.emplace_back(TClass::GetClass(pi.className().c_str()));
+    deserializer.setParallelChunkSize(iParallelChunkSize);
+    deserializer.setRecycle(iRecycle);
+  }
+
+  std::vector<uint32_t> shuffleSizes;
+  shuffleSizes.reserve(productInfo.size());
+  for(auto const& pi : productInfo) {
+    shuffleSizes.push_back(pi.shuffleSize());
+  }
 
   laneInfos_.reserve(iNLanes);
   for(unsigned int i = 0; i< iNLanes; ++i) {
-    DeserializeStrategy strategy;
-    switch(serialization) {
-    case pds::Serialization::kRoot: { 
-      strategy = DeserializeStrategy::make<DeserializeProxy<Deserializer>>(); break;
+    laneInfos_.emplace_back(productInfo, deserializers_, iLazy);
+    if(layout_ == pds::Layout::kProduct) {
+      laneInfos_.back().delayedRetriever_.setCompression(compression_, &dictionary_, shuffleSizes);
     }
-    case pds::Serialization::kRootUnrolled: {
-      strategy = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
-    }
-    }
-    laneInfos_.emplace_back(productInfo, std::move(strategy));
   }
 }
 
-SharedPDSSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo, DeserializeStrategy deserialize):
-  deserializers_{std::move(deserialize)},
+SharedPDSSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo, DeserializeStrategy const& iDeserializers, bool iLazy):
+  delayedRetriever_{iLazy, &iDeserializers, productInfo.size()},
   decompressTime_{std::chrono::microseconds::zero()},
   deserializeTime_{std::chrono::microseconds::zero()}
 {
   dataProducts_.reserve(productInfo.size());
   dataBuffers_.resize(productInfo.size(), nullptr);
-  deserializers_.reserve(productInfo.size());
   size_t index =0;
   for(auto const& pi : productInfo) {
     
@@ -49,7 +75,6 @@ SharedPDSSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& product
                                pi.name(),
                                cls,
 			       &delayedRetriever_);
-    deserializers_.emplace_back(cls);
     ++index;
   }
 }
@@ -79,21 +104,64 @@ void SharedPDSSource::readEventAsync(unsigned int iLane, long iEventIndex,  Opti
 
       auto start = std::chrono::high_resolution_clock::now();
       std::vector<uint32_t> buffer;
+      std::optional<int> compressionLevel;
       
-      if(pds::readCompressedEventBuffer(file_, this->laneInfos_[iLane].eventID_, buffer)) {
+      if(pds::readCompressedEventBuffer(file_, this->laneInfos_[iLane].eventID_, buffer, eventHeaderSizeInWords_, &compressionLevel)) {
+        ++this->laneInfos_[iLane].nEvents_;
+        if(compressionLevel) {
+          ++eventsPerCompressionLevel_[*compressionLevel];
+        }
         //last entry in buffer is just a crosscheck on its size
         buffer.pop_back();
         auto group = optTask.group();
-        group->run([this, buffer=std::move(buffer), task = optTask.releaseToTaskHolder(), iLane]() {
+        if(this->layout_ == pds::Layout::kProduct) {
+          //the compressed data products are only uncompressed when needed so the buffer must be kept
+          this->laneInfos_[iLane].eventBuffer_ = std::move(buffer);
+          group->run([this, task = optTask.releaseToTaskHolder(), iLane]() {
+              auto& laneInfo = this->laneInfos_[iLane];
+              auto& retriever = laneInfo.delayedRetriever_;
+              pds::findCompressedDataProducts(laneInfo.eventBuffer_, retriever.compressedProducts());
+              if(retriever.lazy()) {
+                return;
+              }
+              retriever.uncompressAll();
+              if(this->deserializeGroupSize_ != 0) {
+                retriever.deserializeAllAsync(laneInfo.dataProducts_, this->deserializeGroupSize_, task);
+                return;
+              }
+              auto start = std::chrono::high_resolution_clock::now();
+              auto const& products = retriever.products();
+              for(size_t index = 0; index < products.size(); ++index) {
+                if(products[index].data() != nullptr) {
+                  laneInfo.dataProducts_[index].setSize(this->deserializers_[index].deserialize(products[index].data(), products[index].size(), *laneInfo.dataProducts_[index].address()));
+                }
+              }
+              laneInfo.deserializeTime_ += 
+                std::chrono::duration_cast<decltype(laneInfo.deserializeTime_)>(std::chrono::high_resolution_clock::now() - start);
+            });
+          readTime_ +=std::chrono::duration_cast<decltype(readTime_)>(std::chrono::high_resolution_clock::now() - start);
+          return;
+        }
+        //without compression the data products are used directly from the buffer so it must be kept
+        this->laneInfos_[iLane].eventBuffer_ = std::move(buffer);
+        group->run([this, task = optTask.releaseToTaskHolder(), iLane]() {
             auto& laneInfo = this->laneInfos_[iLane];
 
             auto start = std::chrono::high_resolution_clock::now();
-            std::vector<uint32_t> uBuffer = pds::uncompressEventBuffer(this->compression_, buffer);
+            auto uBuffer = pds::uncompressEventBuffer(this->compression_, laneInfo.eventBuffer_, laneInfo.uncompressedBuffer_, &this->dictionary_);
             laneInfo.decompressTime_ += 
               std::chrono::duration_cast<decltype(laneInfo.decompressTime_)>(std::chrono::high_resolution_clock::now() - start);
             
+            if(laneInfo.delayedRetriever_.lazy() or this->deserializeGroupSize_ != 0) {
+              pds::findDataProducts(uBuffer, laneInfo.delayedRetriever_.products());
+              if(not laneInfo.delayedRetriever_.lazy()) {
+                laneInfo.delayedRetriever_.deserializeAllAsync(laneInfo.dataProducts_, this->deserializeGroupSize_, task);
+              }
+              //else data products are deserialized when asked for
+              return;
+            }
             start = std::chrono::high_resolution_clock::now();
-            pds::deserializeDataProducts(uBuffer.begin(), uBuffer.end(), laneInfo.dataProducts_, laneInfo.deserializers_);
+            pds::deserializeDataProducts(uBuffer, laneInfo.dataProducts_, this->deserializers_);
             laneInfo.deserializeTime_ += 
               std::chrono::duration_cast<decltype(laneInfo.deserializeTime_)>(std::chrono::high_resolution_clock::now() - start);
           });
@@ -106,7 +174,12 @@ void SharedPDSSource::printSummary() const {
   std::cout <<"\nSource:\n"
     "   read time: "<<readTime().count()<<"us\n"
     "   decompress time: "<<decompressTime().count()<<"us\n"
-    "   deserialize time: "<<deserializeTime().count()<<"us\n"<<std::endl;
+    "   deserialize time: "<<deserializeTime().count()<<"us\n"
+    "   deserialize allocations per event: "<<deserializeAllocationsPerEvent()<<"\n";
+  for(auto const& [level, nEvents]: eventsPerCompressionLevel_) {
+    std::cout <<"   events compressed at level "<<level<<": "<<nEvents<<"\n";
+  }
+  std::cout <<std::endl;
 };
 
 std::chrono::microseconds SharedPDSSource::readTime() const {
@@ -116,7 +189,7 @@ std::chrono::microseconds SharedPDSSource::readTime() const {
 std::chrono::microseconds SharedPDSSource::decompressTime() const {
   auto time = std::chrono::microseconds::zero();
   for(auto const& l : laneInfos_) {
-    time += l.decompressTime_;
+    time += l.decompressTime_ + l.delayedRetriever_.uncompressTime();
   }
   return time;
 }
@@ -124,11 +197,22 @@ std::chrono::microseconds SharedPDSSource::decompressTime() const {
 std::chrono::microseconds SharedPDSSource::deserializeTime() const {
   auto time = std::chrono::microseconds::zero();
   for(auto const& l : laneInfos_) {
-    time += l.deserializeTime_;
+    time += l.deserializeTime_ + l.delayedRetriever_.deserializeTime();
   }
   return time;
 }
 
+double SharedPDSSource::deserializeAllocationsPerEvent() const {
+  std::size_t allocations = 0;
+  unsigned long long nEvents = 0;
+  for(auto const& d : deserializers_) {
+    allocations += d.allocations();
+  }
+  for(auto const& l : laneInfos_) {
+    nEvents += l.nEvents_;
+  }
+  return nEvents == 0 ? 0. : double(allocations)/nEvents;
+}
 
 namespace {
     class Maker : public SourceMakerBase {
@@ -140,7 +224,11 @@ namespace {
           std::cout <<"no file name given\n";
           return {};
         }
-        return std::make_unique<SharedPDSSource>(iNLanes, iNEvents, *fileName);
+        auto parallelChunkSize = params.get<std::size_t>("parallelChunkSize", 0);
+        auto lazy = params.get<bool>("lazy", false);
+        auto deserializeGroupSize = params.get<std::size_t>("deserializeGroupSize", 0);
+        auto recycle = params.get<bool>("recycle", false);
+        return std::make_unique<SharedPDSSource>(iNLanes, iNEvents, *fileName, parallelChunkSize, lazy, deserializeGroupSize, recycle);
     }
     };
 
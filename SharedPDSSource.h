@@ -6,23 +6,21 @@
 #include <chrono>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <optional>
 
 #include "SharedSourceBase.h"
 #include "DataProductRetriever.h"
-#include "DelayedProductRetriever.h"
+#include "DeserializeDelayedRetriever.h"
 #include "SerialTaskQueue.h"
 #include "DeserializeStrategy.h"
 #include "pds_reading.h"
 
 
 namespace cce::tf {
-  class SharedPDSDelayedRetriever : public DelayedProductRetriever {
-    void getAsync(DataProductRetriever&, int index, TaskHolder) final {}
-  };
-  
   class SharedPDSSource : public SharedSourceBase {
   public:
-    SharedPDSSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iFileName);
+    SharedPDSSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iFileName, std::size_t iParallelChunkSize, bool iLazy, std::size_t iDeserializeGroupSize, bool iRecycle);
     SharedPDSSource(SharedPDSSource&&) = delete;
     SharedPDSSource(SharedPDSSource const&) = delete;
     ~SharedPDSSource() = default;
@@ -39,13 +37,20 @@ namespace cce::tf {
   std::chrono::microseconds readTime() const;
   std::chrono::microseconds decompressTime() const;
   std::chrono::microseconds deserializeTime() const;
+  double deserializeAllocationsPerEvent() const;
 
   pds::Compression compression_;
+  pds::Layout layout_;
+  std::size_t eventHeaderSizeInWords_ = pds::kEventHeaderSizeInWords;
+  //only filled for files which record the compression level of each event, only changed by queue_
+  std::map<int, unsigned long long> eventsPerCompressionLevel_;
+  //shared by all lanes, empty if the events were compressed without a dictionary
+  pds::DecompressionDictionary dictionary_;
   std::ifstream file_;
   SerialTaskQueue queue_;
 
   struct LaneInfo {
-    LaneInfo(std::vector<pds::ProductInfo> const&, DeserializeStrategy);
+    LaneInfo(std::vector<pds::ProductInfo> const&, DeserializeStrategy const&, bool iLazy);
 
     LaneInfo(LaneInfo&&) = default;
     LaneInfo(LaneInfo const&) = delete;
@@ -56,14 +61,22 @@ namespace cce::tf {
     EventIdentifier eventID_;
     std::vector<DataProductRetriever> dataProducts_;
     std::vector<void*> dataBuffers_;
-    DeserializeStrategy deserializers_; //NOTE: could be shared between lanes?
-    SharedPDSDelayedRetriever delayedRetriever_;
+    //the event as read from the file, kept while data products are lazily deserialized
+    std::vector<uint32_t> eventBuffer_;
+    //reused for each event to hold the uncompressed event
+    UninitializedBuffer<uint32_t> uncompressedBuffer_;
+    DeserializeDelayedRetriever delayedRetriever_;
     std::chrono::microseconds decompressTime_;
     std::chrono::microseconds deserializeTime_;
+    unsigned long long nEvents_ = 0;
     ~LaneInfo();
   };
 
+  //shared by all lanes
+  DeserializeStrategy deserializers_;
   std::vector<LaneInfo> laneInfos_;
+  //if not 0, data products are eagerly deserialized in separate tasks each handling at least this many bytes
+  std::size_t deserializeGroupSize_;
   std::chrono::microseconds readTime_;
   };
 }
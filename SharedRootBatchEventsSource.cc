@@ -2,16 +2,19 @@
 #include "SourceFactory.h"
 #include "Deserializer.h"
 #include "UnrolledDeserializer.h"
+#include "GeneratedDeserializer.h"
+#include "NativeDeserializer.h"
 
 #include "TClass.h"
 
 using namespace cce::tf;
 
-SharedRootBatchEventsSource::SharedRootBatchEventsSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iName) :
+SharedRootBatchEventsSource::SharedRootBatchEventsSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iName, std::size_t iDeserializeGroupSize, bool iRecycle) :
   SharedSourceBase(iNEvents),
   file_{TFile::Open(iName.c_str())},
   pEventIDs_(&eventIDs_),
   pOffsetsAndBuffer_(&offsetsAndBuffer_),
+  deserializeGroupSize_{iDeserializeGroupSize},
   readTime_{std::chrono::microseconds::zero()}
 {
 
@@ -77,17 +80,25 @@ SharedRootBatchEventsSource::SharedRootBatchEventsSource(unsigned int iNLanes, u
     compressionBranch->GetEntry(0);
     //std::cout <<"compressionAlgorithm "<<compression<<std::endl;
   }
+  {
+    //older files do not have the branch
+    auto blockSizeBranch = meta->GetBranch("compressionBlockSize");
+    if(blockSizeBranch) {
+      uint32_t compressionBlockSize = 0;
+      blockSizeBranch->SetAddress(&compressionBlockSize);
+      blockSizeBranch->GetEntry(0);
+      compressedInBlocks_ = compressionBlockSize != 0;
+    }
+  }
 
   assert(objectSerializationUsed == static_cast<int>(pds::Serialization::kRoot) or 
-         objectSerializationUsed == static_cast<int>(pds::Serialization::kRootUnrolled));
+         objectSerializationUsed == static_cast<int>(pds::Serialization::kRootUnrolled) or
+         objectSerializationUsed == static_cast<int>(pds::Serialization::kGenerated) or
+         objectSerializationUsed == static_cast<int>(pds::Serialization::kNative));
   pds::Serialization serialization{objectSerializationUsed};
 
-  if (compression == "None") {
-    compression_ = pds::Compression::kNone;
-  }else if (compression == "LZ4") {
-    compression_ = pds::Compression::kLZ4;
-  }else if (compression == "ZSTD") {
-    compression_ = pds::Compression::kZSTD;
+  if(auto c = pds::toCompression(compression); c and not compression.empty()) {
+    compression_ = *c;
   } else {
     std::cout <<"Unknown compression algorithm '"<<compression<<"'"<<std::endl;
     throw std::runtime_error("unknown compression algorithm");
@@ -102,31 +113,42 @@ SharedRootBatchEventsSource::SharedRootBatchEventsSource(unsigned int iNLanes, u
     }
   }
 
+  //the deserializers are thread safe so all lanes share them
+  switch(serialization) {
+  case pds::Serialization::kRoot: { 
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<Deserializer>>(); break;
+  }
+  case pds::Serialization::kRootUnrolled: {
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
+  }
+  case pds::Serialization::kGenerated: {
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<GeneratedDeserializer>>(); break;
+  }
+  case pds::Serialization::kNative: {
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<NativeDeserializer>>(); break;
+  }
+  }
+  deserializers_.reserve(productInfo.size());
+  for(auto const& pi : productInfo) {
+    auto& deserializer = deserializers_.emplace_back(TClass::GetClass(pi.className().c_str()));
+    deserializer.setRecycle(iRecycle);
+  }
+
   laneInfos_.reserve(iNLanes);
   for(unsigned int i = 0; i< iNLanes; ++i) {
-    DeserializeStrategy strategy;
-    switch(serialization) {
-    case pds::Serialization::kRoot: { 
-      strategy = DeserializeStrategy::make<DeserializeProxy<Deserializer>>(); break;
-    }
-    case pds::Serialization::kRootUnrolled: {
-      strategy = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
-    }
-    }
-    laneInfos_.emplace_back(productInfo, std::move(strategy));
+    laneInfos_.emplace_back(productInfo, deserializers_);
   }
 
 
 }
 
-SharedRootBatchEventsSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo, DeserializeStrategy deserialize):
-  deserializers_{std::move(deserialize)},
+SharedRootBatchEventsSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo, DeserializeStrategy const& iDeserializers):
+  delayedRetriever_{false, &iDeserializers, productInfo.size()},
   decompressTime_{std::chrono::microseconds::zero()},
   deserializeTime_{std::chrono::microseconds::zero()}
 {
   dataProducts_.reserve(productInfo.size());
   dataBuffers_.resize(productInfo.size(), nullptr);
-  deserializers_.reserve(productInfo.size());
   size_t index =0;
   for(auto const& pi : productInfo) {
     
@@ -138,7 +160,6 @@ SharedRootBatchEventsSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> co
                                pi.name(),
                                cls,
 			       &delayedRetriever_);
-    deserializers_.emplace_back(cls);
     ++index;
   }
 }
@@ -181,16 +202,23 @@ void SharedRootBatchEventsSource::readEventAsync(unsigned int iLane, long iEvent
             //the last entry in the offsets is the uncompressed size for that event
             summedSizes += offsetsAndBuffer_.first[(index+1)*entriesInOffset-1];
           }
-          uncompressedBuffer_ = pds::uncompressBuffer(this->compression_, offsetsAndBuffer_.second, summedSizes);
+          if(compressedInBlocks_) {
+            batchBuffer_ = pds::uncompressBufferInBlocks(this->compression_, offsetsAndBuffer_.second, summedSizes, uncompressedBuffer_);
+          } else {
+            batchBuffer_ = pds::uncompressBuffer(this->compression_, offsetsAndBuffer_.second, summedSizes, uncompressedBuffer_);
+          }
           //std::cout <<"compressed buffer size "<<offsetsAndBuffer_.second.size() <<std::endl;
-          //std::cout <<"uncompressed buffer size "<<uncompressedBuffer_.size() <<std::endl;
-          offsetsAndBuffer_.second = std::vector<char>(); //free memory
+          //std::cout <<"uncompressed buffer size "<<batchBuffer_.size() <<std::endl;
+          if(batchBuffer_.data() != offsetsAndBuffer_.second.data()) {
+            offsetsAndBuffer_.second = std::vector<char>(); //free memory
+          }
           laneInfos_[iLane].decompressTime_ += 
             std::chrono::duration_cast<decltype(laneInfos_[iLane].decompressTime_)>(std::chrono::high_resolution_clock::now() - start);
 
           cachedEventIndex_ = 0;
         }
         laneInfos_[iLane].eventID_ = eventIDs_[cachedEventIndex_];
+        ++laneInfos_[iLane].nEvents_;
         
         const auto entriesInOffset = laneInfos_[iLane].dataProducts_.size()+1;
         const unsigned int indexIntoOffsets = cachedEventIndex_*entriesInOffset;
@@ -203,10 +231,14 @@ void SharedRootBatchEventsSource::readEventAsync(unsigned int iLane, long iEvent
         }
         unsigned int endOffsetInBuffer = beginOffsetInBuffer + offsets.back();
 
-        std::vector<char> uBuffer(uncompressedBuffer_.begin()+beginOffsetInBuffer,
-                                  uncompressedBuffer_.begin()+endOffsetInBuffer);
+        std::vector<char> uBuffer(batchBuffer_.begin()+beginOffsetInBuffer,
+                                  batchBuffer_.begin()+endOffsetInBuffer);
 
         ++cachedEventIndex_;
+        if(deserializeGroupSize_ != 0) {
+          //must outlive the tasks deserializing the data products
+          laneInfos_[iLane].eventBuffer_ = std::move(uBuffer);
+        }
         /*{
            auto const& id = this->laneInfos_[iLane].eventID_;
           std::cout <<"event entry "<<nextEntry_-1<<" cache index "<<cachedEventIndex_-1<<std::endl;
@@ -222,11 +254,18 @@ void SharedRootBatchEventsSource::readEventAsync(unsigned int iLane, long iEvent
         group->run([this, offsets=std::move(offsets), uBuffer = std::move(uBuffer), task = optTask.releaseToTaskHolder(), iLane]() {
             auto& laneInfo = this->laneInfos_[iLane];
 
+            if(this->deserializeGroupSize_ != 0) {
+              pds::findDataProducts(laneInfo.eventBuffer_.data(), laneInfo.eventBuffer_.data()+laneInfo.eventBuffer_.size(), 
+                                    offsets.begin(), offsets.end(),
+                                    laneInfo.delayedRetriever_.products());
+              laneInfo.delayedRetriever_.deserializeAllAsync(laneInfo.dataProducts_, this->deserializeGroupSize_, task);
+              return;
+            }
             auto start = std::chrono::high_resolution_clock::now();
             //uBuffer.pop_back();
             pds::deserializeDataProducts(uBuffer.data(), uBuffer.data()+uBuffer.size(), 
                                          offsets.begin(), offsets.end(),
-                                         laneInfo.dataProducts_, laneInfo.deserializers_);
+                                         laneInfo.dataProducts_, this->deserializers_);
             laneInfo.deserializeTime_ += 
               std::chrono::duration_cast<decltype(laneInfo.deserializeTime_)>(std::chrono::high_resolution_clock::now() - start);
           });
@@ -239,7 +278,8 @@ void SharedRootBatchEventsSource::printSummary() const {
   std::cout <<"\nSource:\n"
     "   read time: "<<readTime().count()<<"us\n"
     "   decompress time: "<<decompressTime().count()<<"us\n"
-    "   deserialize time: "<<deserializeTime().count()<<"us\n"<<std::endl;
+    "   deserialize time: "<<deserializeTime().count()<<"us\n"
+    "   deserialize allocations per event: "<<deserializeAllocationsPerEvent()<<"\n"<<std::endl;
 };
 
 std::chrono::microseconds SharedRootBatchEventsSource::readTime() const {
@@ -257,11 +297,22 @@ std::chrono::microseconds SharedRootBatchEventsSource::decompressTime() const {
 std::chrono::microseconds SharedRootBatchEventsSource::deserializeTime() const {
   auto time = std::chrono::microseconds::zero();
   for(auto const& l : laneInfos_) {
-    time += l.deserializeTime_;
+    time += l.deserializeTime_ + l.delayedRetriever_.deserializeTime();
   }
   return time;
 }
 
+double SharedRootBatchEventsSource::deserializeAllocationsPerEvent() const {
+  std::size_t allocations = 0;
+  unsigned long long nEvents = 0;
+  for(auto const& d : deserializers_) {
+    allocations += d.allocations();
+  }
+  for(auto const& l : laneInfos_) {
+    nEvents += l.nEvents_;
+  }
+  return nEvents == 0 ? 0. : double(allocations)/nEvents;
+}
 
 namespace {
     class Maker : public SourceMakerBase {
@@ -273,7 +324,9 @@ namespace {
           std::cout <<"no file name given\n";
           return {};
         }
-        return std::make_unique<SharedRootBatchEventsSource>(iNLanes, iNEvents, *fileName);
+        auto deserializeGroupSize = params.get<std::size_t>("deserializeGroupSize", 0);
+        auto recycle = params.get<bool>("recycle", false);
+        return std::make_unique<SharedRootBatchEventsSource>(iNLanes, iNEvents, *fileName, deserializeGroupSize, recycle);
     }
     };
 
@@ -13,20 +13,16 @@
 
 #include "SharedSourceBase.h"
 #include "DataProductRetriever.h"
-#include "DelayedProductRetriever.h"
+#include "DeserializeDelayedRetriever.h"
 #include "SerialTaskQueue.h"
 #include "DeserializeStrategy.h"
 #include "pds_reading.h"
 
 
 namespace cce::tf {
-  class SharedRootBatchEventsDelayedRetriever : public DelayedProductRetriever {
-    void getAsync(DataProductRetriever&, int index, TaskHolder) final {}
-  };
-  
   class SharedRootBatchEventsSource : public SharedSourceBase {
   public:
-    SharedRootBatchEventsSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iFileName);
+    SharedRootBatchEventsSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iFileName, std::size_t iDeserializeGroupSize, bool iRecycle);
     SharedRootBatchEventsSource(SharedRootBatchEventsSource&&) = delete;
     SharedRootBatchEventsSource(SharedRootBatchEventsSource const&) = delete;
     ~SharedRootBatchEventsSource() = default;
@@ -43,8 +39,11 @@ namespace cce::tf {
   std::chrono::microseconds readTime() const;
   std::chrono::microseconds decompressTime() const;
   std::chrono::microseconds deserializeTime() const;
+  double deserializeAllocationsPerEvent() const;
 
   pds::Compression compression_;
+  //the batch was compressed as independent blocks which are uncompressed concurrently
+  bool compressedInBlocks_ = false;
   std::unique_ptr<TFile> file_;
   TTree* eventsTree_;
   TBranch* eventsBranch_;
@@ -52,7 +51,7 @@ namespace cce::tf {
   SerialTaskQueue queue_;
 
   struct LaneInfo {
-    LaneInfo(std::vector<pds::ProductInfo> const&, DeserializeStrategy);
+    LaneInfo(std::vector<pds::ProductInfo> const&, DeserializeStrategy const&);
 
     LaneInfo(LaneInfo&&) = default;
     LaneInfo(LaneInfo const&) = delete;
@@ -63,10 +62,12 @@ namespace cce::tf {
     EventIdentifier eventID_;
     std::vector<DataProductRetriever> dataProducts_;
     std::vector<void*> dataBuffers_;
-    DeserializeStrategy deserializers_; //NOTE: could be shared between lanes?
-    SharedRootBatchEventsDelayedRetriever delayedRetriever_;
+    //holds the uncompressed event while data products are deserialized in separate tasks
+    std::vector<char> eventBuffer_;
+    DeserializeDelayedRetriever delayedRetriever_;
     std::chrono::microseconds decompressTime_;
     std::chrono::microseconds deserializeTime_;
+    unsigned long long nEvents_ = 0;
     ~LaneInfo();
   };
 
@@ -76,9 +77,16 @@ namespace cce::tf {
   std::vector<EventIdentifier>* pEventIDs_;
   std::pair<std::vector<uint32_t>, std::vector<char>> offsetsAndBuffer_;
   std::pair<std::vector<uint32_t>, std::vector<char>>* pOffsetsAndBuffer_;
-  std::vector<char> uncompressedBuffer_;
+  //the uncompressed batch, refers to uncompressedBuffer_ or, without compression, offsetsAndBuffer_.second
+  Span<char const> batchBuffer_;
+  //reused for each batch
+  UninitializedBuffer<char> uncompressedBuffer_;
 
+  //shared by all lanes
+  DeserializeStrategy deserializers_;
   std::vector<LaneInfo> laneInfos_;
+  //if not 0, data products are deserialized in separate tasks each handling at least this many bytes
+  std::size_t deserializeGroupSize_;
   std::chrono::microseconds readTime_;
   };
 }
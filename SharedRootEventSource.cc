@@ -2,14 +2,17 @@
 #include "SourceFactory.h"
 #include "Deserializer.h"
 #include "UnrolledDeserializer.h"
+#include "GeneratedDeserializer.h"
+#include "NativeDeserializer.h"
 
 #include "TClass.h"
 
 using namespace cce::tf;
 
-SharedRootEventSource::SharedRootEventSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iName) :
+SharedRootEventSource::SharedRootEventSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iName, std::size_t iParallelChunkSize, bool iLazy, std::size_t iDeserializeGroupSize, bool iRecycle) :
                  SharedSourceBase(iNEvents),
                  file_{TFile::Open(iName.c_str())},
+  deserializeGroupSize_{iDeserializeGroupSize},
   readTime_{std::chrono::microseconds::zero()}
 {
 
@@ -75,20 +78,26 @@ SharedRootEventSource::SharedRootEventSource(unsigned int iNLanes, unsigned long
   }
 
   assert(objectSerializationUsed == static_cast<int>(pds::Serialization::kRoot) or 
-         objectSerializationUsed == static_cast<int>(pds::Serialization::kRootUnrolled));
+         objectSerializationUsed == static_cast<int>(pds::Serialization::kRootUnrolled) or
+         objectSerializationUsed == static_cast<int>(pds::Serialization::kGenerated) or
+         objectSerializationUsed == static_cast<int>(pds::Serialization::kNative));
   pds::Serialization serialization{objectSerializationUsed};
 
-  if (compression == "None") {
-    compression_ = pds::Compression::kNone;
-  }else if (compression == "LZ4") {
-    compression_ = pds::Compression::kLZ4;
-  }else if (compression == "ZSTD") {
-    compression_ = pds::Compression::kZSTD;
+  if(auto c = pds::toCompression(compression); c and not compression.empty()) {
+    compression_ = *c;
   } else {
     std::cout <<"Unknown compression algorithm '"<<compression<<"'"<<std::endl;
     throw std::runtime_error("unknown compression algorithm");
   }
 
+  {
+    //only stored if the events were compressed with a ZSTD dictionary
+    std::unique_ptr<std::vector<char>> dictionary{file_->Get<std::vector<char>>("compressionDictionary")};
+    if(dictionary) {
+      dictionary_ = pds::DecompressionDictionary(*dictionary);
+    }
+  }
+
   std::vector<pds::ProductInfo> productInfo;
   productInfo.reserve(typeAndNames.size());
   { 
@@ -98,31 +107,43 @@ SharedRootEventSource::SharedRootEventSource(unsigned int iNLanes, unsigned long
     }
   }
 
+  //the deserializers are thread safe so all lanes share them
+  switch(serialization) {
+  case pds::Serialization::kRoot: { 
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<Deserializer>>(); break;
+  }
+  case pds::Serialization::kRootUnrolled: {
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
+  }
+  case pds::Serialization::kGenerated: {
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<GeneratedDeserializer>>(); break;
+  }
+  case pds::Serialization::kNative: {
+    deserializers_ = DeserializeStrategy::make<DeserializeProxy<NativeDeserializer>>(); break;
+  }
+  }
+  deserializers_.reserve(productInfo.size());
+  for(auto const& pi : productInfo) {
+    auto& deserializer = deserializers_.emplace_back(TClass::GetClass(pi.className().c_str()));
+    deserializer.setParallelChunkSize(iParallelChunkSize);
+    deserializer.setRecycle(iRecycle);
+  }
+
   laneInfos_.reserve(iNLanes);
   for(unsigned int i = 0; i< iNLanes; ++i) {
-    DeserializeStrategy strategy;
-    switch(serialization) {
-    case pds::Serialization::kRoot: { 
-      strategy = DeserializeStrategy::make<DeserializeProxy<Deserializer>>(); break;
-    }
-    case pds::Serialization::kRootUnrolled: {
-      strategy = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
-    }
-    }
-    laneInfos_.emplace_back(productInfo, std::move(strategy));
+    laneInfos_.emplace_back(productInfo, deserializers_, iLazy);
   }
 
 
 }
 
-SharedRootEventSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo, DeserializeStrategy deserialize):
-  deserializers_{std::move(deserialize)},
+SharedRootEventSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo, DeserializeStrategy const& iDeserializers, bool iLazy):
+  delayedRetriever_{iLazy, &iDeserializers, productInfo.size()},
   decompressTime_{std::chrono::microseconds::zero()},
   deserializeTime_{std::chrono::microseconds::zero()}
 {
   dataProducts_.reserve(productInfo.size());
   dataBuffers_.resize(productInfo.size(), nullptr);
-  deserializers_.reserve(productInfo.size());
   size_t index =0;
   for(auto const& pi : productInfo) {
     
@@ -134,7 +155,6 @@ SharedRootEventSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& p
                                pi.name(),
                                cls,
 			       &delayedRetriever_);
-    deserializers_.emplace_back(cls);
     ++index;
   }
 }
@@ -169,6 +189,7 @@ void SharedRootEventSource::readEventAsync(unsigned int iLane, long iEventIndex,
 
         idBranch_->SetAddress(&this->laneInfos_[iLane].eventID_);
         eventsTree_->GetEntry(iEventIndex);
+        ++this->laneInfos_[iLane].nEvents_;
         {
           //auto const& id = this->laneInfos_[iLane].eventID_;
           //std::cout <<"event entry "<<iEventIndex<<std::endl;
@@ -181,20 +202,32 @@ void SharedRootEventSource::readEventAsync(unsigned int iLane, long iEventIndex,
         }
 
         auto group = optTask.group();
-        group->run([this, offsetsAndBuffer=std::move(offsetsAndBuffer), task = optTask.releaseToTaskHolder(), iLane]() {
+        //without compression the data products are used directly from the buffer so it must be kept
+        this->laneInfos_[iLane].eventBuffer_ = std::move(offsetsAndBuffer.second);
+        group->run([this, offsets=std::move(offsetsAndBuffer.first), task = optTask.releaseToTaskHolder(), iLane]() {
             auto& laneInfo = this->laneInfos_[iLane];
 
             auto start = std::chrono::high_resolution_clock::now();
-            std::vector<char> uBuffer = pds::uncompressBuffer(this->compression_, offsetsAndBuffer.second, offsetsAndBuffer.first.back());
+            auto uBuffer = pds::uncompressBuffer(this->compression_, laneInfo.eventBuffer_, offsets.back(), laneInfo.uncompressedBuffer_, &this->dictionary_);
             std::cout <<"uncompressed buffer size "<<uBuffer.size() <<std::endl;
             laneInfo.decompressTime_ += 
               std::chrono::duration_cast<decltype(laneInfo.decompressTime_)>(std::chrono::high_resolution_clock::now() - start);
             
+            if(laneInfo.delayedRetriever_.lazy() or this->deserializeGroupSize_ != 0) {
+              pds::findDataProducts(uBuffer.begin(), uBuffer.end(), 
+                                    offsets.begin(), offsets.end(),
+                                    laneInfo.delayedRetriever_.products());
+              if(not laneInfo.delayedRetriever_.lazy()) {
+                laneInfo.delayedRetriever_.deserializeAllAsync(laneInfo.dataProducts_, this->deserializeGroupSize_, task);
+              }
+              //else data products are deserialized when asked for
+              return;
+            }
             start = std::chrono::high_resolution_clock::now();
             //uBuffer.pop_back();
-            pds::deserializeDataProducts(uBuffer.data(), uBuffer.data()+uBuffer.size(), 
-                                         offsetsAndBuffer.first.begin(), offsetsAndBuffer.first.end(),
-                                         laneInfo.dataProducts_, laneInfo.deserializers_);
+            pds::deserializeDataProducts(uBuffer.begin(), uBuffer.end(), 
+                                         offsets.begin(), offsets.end(),
+                                         laneInfo.dataProducts_, this->deserializers_);
             laneInfo.deserializeTime_ += 
               std::chrono::duration_cast<decltype(laneInfo.deserializeTime_)>(std::chrono::high_resolution_clock::now() - start);
           });
@@ -207,7 +240,8 @@ void SharedRootEventSource::printSummary() const {
   std::cout <<"\nSource:\n"
     "   read time: "<<readTime().count()<<"us\n"
     "   decompress time: "<<decompressTime().count()<<"us\n"
-    "   deserialize time: "<<deserializeTime().count()<<"us\n"<<std::endl;
+    "   deserialize time: "<<deserializeTime().count()<<"us\n"
+    "   deserialize allocations per event: "<<deserializeAllocationsPerEvent()<<"\n"<<std::endl;
 };
 
 std::chrono::microseconds SharedRootEventSource::readTime() const {
@@ -225,11 +259,22 @@ std::chrono::microseconds SharedRootEventSource::decompressTime() const {
 std::chrono::microseconds SharedRootEventSource::deserializeTime() const {
   auto time = std::chrono::microseconds::zero();
   for(auto const& l : laneInfos_) {
-    time += l.deserializeTime_;
+    time += l.deserializeTime_ + l.delayedRetriever_.deserializeTime();
   }
   return time;
 }
 
+double SharedRootEventSource::deserializeAllocationsPerEvent() const {
+  std::size_t allocations = 0;
+  unsigned long long nEvents = 0;
+  for(auto const& d : deserializers_) {
+    allocations += d.allocations();
+  }
+  for(auto const& l : laneInfos_) {
+    nEvents += l.nEvents_;
+  }
+  return nEvents == 0 ? 0. : double(allocations)/nEvents;
+}
 
 namespace {
     class Maker : public SourceMakerBase {
@@ -241,7 +286,11 @@ namespace {
           std::cout <<"no file name given\n";
           return {};
         }
-        return std::make_unique<SharedRootEventSource>(iNLanes, iNEvents, *fileName);
+        auto parallelChunkSize = params.get<std::size_t>("parallelChunkSize", 0);
+        auto lazy = params.get<bool>("lazy", false);
+        auto deserializeGroupSize = params.get<std::size_t>("deserializeGroupSize", 0);
+        auto recycle = params.get<bool>("recycle", false);
+        return std::make_unique<SharedRootEventSource>(iNLanes, iNEvents, *fileName, parallelChunkSize, lazy, deserializeGroupSize, recycle);
     }
     };
 
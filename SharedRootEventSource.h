@@ -13,20 +13,16 @@
 
 #include "SharedSourceBase.h"
 #include "DataProductRetriever.h"
-#include "DelayedProductRetriever.h"
+#include "DeserializeDelayedRetriever.h"
 #include "SerialTaskQueue.h"
 #include "DeserializeStrategy.h"
 #include "pds_reading.h"
 
 
 namespace cce::tf {
-  class SharedRootEventDelayedRetriever : public DelayedProductRetriever {
-    void getAsync(DataProductRetriever&, int index, TaskHolder) final {}
-  };
-  
   class SharedRootEventSource : public SharedSourceBase {
   public:
-    SharedRootEventSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iFileName);
+    SharedRootEventSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iFileName, std::size_t iParallelChunkSize, bool iLazy, std::size_t iDeserializeGroupSize, bool iRecycle);
     SharedRootEventSource(SharedRootEventSource&&) = delete;
     SharedRootEventSource(SharedRootEventSource const&) = delete;
     ~SharedRootEventSource() = default;
@@ -43,8 +39,11 @@ namespace cce::tf {
   std::chrono::microseconds readTime() const;
   std::chrono::microseconds decompressTime() const;
   std::chrono::microseconds deserializeTime() const;
+  double deserializeAllocationsPerEvent() const;
 
   pds::Compression compression_;
+  //shared by all lanes, empty if the events were compressed without a dictionary
+  pds::DecompressionDictionary dictionary_;
   std::unique_ptr<TFile> file_;
   TTree* eventsTree_;
   TBranch* eventsBranch_;
@@ -52,7 +51,7 @@ namespace cce::tf {
   SerialTaskQueue queue_;
 
   struct LaneInfo {
-    LaneInfo(std::vector<pds::ProductInfo> const&, DeserializeStrategy);
+    LaneInfo(std::vector<pds::ProductInfo> const&, DeserializeStrategy const&, bool iLazy);
 
     LaneInfo(LaneInfo&&) = default;
     LaneInfo(LaneInfo const&) = delete;
@@ -63,14 +62,22 @@ namespace cce::tf {
     EventIdentifier eventID_;
     std::vector<DataProductRetriever> dataProducts_;
     std::vector<void*> dataBuffers_;
-    DeserializeStrategy deserializers_; //NOTE: could be shared between lanes?
-    SharedRootEventDelayedRetriever delayedRetriever_;
+    //the event as read from the file, kept while data products are lazily deserialized
+    std::vector<char> eventBuffer_;
+    //reused for each event to hold the uncompressed event
+    UninitializedBuffer<char> uncompressedBuffer_;
+    DeserializeDelayedRetriever delayedRetriever_;
     std::chrono::microseconds decompressTime_;
     std::chrono::microseconds deserializeTime_;
+    unsigned long long nEvents_ = 0;
     ~LaneInfo();
   };
 
+  //shared by all lanes
+  DeserializeStrategy deserializers_;
   std::vector<LaneInfo> laneInfos_;
+  //if not 0, data products are eagerly deserialized in separate tasks each handling at least this many bytes
+  std::size_t deserializeGroupSize_;
   std::chrono::microseconds readTime_;
   };
 }
@@ -0,0 +1,43 @@
+#if !defined(Span_h)
+#define Span_h
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace cce::tf {
+  /*---------------------------------------
+  Span is a non-owning view of a contiguous range of T. It stands in for
+  std::span which is not available in C++17. The memory referred to must
+  outlive the Span.
+  ---------------------------------------*/
+  template<typename T>
+  class Span {
+  public:
+    using value_type = T;
+    using iterator = T*;
+
+    constexpr Span() noexcept = default;
+    constexpr Span(T* iData, std::size_t iSize) noexcept: data_{iData}, size_{iSize} {}
+    constexpr Span(T* iBegin, T* iEnd) noexcept: data_{iBegin}, size_{static_cast<std::size_t>(iEnd-iBegin)} {}
+
+    //allows passing a std::vector (or similar contiguous container) where a Span is expected
+    template<typename C, typename = std::enable_if_t<not std::is_same_v<std::remove_cv_t<C>, Span> and
+                                                      std::is_convertible_v<decltype(std::declval<C&>().data()), T*>>>
+    constexpr Span(C& iContainer) noexcept: data_{iContainer.data()}, size_{iContainer.size()} {}
+
+    constexpr T* data() const noexcept { return data_; }
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+
+    constexpr T* begin() const noexcept { return data_; }
+    constexpr T* end() const noexcept { return data_+size_; }
+
+    constexpr T& operator[](std::size_t iIndex) const noexcept { return data_[iIndex]; }
+
+  private:
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+  };
+}
+#endif
@@ -28,7 +28,7 @@ void TestProductsOutputer::outputAsync(unsigned int iLaneIndex, EventIdentifier
   auto const& retrievers = *retrieverPerLane_[iLaneIndex];
 
   if (retrievers.size() != nProducts_) {
-    std::cout<<"ERROR: wrong number of data products, expected 2 but see "<<retrievers.size() <<std::endl;
+    std::cout<<"ERROR: wrong number of data products, expected "<<nProducts_<<" but see "<<retrievers.size() <<std::endl;
     abort();
   }
   auto const index = iEventID.event -1;
@@ -57,6 +57,18 @@ void TestProductsOutputer::outputAsync(unsigned int iLaneIndex, EventIdentifier
           abort();
         }
       }
+    } else if(prod.name() == "bools") {
+      std::vector<bool>* bools = reinterpret_cast<std::vector<bool>*>(*prod.address());
+      if(bools->size() != 5) {
+        std::cout <<"ERROR: bools has incorrect size "<<bools->size()<<" in event "<<iEventID.event<<std::endl;
+        abort();
+      }
+      for(int i=0; i<5; ++i) {
+        if( (*bools)[i] != ((index+i) % 3 == 0)) {
+          std::cout <<"ERROR: bools index "<<i<<" has wrong value "<<(*bools)[i]<<" in event "<<iEventID.event<<std::endl;
+          abort();
+        }
+      }
     } else {
       std::cout <<"ERROR: unknown product name "<<prod.name()<<" in event "<<iEventID.event<<std::endl;
       abort();
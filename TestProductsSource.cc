@@ -9,13 +9,15 @@ using namespace cce::tf;
 namespace {
   enum ProductIndices {
     kInts = 0,
-    kFloats = 1
+    kFloats = 1,
+    kBools = 2
   };
 }
 
-TestDelayedProductRetriever::TestDelayedProductRetriever(std::vector<int>* iInts, std::vector<float>* iFloats):
+TestDelayedProductRetriever::TestDelayedProductRetriever(std::vector<int>* iInts, std::vector<float>* iFloats, std::vector<bool>* iBools):
   ints_(iInts),
   floats_(iFloats),
+  bools_(iBools),
   eventIndex_(-1)
 {
 }
@@ -37,6 +39,15 @@ void TestDelayedProductRetriever::getAsync(DataProductRetriever& iRetriever, int
       iRetriever.setSize(sizeof(float)*3);
       break;
     }
+  case kBools:
+    {
+      bools_->clear();
+      for(long i=0; i<5; ++i) {
+        bools_->push_back( (eventIndex_+i) % 3 == 0);
+      }
+      iRetriever.setSize(sizeof(bool)*5);
+      break;
+    }
   }
   iCallback.doneWaiting();
 }
@@ -46,25 +57,30 @@ void TestDelayedProductRetriever::setEventIndex(long iIndex) {
 }
 
 
-TestProductsSource::TestProductsSource(unsigned int iNLanes, unsigned long long iNEvents):
+TestProductsSource::TestProductsSource(unsigned int iNLanes, unsigned long long iNEvents, bool iBools):
   SharedSourceBase(iNEvents),
   intsPerLane_(iNLanes),
-  floatsPerLane_(iNLanes)
+  floatsPerLane_(iNLanes),
+  boolsPerLane_(iNLanes),
+  bools_(iBools)
 {
   delayedPerLane_.reserve(iNLanes);
   retrieverPerLane_.reserve(iNLanes);
   for(unsigned int lane = 0; lane<iNLanes; ++lane) {
-    delayedPerLane_.emplace_back(&intsPerLane_[lane], &floatsPerLane_[lane]);
+    delayedPerLane_.emplace_back(&intsPerLane_[lane], &floatsPerLane_[lane], &boolsPerLane_[lane]);
     std::vector<DataProductRetriever> r;
-    r.reserve(2);
+    r.reserve(3);
     r.emplace_back(kInts, delayedPerLane_[lane].ints(), "ints", TClass::GetClass("vector<int>"), &delayedPerLane_[lane]);
     r.emplace_back(kFloats, delayedPerLane_[lane].floats(), "floats", TClass::GetClass("vector<float>"), &delayedPerLane_[lane]);
+    if(bools_) {
+      r.emplace_back(kBools, delayedPerLane_[lane].bools(), "bools", TClass::GetClass("vector<bool>"), &delayedPerLane_[lane]);
+    }
     retrieverPerLane_.emplace_back(std::move(r));
   }
 }
 
 size_t TestProductsSource::numberOfDataProducts() const {
-  return 2;
+  return bools_ ? 3 : 2;
 }
 
 std::vector<DataProductRetriever>& TestProductsSource::dataProducts(unsigned int iLane, long iEventIndex) {
@@ -89,7 +105,7 @@ namespace {
   public:
     Maker(): SourceMakerBase("TestProductsSource") {}
       std::unique_ptr<SharedSourceBase> create(unsigned int iNLanes, unsigned long long iNEvents, ConfigurationParameters const& params) const final {
-        return std::make_unique<TestProductsSource>(iNLanes, iNEvents);
+        return std::make_unique<TestProductsSource>(iNLanes, iNEvents, params.get<bool>("vectorOfBools", false));
     }
     };
 
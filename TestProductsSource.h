@@ -9,7 +9,7 @@
 namespace cce::tf {
 class TestDelayedProductRetriever : public DelayedProductRetriever {
  public:
-  TestDelayedProductRetriever(std::vector<int>*, std::vector<float>*);
+  TestDelayedProductRetriever(std::vector<int>*, std::vector<float>*, std::vector<bool>*);
 
   void getAsync(DataProductRetriever&, int index, TaskHolder iCallback) final;
 
@@ -17,16 +17,19 @@ class TestDelayedProductRetriever : public DelayedProductRetriever {
 
   void** ints() { return reinterpret_cast<void**>(&ints_);}
   void** floats() { return reinterpret_cast<void**>(&floats_);}
+  void** bools() { return reinterpret_cast<void**>(&bools_);}
 
  private:
   std::vector<int>* ints_;
   std::vector<float>* floats_;
+  std::vector<bool>* bools_;
   long eventIndex_;
 };
 
 class TestProductsSource : public SharedSourceBase {
  public:
-  TestProductsSource(unsigned int iNLanes, unsigned long long iNEvents);
+  //iBools adds a std::vector<bool> data product
+  TestProductsSource(unsigned int iNLanes, unsigned long long iNEvents, bool iBools);
 
   size_t numberOfDataProducts() const final;
   std::vector<DataProductRetriever>& dataProducts(unsigned int iLane, long iEventIndex) final;
@@ -41,6 +44,8 @@ class TestProductsSource : public SharedSourceBase {
   std::vector<std::vector<DataProductRetriever>> retrieverPerLane_;
   std::vector<std::vector<int>> intsPerLane_;
   std::vector<std::vector<float>> floatsPerLane_;
+  std::vector<std::vector<bool>> boolsPerLane_;
+  bool bools_;
 };
 }
 
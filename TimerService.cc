@@ -0,0 +1,63 @@
+#include "TimerService.h"
+#include <algorithm>
+
+using namespace cce::tf;
+
+TimerService::TimerService(): thread_([this]() { run(); }) {}
+
+TimerService::~TimerService() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_one();
+  thread_.join();
+}
+
+void TimerService::callAt(clock::time_point iDeadline, TaskHolder iCallback) {
+  //attach to the arena of the calling thread so the callback is later run by the same workers
+  auto arena = std::make_unique<tbb::task_arena>(tbb::task_arena::attach());
+  bool isEarliest;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    heap_.push_back(Entry{iDeadline, nextOrder_++, std::move(arena), std::make_unique<TaskHolder>(std::move(iCallback))});
+    std::push_heap(heap_.begin(), heap_.end(), Later());
+    isEarliest = (heap_.front().order_ +1 == nextOrder_);
+  }
+  if(isEarliest) {
+    //timer thread may be sleeping until a later deadline
+    cond_.notify_one();
+  }
+}
+
+void TimerService::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while(true) {
+    if(heap_.empty()) {
+      if(stop_) {
+        return;
+      }
+      cond_.wait(lock);
+      continue;
+    }
+    auto deadline = heap_.front().deadline_;
+    if(clock::now() < deadline) {
+      if(stop_) {
+        //do not make the end of the job wait on outstanding timers
+        deadline = clock::now();
+      } else {
+        cond_.wait_until(lock, deadline);
+        continue;
+      }
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), Later());
+    Entry entry = std::move(heap_.back());
+    heap_.pop_back();
+
+    lock.unlock();
+    entry.arena_->enqueue([callback = std::move(entry.callback_)]() {
+        callback->doneWaiting();
+      });
+    lock.lock();
+  }
+}
@@ -0,0 +1,69 @@
+#if !defined(TimerService_h)
+#define TimerService_h
+
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "tbb/task_arena.h"
+#include "TaskHolder.h"
+
+namespace cce::tf {
+  /*---------------------------------------
+  The TimerService owns one thread which sleeps until the earliest
+  registered deadline has passed and then hands the associated TaskHolder
+  back to the TBB arena from which it was registered. This allows modelling
+  an external latency without having a TBB worker thread blocked in a sleep.
+
+  The pending deadlines are kept in a binary heap ordered by deadline. Ties
+  are broken by registration order.
+  ---------------------------------------*/
+  class TimerService {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    TimerService();
+    ~TimerService();
+
+    TimerService(TimerService const&) = delete;
+    TimerService& operator=(TimerService const&) = delete;
+    TimerService(TimerService&&) = delete;
+    TimerService& operator=(TimerService&&) = delete;
+
+    //Must be called from a thread running in the TBB arena where iCallback should be run.
+    void callAt(clock::time_point iDeadline, TaskHolder iCallback);
+
+    void callAfter(clock::duration iDelay, TaskHolder iCallback) {
+      callAt(clock::now()+iDelay, std::move(iCallback));
+    }
+
+  private:
+    struct Entry {
+      clock::time_point deadline_;
+      unsigned long long order_;
+      std::unique_ptr<tbb::task_arena> arena_;
+      std::unique_ptr<TaskHolder> callback_;
+    };
+    struct Later {
+      bool operator()(Entry const& iLHS, Entry const& iRHS) const {
+        if(iLHS.deadline_ == iRHS.deadline_) {
+          return iLHS.order_ > iRHS.order_;
+        }
+        return iLHS.deadline_ > iRHS.deadline_;
+      }
+    };
+
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<Entry> heap_;
+    unsigned long long nextOrder_ = 0;
+    bool stop_ = false;
+    std::thread thread_;
+  };
+}
+#endif
@@ -0,0 +1,122 @@
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <memory>
+#include <unordered_map>
+#include <iostream>
+#include "EventIdentifier.h"
+#include "DataProductRetriever.h"
+#include "TaskHolder.h"
+#include "TimerService.h"
+#include "WaiterBase.h"
+#include "WaiterFactory.h"
+
+
+namespace cce::tf {
+  /*---------------------------------------
+  TraceReplayWaiter applies a separate time for each (event, data product)
+  pair as read from a trace file. If the job processes more events than are
+  in the trace, the trace is repeated.
+  ---------------------------------------*/
+  class TraceReplayWaiter : public WaiterBase {
+ public:
+
+    //iTimes is indexed by [trace event index][data product index]
+    TraceReplayWaiter(std::vector<std::vector<double>> iTimes, bool iUseTimer):
+      times_(std::move(iTimes)),
+      timer_{iUseTimer ? std::make_unique<TimerService>() : std::unique_ptr<TimerService>()} {}
+
+    void waitAsync(unsigned int iLaneIndex, EventIdentifier const& iEventID, long iEventIndex,
+                   std::vector<DataProductRetriever> const& iRetrievers, unsigned int index,
+                   TaskHolder iCallback) const final {
+      using namespace std::chrono_literals;
+      auto time = times_[iEventIndex % times_.size()][index];
+      if(time <= 0.) {
+        //nothing to wait for, iCallback is released when it goes out of scope
+        return;
+      }
+      if(timer_) {
+        timer_->callAfter(std::chrono::duration_cast<TimerService::clock::duration>(time*1us), std::move(iCallback));
+        return;
+      }
+      iCallback.group()->run([iCallback, time]() {
+          using namespace std::chrono_literals;
+          std::this_thread::sleep_for(time*1us);
+        });
+    }
+
+ private:
+    std::vector<std::vector<double>> times_;
+    std::unique_ptr<TimerService> timer_;
+};
+}
+
+namespace {
+
+  using namespace cce::tf;
+  class Maker : public WaiterMakerBase {
+  public:
+    Maker(): WaiterMakerBase("TraceReplayWaiter") {}
+
+    std::unique_ptr<WaiterBase> create(unsigned int iNLanes, std::vector<DataProductRetriever> const& iDataProducts, ConfigurationParameters const& params) const final {
+      auto scale = params.get<float>("scale", 1.);
+      auto useTimer = params.get<bool>("useTimer", false);
+
+      auto filename = params.get<std::string>("filename");
+      if(not filename) {
+        std::cout <<"no file name give for TraceReplayWaiter"<<std::endl;
+        return {};
+      }
+
+      std::ifstream file(*filename);
+      if(not file.is_open()) {
+        std::cout <<"unable to open file "<<*filename<<" with trace times";
+        return {};
+      }
+
+      std::unordered_map<std::string, unsigned int> productIndices;
+      for(auto const& dp: iDataProducts) {
+        productIndices.emplace(dp.name(), dp.index());
+      }
+
+      std::vector<std::vector<double>> times;
+      std::string line;
+      unsigned int lineNumber = 0;
+      while(std::getline(file, line)) {
+        ++lineNumber;
+        if(line.empty() or line[0] == '#') {
+          continue;
+        }
+        std::istringstream entry(line);
+        long eventIndex;
+        std::string productName;
+        double time;
+        if(not (entry >> eventIndex >> productName >> time) or eventIndex < 0) {
+          std::cout <<"badly formed line "<<lineNumber<<" in file "<<*filename<<"\n"
+            " expected '<event index> <data product name> <time in microseconds>'"<<std::endl;
+          return {};
+        }
+        auto itFound = productIndices.find(productName);
+        if(itFound == productIndices.end()) {
+          std::cout <<"data product '"<<productName<<"' from line "<<lineNumber<<" in file "<<*filename
+                    <<" is not provided by the Source"<<std::endl;
+          return {};
+        }
+        if(times.size() <= static_cast<std::size_t>(eventIndex)) {
+          times.resize(eventIndex+1, std::vector<double>(iDataProducts.size(), 0.));
+        }
+        times[eventIndex][itFound->second] += time*scale;
+      }
+      if(times.empty()) {
+        std::cout <<"file "<<*filename<<" contained no trace times"<<std::endl;
+        return {};
+      }
+
+      return std::make_unique<TraceReplayWaiter>(std::move(times), useTimer);
+    }
+
+  };
+
+  Maker s_maker;
+}
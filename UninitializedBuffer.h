@@ -0,0 +1,55 @@
+#if !defined(UninitializedBuffer_h)
+#define UninitializedBuffer_h
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include "Span.h"
+
+namespace cce::tf {
+  /*---------------------------------------
+  UninitializedBuffer holds a number of T which, unlike with std::vector, are
+  not initialized when the size grows. It is meant to be kept (e.g. one per
+  lane) and reused as the destination of a decompressor which overwrites
+  every value anyway. New storage is only allocated, and its pages touched for
+  the first time, when more values are asked for than ever before.
+
+  Only one thread at a time may use an UninitializedBuffer.
+  ---------------------------------------*/
+  template<typename T>
+  class UninitializedBuffer {
+    static_assert(std::is_trivially_copyable_v<T> and std::is_trivially_destructible_v<T>);
+  public:
+    UninitializedBuffer() = default;
+
+    UninitializedBuffer(UninitializedBuffer&&) = default;
+    UninitializedBuffer& operator=(UninitializedBuffer&&) = default;
+    UninitializedBuffer(UninitializedBuffer const&) = delete;
+    UninitializedBuffer& operator=(UninitializedBuffer const&) = delete;
+
+    //the values are uninitialized afterwards, what was stored before is not kept
+    void resize(std::size_t iSize) {
+      if(iSize > capacity_) {
+        //grow by at least half so slowly increasing sizes do not reallocate each time
+        auto const capacity = std::max(iSize, capacity_ + capacity_/2);
+        //default initialization leaves the values uninitialized
+        storage_.reset(new T[capacity]);
+        capacity_ = capacity;
+      }
+      size_ = iSize;
+    }
+
+    T* data() { return storage_.get(); }
+    T const* data() const { return storage_.get(); }
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
+    Span<T const> span() const { return Span<T const>(storage_.get(), size_); }
+
+  private:
+    std::unique_ptr<T[]> storage_;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+  };
+}
+#endif
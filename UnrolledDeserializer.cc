@@ -8,5 +8,23 @@
 using namespace cce::tf;
 using namespace cce::tf::unrolling;
 
-UnrolledDeserializer::UnrolledDeserializer(TClass* iClass): offsetAndSequences_{buildReadActionSequence(*iClass)}{}
+UnrolledDeserializer::UnrolledDeserializer(TClass* iClass, bool iBulk): 
+  offsetAndSequences_{buildReadActionSequence(*iClass, iBulk)},
+  proxies_{indexCollectionProxies(offsetAndSequences_.m_collections)} {}
 
+UnrolledDeserializer::ThreadState::ThreadState(std::vector<TVirtualCollectionProxy*> const& iProxies):
+  bufferFile_{TBuffer::kRead} {
+  proxies_.reserve(iProxies.size());
+  for(auto proxy: iProxies) {
+    proxies_.emplace_back(proxy->Generate());
+  }
+}
+
+UnrolledDeserializer::ThreadState& UnrolledDeserializer::threadState() const {
+  auto& state = threadStates_.local();
+  if(not state) {
+    std::lock_guard<std::mutex> guard(copyProxiesMutex_);
+    state = std::make_unique<ThreadState>(proxies_);
+  }
+  return *state;
+}
@@ -1,53 +1,110 @@
 #if !defined(UnrolledDeserializer_h)
 #define UnrolledDeserializer_h
 
+#include <memory>
+#include <mutex>
 #include <vector>
 #include "TBufferFile.h"
 #include "TClass.h"
 #include "TStreamerInfoActions.h"
+#include "tbb/enumerable_thread_specific.h"
 #include "common_unrolling.h"
 
 namespace cce::tf {
+  /*---------------------------------------
+  The action sequences are only built once and can be shared by all threads.
+  The read buffer and the collection proxies, which keep state while being
+  used, are held separately for each thread so one UnrolledDeserializer can be
+  used concurrently.
+  ---------------------------------------*/
 class UnrolledDeserializer {
 public:
-  UnrolledDeserializer(TClass*);
+  //iBulk false disables streaming builtins in bulk, which is only useful for comparisons
+  UnrolledDeserializer(TClass*, bool iBulk = true);
 
+  UnrolledDeserializer(UnrolledDeserializer&& iOther):
+    offsetAndSequences_(std::move(iOther.offsetAndSequences_)), proxies_(std::move(iOther.proxies_)),
+    parallelChunkSize_{iOther.parallelChunkSize_} {}
+
+  UnrolledDeserializer(UnrolledDeserializer const& ) = delete;
 
   int deserialize(std::vector<char> const& iBuffer, void* iWriteTo) const {
     return deserialize(&iBuffer.front(), iBuffer.size(), iWriteTo);
   }
+  //Thread safe as long as the same iWriteTo is not used concurrently
   int deserialize(char const * iBuffer, size_t iBufferSize, void* iWriteTo) const{
-    TBufferFile bufferFile{TBuffer::kRead};
-
+    auto& state = threadState();
+    auto& bufferFile = state.bufferFile_;
     bufferFile.SetBuffer( const_cast<char*>(iBuffer), iBufferSize, kFALSE);
+    bufferFile.Reset();
 
-    deserialize(bufferFile, iWriteTo, offsetAndSequences_.m_objects, offsetAndSequences_.m_collections);
+    deserialize(bufferFile, state.proxies_, iWriteTo, offsetAndSequences_.m_objects, offsetAndSequences_.m_collections);
     return bufferFile.Length();
   }
 
+  //builtins in a collection taking more than iBytes are converted using multiple tasks. 0 turns this off.
+  void setParallelChunkSize(std::size_t iBytes) { parallelChunkSize_ = iBytes; }
+
+  //ROOT's collection proxies already resize std::vectors in place, reusing their elements,
+  // and always rebuild other containers so there is nothing more to do here
+  void setRecycle(bool) {}
+
 private:
-  void deserialize(TBufferFile& bufferFile, void* address, 
+  using Proxies = std::vector<std::unique_ptr<TVirtualCollectionProxy>>;
+  struct ThreadState {
+    ThreadState(std::vector<TVirtualCollectionProxy*> const& iProxies);
+    //constructing a TBufferFile is costly compared to reading a small data product
+    TBufferFile bufferFile_;
+    Proxies proxies_;
+  };
+  ThreadState& threadState() const;
+
+  void deserialize(TBufferFile& bufferFile, Proxies const& iProxies, void* address, 
                    unrolling::OffsetAndSequences const& offsetAndSequences, unrolling::SequencesForCollections const& seq4Collections) const {
     for(auto& offNSeq: offsetAndSequences) {
+      if(offNSeq.m_builtinSize != 0) {
+        unrolling::readBuiltins(bufferFile, static_cast<char*>(address)+offNSeq.m_offset, offNSeq.m_length, offNSeq.m_builtinSize, parallelChunkSize_);
+        continue;
+      }
       //seq->Print();
-      bufferFile.ApplySequence(*(offNSeq.second), static_cast<char*>(address)+offNSeq.first);
+      bufferFile.ApplySequence(*(offNSeq.m_sequence), static_cast<char*>(address)+offNSeq.m_offset);
     }
     
     for(auto& coll: seq4Collections) {
       auto collAddress = static_cast<char const*>(address) + coll.m_offset;
+      auto collProxy = iProxies[coll.m_proxyIndex].get();
       
-      TVirtualCollectionProxy::TPushPop helper(coll.m_collProxy.get(), const_cast<char*>(collAddress));
+      TVirtualCollectionProxy::TPushPop helper(collProxy, const_cast<char*>(collAddress));
       Int_t size;
       bufferFile >> size;      
-      coll.m_collProxy->Allocate(size, true);
+      collProxy->Allocate(size, true);
+
+      if(coll.m_builtinSize != 0) {
+        if(size != 0) {
+          unrolling::readBuiltins(bufferFile, collProxy->At(0), size, coll.m_builtinSize, parallelChunkSize_);
+        }
+        continue;
+      }
+      if(not coll.m_bulkElements.m_fields.empty()) {
+        if(size != 0) {
+          unrolling::readElements(bufferFile, collProxy->At(0), size, coll.m_bulkElements, parallelChunkSize_);
+        }
+        continue;
+      }
       
       for(Int_t item=0; item<size; ++item) {
-        auto elementAddress = (*coll.m_collProxy)[item];
-        deserialize(bufferFile, elementAddress, coll.m_offsetAndSequences, coll.m_collections);
+        auto elementAddress = (*collProxy)[item];
+        deserialize(bufferFile, iProxies, elementAddress, coll.m_offsetAndSequences, coll.m_collections);
       }
     }
   }
   unrolling::ObjectAndCollectionsSequences offsetAndSequences_;
+  //the collection proxies in offsetAndSequences_ which are copied for each thread
+  std::vector<TVirtualCollectionProxy*> proxies_;
+  mutable tbb::enumerable_thread_specific<std::unique_ptr<ThreadState>> threadStates_;
+  //copying the proxies is not thread safe
+  mutable std::mutex copyProxiesMutex_;
+  std::size_t parallelChunkSize_ = 0;
 };
 }
 #endif
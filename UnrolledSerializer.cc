@@ -9,6 +9,7 @@
 using namespace cce::tf;
 using namespace cce::tf::unrolling;
 
-UnrolledSerializer::UnrolledSerializer(TClass* iClass):
+UnrolledSerializer::UnrolledSerializer(TClass* iClass, bool iBulk):
   bufferFile_{TBuffer::kWrite},
-  offsetAndSequences_{buildWriteActionSequence(*iClass)} {}
+  sequences_{cachedWriteActionSequence(*iClass, iBulk)},
+  proxies_{sequences_->copyProxies()} {}
@@ -1,55 +1,93 @@
 #if !defined(UnrolledSerializer_h)
 #define UnrolledSerializer_h
 
+#include <memory>
 #include <vector>
 #include "TBufferFile.h"
 #include "TClass.h"
 #include "TStreamerInfoActions.h"
 #include "common_unrolling.h"
+#include "Span.h"
 
 namespace cce::tf {
+  /*---------------------------------------
+  The action sequences come from a process wide cache so they are only built
+  once per class no matter how many lanes or outputers serialize that class.
+  Each UnrolledSerializer only holds its own buffer and copies of the
+  collection proxies.
+  ---------------------------------------*/
 class UnrolledSerializer {
 public:
-  UnrolledSerializer(TClass*);
+  //iBulk false disables streaming builtins in bulk, which is only useful for comparisons
+  UnrolledSerializer(TClass*, bool iBulk = true);
 
   UnrolledSerializer(UnrolledSerializer&& iOther):
-  bufferFile_{TBuffer::kWrite}, offsetAndSequences_(std::move(iOther.offsetAndSequences_))  {}
+  bufferFile_{TBuffer::kWrite}, sequences_(std::move(iOther.sequences_)), proxies_(std::move(iOther.proxies_)), parallelChunkSize_{iOther.parallelChunkSize_}  {}
   
   UnrolledSerializer(UnrolledSerializer const& ) = delete;
 
-  std::vector<char> serialize(void const* address) {
+  //The returned Span refers to the internal buffer which is reused by the next call
+  Span<char const> serialize(void const* address) {
     bufferFile_.Reset();
 
-    serialize(address, offsetAndSequences_.m_objects, offsetAndSequences_.m_collections);
+    serialize(bufferFile_, address, sequences_->m_sequences.m_objects, sequences_->m_sequences.m_collections);
 
     //The blob contains the serialized data product
-    std::vector<char> blob(bufferFile_.Buffer(), bufferFile_.Buffer()+bufferFile_.Length());
-    return blob;
+    return Span<char const>(bufferFile_.Buffer(), bufferFile_.Length());
   }
 
+  //writes to the end of iBuffer rather than to the internal buffer
+  void serialize(void const* address, TBufferFile& iBuffer) {
+    serialize(iBuffer, address, sequences_->m_sequences.m_objects, sequences_->m_sequences.m_collections);
+  }
+
+  //builtins in a collection taking more than iBytes are converted using multiple tasks. 0 turns this off.
+  void setParallelChunkSize(std::size_t iBytes) { parallelChunkSize_ = iBytes; }
+
 private:
-  void serialize(void const* address, unrolling::OffsetAndSequences& offsetAndSequences, unrolling::SequencesForCollections& seq4Collections) {
+  void serialize(TBufferFile& bufferFile, void const* address, unrolling::OffsetAndSequences const& offsetAndSequences, unrolling::SequencesForCollections const& seq4Collections) {
     for(auto& offAndSeq: offsetAndSequences) {
+      if(offAndSeq.m_builtinSize != 0) {
+        unrolling::writeBuiltins(bufferFile, static_cast<char const*>(address)+offAndSeq.m_offset, offAndSeq.m_length, offAndSeq.m_builtinSize, parallelChunkSize_);
+        continue;
+      }
       //seq->Print();
-      bufferFile_.ApplySequence(*(offAndSeq.second), const_cast<char*>(static_cast<char const*>(address)+offAndSeq.first));
+      bufferFile.ApplySequence(*(offAndSeq.m_sequence), const_cast<char*>(static_cast<char const*>(address)+offAndSeq.m_offset));
     }
 
     for(auto& coll: seq4Collections) {
       auto collAddress = static_cast<char const*>(address) + coll.m_offset;
+      auto collProxy = proxies_[coll.m_proxyIndex].get();
 
-      TVirtualCollectionProxy::TPushPop helper(coll.m_collProxy.get(), const_cast<char*>(collAddress));
-      Int_t size =coll.m_collProxy->Size();
-      bufferFile_ << size;
+      TVirtualCollectionProxy::TPushPop helper(collProxy, const_cast<char*>(collAddress));
+      Int_t size =collProxy->Size();
+      bufferFile << size;
+
+      if(coll.m_builtinSize != 0) {
+        //std::vector elements are contiguous
+        if(size != 0) {
+          unrolling::writeBuiltins(bufferFile, collProxy->At(0), size, coll.m_builtinSize, parallelChunkSize_);
+        }
+        continue;
+      }
+      if(not coll.m_bulkElements.m_fields.empty()) {
+        if(size != 0) {
+          unrolling::writeElements(bufferFile, collProxy->At(0), size, coll.m_bulkElements, parallelChunkSize_);
+        }
+        continue;
+      }
 
       for(Int_t item=0; item<size; ++item) {
-        auto elementAddress = (*coll.m_collProxy)[item];
-        serialize(elementAddress, coll.m_offsetAndSequences, coll.m_collections);
+        auto elementAddress = (*collProxy)[item];
+        serialize(bufferFile, elementAddress, coll.m_offsetAndSequences, coll.m_collections);
       }
     }
   }
 
   TBufferFile bufferFile_;
-  unrolling::ObjectAndCollectionsSequences offsetAndSequences_;
+  std::shared_ptr<unrolling::SharedSequences const> sequences_;
+  std::vector<std::unique_ptr<TVirtualCollectionProxy>> proxies_;
+  std::size_t parallelChunkSize_ = 0;
 };
 }
 #endif
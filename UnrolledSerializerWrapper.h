@@ -8,6 +8,8 @@
 #include "tbb/task_group.h"
 #include "UnrolledSerializer.h"
 #include "TaskHolder.h"
+#include "Span.h"
+#include "EventArena.h"
 
 namespace cce::tf {
 class UnrolledSerializerWrapper {
@@ -28,13 +30,28 @@ public:
 	const_cast<TaskHolder&>(callback).doneWaiting();
       });
   }
-  std::vector<char> const& blob() const {return blob_;}
+  //Synchronously appends the serialized data product to iArena and returns the number of bytes
+  // written. blob() is left empty as the arena may move while more data products are appended.
+  std::size_t serialize(void** iAddress, EventArena& iArena) {
+    auto start = std::chrono::high_resolution_clock::now();
+    serializer_.serialize(*iAddress, iArena.beginSlice());
+    auto nBytes = iArena.endSlice();
+    blob_ = {};
+    accumulatedTime_ += std::chrono::duration_cast<decltype(accumulatedTime_)>(std::chrono::high_resolution_clock::now() - start);
+    return nBytes;
+  }
+
+  //see UnrolledSerializer::setParallelChunkSize
+  void setParallelChunkSize(std::size_t iBytes) { serializer_.setParallelChunkSize(iBytes); }
+
+  //only valid until the next call to doWorkAsync
+  Span<char const> blob() const {return blob_;}
 
   std::string_view  name() const {return name_;}
   char const* className() const { return class_->GetName(); }
   std::chrono::microseconds accumulatedTime() const { return accumulatedTime_;}
 private:
-  std::vector<char> blob_;
+  Span<char const> blob_;
   std::string_view name_;
   TClass const* class_;
   UnrolledSerializer serializer_;
@@ -18,6 +18,9 @@ class WaiterBase {
   // iEventIndex is the index of the event within the Source
   // iProductIndex is which element of iRetrievers is to be waited upon
   virtual void waitAsync(unsigned int iLaneIndex, EventIdentifier const& iEventID, long iEventIndex, std::vector<DataProductRetriever> const& iRetrievers, unsigned int iProductIndex, TaskHolder iCallback) const = 0;
+
+  //called at the end of the job
+  virtual void printSummary() const {}
 };
 }
 #endif
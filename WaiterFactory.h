@@ -1,13 +1,15 @@
 #if !defined(WaiterFactory_h)
 #define WaiterFactory_h
 
+#include <vector>
 #include "ComponentFactory.h"
 #include "WaiterBase.h"
+#include "DataProductRetriever.h"
 #include "ConfigurationParameters.h"
 
 namespace cce::tf {
-  // arguments are number of lanes followed by number of data products
-  using WaiterFactory = ComponentFactory<WaiterBase*(unsigned int, std::size_t , ConfigurationParameters const&)>;
+  // arguments are number of lanes followed by the data products provided by the Source
+  using WaiterFactory = ComponentFactory<WaiterBase*(unsigned int, std::vector<DataProductRetriever> const& , ConfigurationParameters const&)>;
   using WaiterMakerBase = WaiterFactory::CMakerBase;
 }
 
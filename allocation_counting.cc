@@ -0,0 +1,104 @@
+/*---------------------------------------
+Replaces the global operator new and delete so the number of allocations
+made by each thread can be counted. The count is thread local so
+measuring the allocations made by a piece of code which runs within one
+task only requires looking at the count before and after.
+  ---------------------------------------*/
+#include "allocation_counting.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+  thread_local std::size_t s_count = 0;
+
+  void* allocate(std::size_t iSize) {
+    ++s_count;
+    if(iSize == 0) {
+      iSize = 1;
+    }
+    while(true) {
+      if(void* p = std::malloc(iSize)) {
+        return p;
+      }
+      auto handler = std::get_new_handler();
+      if(not handler) {
+        throw std::bad_alloc();
+      }
+      handler();
+    }
+  }
+
+  void* allocate(std::size_t iSize, std::align_val_t iAlign) {
+    ++s_count;
+    auto alignment = static_cast<std::size_t>(iAlign);
+    if(alignment < sizeof(void*)) {
+      alignment = sizeof(void*);
+    }
+    if(iSize == 0) {
+      iSize = 1;
+    }
+    while(true) {
+      void* p = nullptr;
+      if(0 == posix_memalign(&p, alignment, iSize)) {
+        return p;
+      }
+      auto handler = std::get_new_handler();
+      if(not handler) {
+        throw std::bad_alloc();
+      }
+      handler();
+    }
+  }
+}
+
+std::size_t cce::tf::alloc::count() {
+  return s_count;
+}
+
+void* operator new(std::size_t iSize) { return allocate(iSize); }
+void* operator new[](std::size_t iSize) { return allocate(iSize); }
+void* operator new(std::size_t iSize, std::align_val_t iAlign) { return allocate(iSize, iAlign); }
+void* operator new[](std::size_t iSize, std::align_val_t iAlign) { return allocate(iSize, iAlign); }
+
+void* operator new(std::size_t iSize, std::nothrow_t const&) noexcept {
+  try {
+    return allocate(iSize);
+  } catch(...) {
+    return nullptr;
+  }
+}
+void* operator new[](std::size_t iSize, std::nothrow_t const&) noexcept {
+  try {
+    return allocate(iSize);
+  } catch(...) {
+    return nullptr;
+  }
+}
+void* operator new(std::size_t iSize, std::align_val_t iAlign, std::nothrow_t const&) noexcept {
+  try {
+    return allocate(iSize, iAlign);
+  } catch(...) {
+    return nullptr;
+  }
+}
+void* operator new[](std::size_t iSize, std::align_val_t iAlign, std::nothrow_t const&) noexcept {
+  try {
+    return allocate(iSize, iAlign);
+  } catch(...) {
+    return nullptr;
+  }
+}
+
+void operator delete(void* iPtr) noexcept { std::free(iPtr); }
+void operator delete[](void* iPtr) noexcept { std::free(iPtr); }
+void operator delete(void* iPtr, std::size_t) noexcept { std::free(iPtr); }
+void operator delete[](void* iPtr, std::size_t) noexcept { std::free(iPtr); }
+void operator delete(void* iPtr, std::align_val_t) noexcept { std::free(iPtr); }
+void operator delete[](void* iPtr, std::align_val_t) noexcept { std::free(iPtr); }
+void operator delete(void* iPtr, std::size_t, std::align_val_t) noexcept { std::free(iPtr); }
+void operator delete[](void* iPtr, std::size_t, std::align_val_t) noexcept { std::free(iPtr); }
+void operator delete(void* iPtr, std::nothrow_t const&) noexcept { std::free(iPtr); }
+void operator delete[](void* iPtr, std::nothrow_t const&) noexcept { std::free(iPtr); }
+void operator delete(void* iPtr, std::align_val_t, std::nothrow_t const&) noexcept { std::free(iPtr); }
+void operator delete[](void* iPtr, std::align_val_t, std::nothrow_t const&) noexcept { std::free(iPtr); }
@@ -0,0 +1,11 @@
+#if !defined(allocation_counting_h)
+#define allocation_counting_h
+
+#include <cstddef>
+
+namespace cce::tf::alloc {
+  //number of calls to the global operator new made by this thread. Defined in
+  // allocation_counting.cc which replaces operator new in order to count.
+  std::size_t count();
+}
+#endif
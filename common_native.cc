@@ -0,0 +1,130 @@
+#include "common_native.h"
+#include "common_unrolling.h"
+
+#include "TList.h"
+#include "TDataMember.h"
+#include "TDataType.h"
+#include "TStreamerInfo.h"
+#include "TStreamerElement.h"
+
+using namespace cce::tf;
+
+namespace {
+  bool isTriviallyCopyableType(int iType) {
+    switch(iType) {
+    case TVirtualStreamerInfo::kChar:
+    case TVirtualStreamerInfo::kShort:
+    case TVirtualStreamerInfo::kInt:
+    case TVirtualStreamerInfo::kCounter:
+    case TVirtualStreamerInfo::kLong:
+    case TVirtualStreamerInfo::kFloat:
+    case TVirtualStreamerInfo::kDouble:
+    case TVirtualStreamerInfo::kUChar:
+    case TVirtualStreamerInfo::kUShort:
+    case TVirtualStreamerInfo::kUInt:
+    case TVirtualStreamerInfo::kULong:
+    case TVirtualStreamerInfo::kLong64:
+    case TVirtualStreamerInfo::kULong64:
+    case TVirtualStreamerInfo::kBool:
+      return true;
+    }
+    //kDouble32 and kFloat16 change the value, kBits and kCharStar need special handling
+    return false;
+  }
+
+  //EDataType used by collection proxies
+  bool isTriviallyCopyableDataType(int iType) {
+    switch(iType) {
+    case kChar_t:
+    case kUChar_t:
+    case kShort_t:
+    case kUShort_t:
+    case kInt_t:
+    case kUInt_t:
+    case kLong_t:
+    case kULong_t:
+    case kLong64_t:
+    case kULong64_t:
+    case kFloat_t:
+    case kDouble_t:
+      return true;
+    }
+    //std::vector<bool> packs its values in bits and has no data()
+    return false;
+  }
+
+  bool isTriviallyCopyableElement(TStreamerElement* iElement) {
+    if(iElement->IsBase()) {
+      auto base = iElement->GetClassPointer();
+      return base and native::isTriviallyCopyable(*base);
+    }
+    auto type = iElement->GetType();
+    if(type == TVirtualStreamerInfo::kObject or type == TVirtualStreamerInfo::kAny) {
+      auto member = iElement->GetClassPointer();
+      return member and native::isTriviallyCopyable(*member);
+    }
+    if(type > TVirtualStreamerInfo::kOffsetL and type < TVirtualStreamerInfo::kOffsetP) {
+      return isTriviallyCopyableType(type - TVirtualStreamerInfo::kOffsetL);
+    }
+    return isTriviallyCopyableType(type);
+  }
+}
+
+namespace cce::tf::native {
+  bool isTriviallyCopyable(TClass& iClass) {
+    if(iClass.GetCollectionProxy() or not iClass.HasDataMemberInfo() or iClass.HasCustomStreamerMember()) {
+      return false;
+    }
+    if(iClass.ClassProperty() & kClassHasVirtual) {
+      //the virtual table pointer can not be copied between processes
+      return false;
+    }
+    //transient members are not streamed and may hold pointers
+    TIter nextMember(iClass.GetListOfDataMembers());
+    TDataMember* member = nullptr;
+    while( (member = static_cast<TDataMember*>(nextMember())) ) {
+      if(not member->IsPersistent() and not (member->Property() & kIsStatic)) {
+        return false;
+      }
+    }
+
+    TStreamerInfo* sinfo = unrolling::buildStreamerInfo(&iClass);
+    if(not sinfo) {
+      return false;
+    }
+    TIter next(sinfo->GetElements());
+    TStreamerElement* element = nullptr;
+    while( (element = static_cast<TStreamerElement*>(next())) ) {
+      if(not isTriviallyCopyableElement(element)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Layout buildLayout(TClass& iClass) {
+    Layout layout;
+    if(auto collProxy = iClass.GetCollectionProxy()) {
+      if(collProxy->GetCollectionType() != ROOT::kSTLvector or collProxy->HasPointers()) {
+        return layout;
+      }
+      auto valueClass = collProxy->GetValueClass();
+      if(valueClass) {
+        if(not isTriviallyCopyable(*valueClass)) {
+          return layout;
+        }
+      } else if(not isTriviallyCopyableDataType(collProxy->GetType())) {
+        return layout;
+      }
+      layout.m_kind = Kind::kVector;
+      layout.m_size = valueClass ? valueClass->Size() : TDataType::GetDataType(static_cast<EDataType>(collProxy->GetType()))->Size();
+      layout.m_collProxy.reset(collProxy->Generate());
+      return layout;
+    }
+    if(isTriviallyCopyable(iClass)) {
+      layout.m_kind = Kind::kObject;
+      layout.m_size = iClass.Size();
+    }
+    return layout;
+  }
+}
@@ -0,0 +1,33 @@
+#if !defined(common_native_h)
+#define common_native_h
+
+#include "TClass.h"
+#include "TVirtualCollectionProxy.h"
+#include <cstddef>
+#include <memory>
+
+namespace cce::tf::native {
+  /*---------------------------------------
+  Describes how a data product is stored by the native serialization.
+  kObject: the whole object is trivially copyable and is stored with memcpy
+  kVector: a std::vector whose elements are trivially copyable. The Int_t
+           number of elements is stored followed by the elements' memory
+  kUnrolled: neither of the above, the unrolled serialization is used
+  All values are stored in the byte order of the machine.
+  ---------------------------------------*/
+  enum class Kind {kObject, kVector, kUnrolled};
+
+  struct Layout {
+    Kind m_kind = Kind::kUnrolled;
+    //size of the object for kObject and of one element for kVector
+    std::size_t m_size = 0;
+    //only set for kVector
+    std::unique_ptr<TVirtualCollectionProxy> m_collProxy;
+  };
+
+  Layout buildLayout(TClass& iClass);
+
+  //true if memcpy of the object's memory is equivalent to streaming it
+  bool isTriviallyCopyable(TClass& iClass);
+}
+#endif
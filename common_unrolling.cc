@@ -8,7 +8,12 @@
 #include "SequenceFinderForBuiltins.h"
 
 #include <set>
+#include <map>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "tbb/parallel_for_each.h"
 
 using namespace cce::tf;
 namespace {
@@ -223,7 +228,41 @@ namespace {
 // Now with split level. id=-2 for the 'top level' after top level BranchElement is made, will call Unroll on it
 // ftype is still 0 for the sub items (since we are effectively splitlevel == 1)
 
-  void addUnrolledActionSequencesForElement(TStreamerInfo* parentInfo, int idInParent, TStreamerElement* element, TClass& iClass, TStreamerInfoActions::TActionSequence::SequenceGetter_t create, int baseOffset, std::set<TClass const*>& hierarchy, unrolling::OffsetAndSequences& oSeq, unrolling::SequencesForCollections& oCollections, bool unrollCollections) {
+  //If the elements of the collection are only made of builtins, record where they are
+  // so all elements can be streamed in one pass
+  void setBulkElements(unrolling::CollectionActions& iColl, TClass& iValueClass) {
+    if(not iColl.m_collections.empty()) {
+      return;
+    }
+    unrolling::BulkElements bulkElements;
+    unsigned int streamedSize = 0;
+    bool uniform = true;
+    for(auto const& offAndSeq: iColl.m_offsetAndSequences) {
+      if(offAndSeq.m_builtinSize == 0) {
+        //split nodes have empty sequences
+        if(offAndSeq.m_sequence and not offAndSeq.m_sequence->fActions.empty()) {
+          return;
+        }
+        continue;
+      }
+      uniform = uniform and offAndSeq.m_offset == static_cast<int>(streamedSize) and
+        (bulkElements.m_fields.empty() or bulkElements.m_fields.front().m_size == offAndSeq.m_builtinSize);
+      bulkElements.m_fields.push_back({offAndSeq.m_offset, offAndSeq.m_builtinSize, offAndSeq.m_length});
+      streamedSize += offAndSeq.m_builtinSize*offAndSeq.m_length;
+    }
+    if(bulkElements.m_fields.empty()) {
+      return;
+    }
+    bulkElements.m_elementSize = iValueClass.Size();
+    bulkElements.m_streamedSize = streamedSize;
+    if(uniform and streamedSize == bulkElements.m_elementSize) {
+      //no padding so the whole collection is one array of builtins
+      bulkElements.m_uniformSize = bulkElements.m_fields.front().m_size;
+    }
+    iColl.m_bulkElements = std::move(bulkElements);
+  }
+
+  void addUnrolledActionSequencesForElement(TStreamerInfo* parentInfo, int idInParent, TStreamerElement* element, TClass& iClass, TStreamerInfoActions::TActionSequence::SequenceGetter_t create, int baseOffset, std::set<TClass const*>& hierarchy, unrolling::OffsetAndSequences& oSeq, unrolling::SequencesForCollections& oCollections, bool unrollCollections, bool bulk) {
     if(not elementNeedsOwnSequence(element, &iClass)) {
       return;
     }
@@ -243,7 +282,7 @@ namespace {
           if(not elementNeedsOwnSequence(element, ptr)) {
             continue;
           }
-          addUnrolledActionSequencesForElement(sinfo, id, element, *ptr, create, baseOffset+offset,hierarchy, oSeq, oCollections, unrollCollections);
+          addUnrolledActionSequencesForElement(sinfo, id, element, *ptr, create, baseOffset+offset,hierarchy, oSeq, oCollections, unrollCollections, bulk);
         }
         return;
       }
@@ -266,9 +305,12 @@ namespace {
                 }
                 //NOTE: offsets are relative to address in element of the container
                 addUnrolledActionSequencesForElement(sinfo, id, element, *valueClass, create, 0, hierarchy,
-                                                     oCollections.back().m_offsetAndSequences, oCollections.back().m_collections, /*false*/ true);
+                                                     oCollections.back().m_offsetAndSequences, oCollections.back().m_collections, /*false*/ true, bulk);
               }
               hierarchy.erase(valueClass);
+              if(bulk) {
+                setBulkElements(oCollections.back(), *valueClass);
+              }
               return;
             }
           }
@@ -279,63 +321,14 @@ namespace {
         auto collProxy = ptr->GetCollectionProxy(); 
         if(collProxy && collProxy->GetCollectionType() ==  ROOT::kSTLvector) {
           if(not collProxy->GetValueClass()) {
-            TClass* proxyClass = nullptr;
-            switch(collProxy->GetType()) {
-            case kFloat_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<float>));
-                break;
-              }
-            case kDouble_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<double>));
-                break;
-              }
-            case kInt_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<int>));
-                break;
-              }
-            case kUInt_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned int>));
-                break;
-              }
-            case kLong_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<long>));
-                break;
-              }
-            case kULong_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned long>));
-                break;
-              }
-            case kShort_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<short>));
-                break;
-              }
-            case kUShort_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned short>));
-                break;
-              }
-            case kChar_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<char>));
-                break;
-              }
-            case kUChar_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned char>));
-                break;
-              }
-            }
+            TClass* proxyClass = unrolling::sequenceFinderForBuiltins(collProxy->GetType());
             if(proxyClass) {
               //std::cout <<"using prox class"<<std::endl;
               TStreamerInfo* sinfo = buildStreamerInfo(proxyClass,nullptr);
               oCollections.emplace_back(collProxy->Generate(), baseOffset+element->GetOffset());
+              if(bulk) {
+                oCollections.back().m_builtinSize = unrolling::bulkBuiltinSize(collProxy->GetType());
+              }
               //base offset is 0 since it is relative to the item in the container
               oCollections.back().m_offsetAndSequences.emplace_back(0, setActionSequence(nullptr, sinfo, nullptr, create, false, -1, 0));
               return;
@@ -345,13 +338,30 @@ namespace {
         
       }
       //std::cout <<"rolled "<<ptr->GetName()<<std::endl;
+    } else if(bulk) {
+      //builtins and fixed length arrays of builtins
+      auto streamerType = element->GetType();
+      if(streamerType > 0 and streamerType < TVirtualStreamerInfo::kOffsetL) {
+        auto size = unrolling::bulkBuiltinSize(streamerType);
+        if(size != 0) {
+          oSeq.emplace_back(baseOffset+element->GetOffset(), size, 1);
+          return;
+        }
+      }
+      if(streamerType > TVirtualStreamerInfo::kOffsetL and streamerType < TVirtualStreamerInfo::kOffsetP) {
+        auto size = unrolling::bulkBuiltinSize(streamerType - TVirtualStreamerInfo::kOffsetL);
+        if(size != 0) {
+          oSeq.emplace_back(baseOffset+element->GetOffset(), size, element->GetArrayLength());
+          return;
+        }
+      }
     }
    
     //std::cout <<" baseOffset "<<baseOffset<<" offset "<<element->GetOffset()<<" "<< element->GetName()<<" "<< (ptr? ptr->GetName(): "?")<<std::endl;
     oSeq.emplace_back(baseOffset, setActionSequence(nullptr, parentInfo, nullptr, create, false, idInParent, 0));
   }
 
-  unrolling::ObjectAndCollectionsSequences buildUnrolledActionSequence(TClass& iClass, TStreamerInfo& iInfo, TStreamerInfoActions::TActionSequence::SequenceGetter_t create, std::set<TClass const*>& hierarchy) {
+  unrolling::ObjectAndCollectionsSequences buildUnrolledActionSequence(TClass& iClass, TStreamerInfo& iInfo, TStreamerInfoActions::TActionSequence::SequenceGetter_t create, std::set<TClass const*>& hierarchy, bool bulk) {
     unrolling::ObjectAndCollectionsSequences objAndColl;
     objAndColl.m_objects.reserve(1);
     unrolling::SequencesForCollections colls;
@@ -359,12 +369,12 @@ namespace {
     TIter next(iInfo.GetElements());
     TStreamerElement* element = 0;
     for (Int_t id = 0; (element = (TStreamerElement*) next()); ++id) {
-      addUnrolledActionSequencesForElement(&iInfo, id, element, iClass, create, 0, hierarchy, objAndColl.m_objects, objAndColl.m_collections, true);
+      addUnrolledActionSequencesForElement(&iInfo, id, element, iClass, create, 0, hierarchy, objAndColl.m_objects, objAndColl.m_collections, true, bulk);
     }
     return objAndColl;
   }
 
-  unrolling::ObjectAndCollectionsSequences buildActionSequence(TClass& iClass, TStreamerInfoActions::TActionSequence::SequenceGetter_t create) {
+  unrolling::ObjectAndCollectionsSequences buildActionSequence(TClass& iClass, TStreamerInfoActions::TActionSequence::SequenceGetter_t create, bool bulk) {
   checkIfCanHandle(&iClass);
 
   TStreamerInfo* sinfo = buildStreamerInfo(&iClass);
@@ -377,7 +387,7 @@ namespace {
     //std::cout <<"Unrolling "<<iClass.GetName()<<std::endl;
     std::set<TClass const*> hierarchy;
     hierarchy.insert(&iClass);
-    return buildUnrolledActionSequence(iClass, *sinfo, create, hierarchy);
+    return buildUnrolledActionSequence(iClass, *sinfo, create, hierarchy, bulk);
   }
   //std::cout <<"Did not unroll "<<iClass.GetName()<<std::endl;
   unrolling::ObjectAndCollectionsSequences objAndColl;
@@ -388,12 +398,155 @@ namespace {
 }
 
 namespace cce::tf::unrolling {
-  unrolling::ObjectAndCollectionsSequences buildReadActionSequence(TClass& iClass) {
-    return buildActionSequence(iClass, TStreamerInfoActions::TActionSequence::ReadMemberWiseActionsGetter);
+  TStreamerInfo* buildStreamerInfo(TClass* iClass) {
+    return ::buildStreamerInfo(iClass);
+  }
+
+  TStreamerInfo* buildStreamerInfo(TClass* iClass, void* iPointer) {
+    return ::buildStreamerInfo(iClass, iPointer);
+  }
+
+  bool canUnroll(TClass* iClass, TStreamerInfo* iInfo) {
+    return ::canUnroll(iClass, iInfo);
+  }
+
+  bool elementNeedsOwnSequence(TStreamerElement* iElement, TClass* iClass) {
+    return ::elementNeedsOwnSequence(iElement, iClass);
+  }
+
+  TClass* sequenceFinderForBuiltins(int iType) {
+    switch(iType) {
+    case kFloat_t:
+      return TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<float>));
+    case kDouble_t:
+      return TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<double>));
+    case kInt_t:
+      return TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<int>));
+    case kUInt_t:
+      return TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned int>));
+    case kLong_t:
+      return TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<long>));
+    case kULong_t:
+      return TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned long>));
+    case kShort_t:
+      return TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<short>));
+    case kUShort_t:
+      return TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned short>));
+    case kChar_t:
+      return TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<char>));
+    case kUChar_t:
+      return TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned char>));
+    }
+    return nullptr;
+  }
+
+  unsigned int bulkBuiltinSize(int iType) {
+    //the values of EDataType match the TStreamerInfo basic types
+    switch(iType) {
+    case kChar_t:
+    case kUChar_t:
+    case kBool_t:
+      return 1;
+    case kShort_t:
+    case kUShort_t:
+      return 2;
+    case kInt_t:
+    case kUInt_t:
+    case kFloat_t:
+      return 4;
+    case kDouble_t:
+    case kLong64_t:
+    case kULong64_t:
+      return 8;
+    case kLong_t:
+    case kULong_t:
+      //TBuffer always stores longs using 8 bytes
+      return sizeof(Long_t) == 8 ? 8 : 0;
+    }
+    //kDouble32, kFloat16, kBits, kCharStar, ... are not stored as in memory
+    return 0;
+  }
+
+  unrolling::ObjectAndCollectionsSequences buildReadActionSequence(TClass& iClass, bool iBulk) {
+    return buildActionSequence(iClass, TStreamerInfoActions::TActionSequence::ReadMemberWiseActionsGetter, iBulk);
+  }
+
+  unrolling::ObjectAndCollectionsSequences buildWriteActionSequence(TClass& iClass, bool iBulk) {
+    return buildActionSequence(iClass, TStreamerInfoActions::TActionSequence::WriteMemberWiseActionsGetter, iBulk);
+  }
+
+  namespace {
+    void indexCollectionProxies(SequencesForCollections& ioCollections, std::vector<TVirtualCollectionProxy*>& oProxies) {
+      for(auto& coll: ioCollections) {
+        coll.m_proxyIndex = oProxies.size();
+        oProxies.push_back(coll.m_collProxy.get());
+        indexCollectionProxies(coll.m_collections, oProxies);
+      }
+    }
+  }
+
+  std::vector<TVirtualCollectionProxy*> indexCollectionProxies(SequencesForCollections& ioCollections) {
+    std::vector<TVirtualCollectionProxy*> proxies;
+    indexCollectionProxies(ioCollections, proxies);
+    return proxies;
+  }
+
+  std::vector<std::unique_ptr<TVirtualCollectionProxy>> SharedSequences::copyProxies() const {
+    std::vector<std::unique_ptr<TVirtualCollectionProxy>> proxies;
+    proxies.reserve(m_proxies.size());
+    std::lock_guard<std::mutex> guard(m_copyMutex);
+    for(auto proxy: m_proxies) {
+      proxies.emplace_back(proxy->Generate());
+    }
+    return proxies;
+  }
+
+  namespace {
+    struct CacheEntry {
+      std::once_flag m_built;
+      std::shared_ptr<SharedSequences const> m_sequences;
+    };
+    struct WriteCache {
+      std::mutex m_mutex;
+      //entries are never removed so the pointers stay valid
+      std::map<std::pair<TClass*, bool>, std::unique_ptr<CacheEntry>> m_entries;
+    };
+    WriteCache& writeCache() {
+      static WriteCache s_cache;
+      return s_cache;
+    }
+  }
+
+  std::shared_ptr<SharedSequences const> cachedWriteActionSequence(TClass& iClass, bool iBulk) {
+    CacheEntry* entry;
+    {
+      auto& cache = writeCache();
+      std::lock_guard<std::mutex> guard(cache.m_mutex);
+      auto& e = cache.m_entries[{&iClass, iBulk}];
+      if(not e) {
+        e = std::make_unique<CacheEntry>();
+      }
+      entry = e.get();
+    }
+    //building is done outside of the cache lock so different classes can be built concurrently
+    std::call_once(entry->m_built, [entry, &iClass, iBulk]() {
+        auto sequences = std::make_shared<SharedSequences>();
+        sequences->m_sequences = buildWriteActionSequence(iClass, iBulk);
+        sequences->m_proxies = indexCollectionProxies(sequences->m_sequences.m_collections);
+        entry->m_sequences = std::move(sequences);
+      });
+    return entry->m_sequences;
+  }
+
+  void fillWriteActionSequenceCache(std::vector<TClass*> const& iClasses, bool iBulk) {
+    tbb::parallel_for_each(iClasses.begin(), iClasses.end(), [iBulk](TClass* iClass) {
+        cachedWriteActionSequence(*iClass, iBulk);
+      });
   }
 
-  unrolling::ObjectAndCollectionsSequences buildWriteActionSequence(TClass& iClass) {
-    return buildActionSequence(iClass, TStreamerInfoActions::TActionSequence::WriteMemberWiseActionsGetter);
+  void throwBufferOverrun(char const* iFunction, TBufferFile const& iBuffer, std::size_t iNBytes) {
+    throw std::runtime_error(std::string(iFunction)+" needs "+std::to_string(iNBytes)+" bytes but only "+
+                             std::to_string(iBuffer.BufferSize()-iBuffer.Length())+" are left in the buffer");
   }
 
 }
@@ -2,13 +2,49 @@
 #define common_unrolling_h
 
 #include "TClass.h"
+#include "TStreamerInfo.h"
+#include "TStreamerElement.h"
 #include "TStreamerInfoActions.h"
+#include "TBufferFile.h"
+#include "swap_kernels.h"
+#include "parallel_chunks.h"
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace cce::tf::unrolling {
   using Sequence = std::unique_ptr<TStreamerInfoActions::TActionSequence>;  
-  using OffsetAndSequences = std::vector<std::pair<int, Sequence>>;
+
+  //Either a TActionSequence or a fixed length array of builtins which is streamed
+  // with the bulk byte swap kernels.
+  struct OffsetAndSequence {
+    OffsetAndSequence(int offset, Sequence sequence):
+      m_offset(offset), m_sequence(std::move(sequence)) {}
+    OffsetAndSequence(int offset, unsigned int builtinSize, int length):
+      m_offset(offset), m_builtinSize(builtinSize), m_length(length) {}
+
+    int m_offset;
+    Sequence m_sequence;
+    //non zero if this is an array of builtins
+    unsigned int m_builtinSize = 0;
+    int m_length = 0;
+  };
+  using OffsetAndSequences = std::vector<OffsetAndSequence>;
+
+  //where the builtins are within an element of a collection whose elements hold only builtins
+  struct BulkField {
+    int m_offset;
+    unsigned int m_size;
+    int m_length;
+  };
+  struct BulkElements {
+    std::vector<BulkField> m_fields;
+    unsigned int m_elementSize = 0;
+    //number of bytes written for each element
+    unsigned int m_streamedSize = 0;
+    //non zero if all builtins have this size and there is no padding
+    unsigned int m_uniformSize = 0;
+  };
 
   struct CollectionActions {
   CollectionActions( TVirtualCollectionProxy* proxy, int offset): 
@@ -16,9 +52,15 @@ namespace cce::tf::unrolling {
 
     std::unique_ptr<TVirtualCollectionProxy> m_collProxy;
     int m_offset;
+    //non zero if the elements are builtins which are streamed with the bulk byte swap kernels
+    unsigned int m_builtinSize = 0;
+    //m_fields is non empty if all elements are streamed in one pass
+    BulkElements m_bulkElements;
     OffsetAndSequences m_offsetAndSequences;
 
     std::vector<CollectionActions> m_collections;
+    //position in a depth first walk of all the collections, see indexCollectionProxies
+    std::size_t m_proxyIndex = 0;
   };
 
   using SequencesForCollections = std::vector<CollectionActions>;
@@ -28,9 +70,121 @@ namespace cce::tf::unrolling {
     SequencesForCollections m_collections;
   };
 
-  ObjectAndCollectionsSequences buildReadActionSequence(TClass& iClass);
-  ObjectAndCollectionsSequences buildWriteActionSequence(TClass& iClass);
+  //iBulk false streams each builtin with ROOT's actions, which is only useful for comparisons
+  ObjectAndCollectionsSequences buildReadActionSequence(TClass& iClass, bool iBulk = true);
+  ObjectAndCollectionsSequences buildWriteActionSequence(TClass& iClass, bool iBulk = true);
+
+  //A TVirtualCollectionProxy can only be used by one thread at a time. This sets m_proxyIndex
+  // for all collections and returns their proxies in that order so that copies, made with
+  // TVirtualCollectionProxy::Generate, can be held per thread.
+  std::vector<TVirtualCollectionProxy*> indexCollectionProxies(SequencesForCollections& ioCollections);
+
+  //The action sequences of one class which, once built, are only read and so can be
+  // shared by all lanes and outputers. Each user needs its own copies of the proxies.
+  struct SharedSequences {
+    ObjectAndCollectionsSequences m_sequences;
+    //see indexCollectionProxies
+    std::vector<TVirtualCollectionProxy*> m_proxies;
+
+    std::vector<std::unique_ptr<TVirtualCollectionProxy>> copyProxies() const;
+  private:
+    //TVirtualCollectionProxy::Generate is not thread safe
+    mutable std::mutex m_copyMutex;
+  };
+  //Process wide cache of the write action sequences. The sequences for a class are
+  // built by the first call asking for it.
+  std::shared_ptr<SharedSequences const> cachedWriteActionSequence(TClass& iClass, bool iBulk = true);
+  //builds the write action sequences of all of iClasses not yet in the cache using multiple tasks
+  void fillWriteActionSequenceCache(std::vector<TClass*> const& iClasses, bool iBulk = true);
+
+  //The decisions used when building the action sequences. These allow other code
+  // (e.g. generate_serializers) to reproduce the unrolled layout.
+  //this version creates a temporary instance of iClass
+  TStreamerInfo* buildStreamerInfo(TClass* iClass);
+  TStreamerInfo* buildStreamerInfo(TClass* iClass, void* iPointer);
+  bool canUnroll(TClass* iClass, TStreamerInfo* iInfo);
+  bool elementNeedsOwnSequence(TStreamerElement* iElement, TClass* iClass);
+  //returns nullptr if a std::vector of the EDataType iType is not unrolled
+  TClass* sequenceFinderForBuiltins(int iType);
+  //returns the number of bytes TBuffer uses for the EDataType iType if that is
+  // the same as in memory, else returns 0
+  unsigned int bulkBuiltinSize(int iType);
+
+  //throws a std::runtime_error saying iFunction needed iNBytes more than are left in iBuffer
+  [[noreturn]] void throwBufferOverrun(char const* iFunction, TBufferFile const& iBuffer, std::size_t iNBytes);
+
+  //stream iN builtins of iSize bytes in the same format as TBuffer::WriteFastArray/ReadFastArray.
+  // Conversions of more than iChunkBytes are split across tasks, see forEachChunk.
+  // Unlike ReadFastArray, reading past the end of the buffer throws rather than leaving the values unset.
+  inline void writeBuiltins(TBufferFile& oBuffer, void const* iFrom, std::size_t iN, unsigned int iSize, std::size_t iChunkBytes = 0) {
+    auto const nBytes = iN*iSize;
+    oBuffer.AutoExpand(oBuffer.Length()+nBytes);
+    char* to = oBuffer.Buffer()+oBuffer.Length();
+    auto from = static_cast<char const*>(iFrom);
+    forEachChunk(iN, iSize, iChunkBytes, [to, from, iSize](std::size_t iBegin, std::size_t iEnd) {
+        swap::copySwapped(to+iBegin*iSize, from+iBegin*iSize, iEnd-iBegin, iSize);
+      });
+    oBuffer.SetBufferOffset(oBuffer.Length()+nBytes);
+  }
+  inline void readBuiltins(TBufferFile& iBuffer, void* oTo, std::size_t iN, unsigned int iSize, std::size_t iChunkBytes = 0) {
+    auto const nBytes = iN*iSize;
+    if(iBuffer.Length()+nBytes > static_cast<std::size_t>(iBuffer.BufferSize())) {
+      throwBufferOverrun("readBuiltins", iBuffer, nBytes);
+    }
+    char const* from = iBuffer.Buffer()+iBuffer.Length();
+    auto to = static_cast<char*>(oTo);
+    forEachChunk(iN, iSize, iChunkBytes, [to, from, iSize](std::size_t iBegin, std::size_t iEnd) {
+        swap::copySwapped(to+iBegin*iSize, from+iBegin*iSize, iEnd-iBegin, iSize);
+      });
+    iBuffer.SetBufferOffset(iBuffer.Length()+nBytes);
+  }
 
+  //stream iN elements of a collection, the result is the same as streaming each element separately.
+  // As with readBuiltins, reading past the end of the buffer throws.
+  inline void writeElements(TBufferFile& oBuffer, void const* iFrom, std::size_t iN, BulkElements const& iBulk, std::size_t iChunkBytes = 0) {
+    auto const nBytes = iN*iBulk.m_streamedSize;
+    oBuffer.AutoExpand(oBuffer.Length()+nBytes);
+    char* to = oBuffer.Buffer()+oBuffer.Length();
+    auto from = static_cast<char const*>(iFrom);
+    forEachChunk(iN, iBulk.m_streamedSize, iChunkBytes, [to, from, &iBulk](std::size_t iBegin, std::size_t iEnd) {
+        char* chunkTo = to+iBegin*iBulk.m_streamedSize;
+        char const* chunkFrom = from+iBegin*iBulk.m_elementSize;
+        if(iBulk.m_uniformSize != 0) {
+          swap::copySwapped(chunkTo, chunkFrom, (iEnd-iBegin)*iBulk.m_streamedSize/iBulk.m_uniformSize, iBulk.m_uniformSize);
+          return;
+        }
+        for(std::size_t i=iBegin; i<iEnd; ++i, chunkFrom += iBulk.m_elementSize) {
+          for(auto const& field: iBulk.m_fields) {
+            swap::copySwapped(chunkTo, chunkFrom+field.m_offset, field.m_length, field.m_size);
+            chunkTo += field.m_size*field.m_length;
+          }
+        }
+      });
+    oBuffer.SetBufferOffset(oBuffer.Length()+nBytes);
+  }
+  inline void readElements(TBufferFile& iBuffer, void* oTo, std::size_t iN, BulkElements const& iBulk, std::size_t iChunkBytes = 0) {
+    auto const nBytes = iN*iBulk.m_streamedSize;
+    if(iBuffer.Length()+nBytes > static_cast<std::size_t>(iBuffer.BufferSize())) {
+      throwBufferOverrun("readElements", iBuffer, nBytes);
+    }
+    char const* from = iBuffer.Buffer()+iBuffer.Length();
+    auto to = static_cast<char*>(oTo);
+    forEachChunk(iN, iBulk.m_streamedSize, iChunkBytes, [to, from, &iBulk](std::size_t iBegin, std::size_t iEnd) {
+        char* chunkTo = to+iBegin*iBulk.m_elementSize;
+        char const* chunkFrom = from+iBegin*iBulk.m_streamedSize;
+        if(iBulk.m_uniformSize != 0) {
+          swap::copySwapped(chunkTo, chunkFrom, (iEnd-iBegin)*iBulk.m_streamedSize/iBulk.m_uniformSize, iBulk.m_uniformSize);
+          return;
+        }
+        for(std::size_t i=iBegin; i<iEnd; ++i, chunkTo += iBulk.m_elementSize) {
+          for(auto const& field: iBulk.m_fields) {
+            swap::copySwapped(chunkTo+field.m_offset, chunkFrom, field.m_length, field.m_size);
+            chunkFrom += field.m_size*field.m_length;
+          }
+        }
+      });
+    iBuffer.SetBufferOffset(iBuffer.Length()+nBytes);
+  }
 
 }
 #endif
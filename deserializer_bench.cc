@@ -0,0 +1,119 @@
+#include "Serializer.h"
+#include "Deserializer.h"
+#include "UnrolledSerializer.h"
+#include "UnrolledDeserializer.h"
+
+#include "TClass.h"
+#include "TBufferFile.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "test_classes/TestClasses.h"
+
+/*---------------------------------------
+Measures the per call cost of deserializing small data products. The
+'new buffer' column constructs a TBufferFile for each call, which is what
+Deserializer and UnrolledDeserializer used to do. The other columns use the
+deserializers which reuse one read buffer. Each deserializer reads the
+format written by its matching serializer and the object read back is
+checked against the original before anything is timed.
+
+  deserializer_bench [number of calls]
+  ---------------------------------------*/
+namespace {
+  using clock_type = std::chrono::high_resolution_clock;
+
+  template<typename F>
+  double nsPerCall(unsigned int iNCalls, F&& iFunc) {
+    //warm up caches and allocators
+    for(unsigned int i=0; i< iNCalls/10+1; ++i) {
+      iFunc();
+    }
+    auto start = clock_type::now();
+    for(unsigned int i=0; i<iNCalls; ++i) {
+      iFunc();
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now()-start).count()/double(iNCalls);
+  }
+
+  template<typename T>
+  bool isSame(T const& iLHS, T const& iRHS) {
+    return iLHS == iRHS;
+  }
+
+  bool isSame(cce::tf::test::TestClassWithFloatVector const& iLHS, cce::tf::test::TestClassWithFloatVector const& iRHS) {
+    return iLHS.values() == iRHS.values();
+  }
+
+  //iRead must fill a default constructed object which is then compared to iObject
+  template<typename T, typename F>
+  void check(const char* iName, const char* iReader, T const& iObject, F&& iRead) {
+    T readObject;
+    iRead(readObject);
+    if(not isSame(iObject, readObject)) {
+      std::cout <<iReader<<" did not read back the same "<<iName<<std::endl;
+      abort();
+    }
+  }
+
+  template<typename T>
+  void bench(const char* iName, T const& iObject, unsigned int iNCalls) {
+    using namespace cce::tf;
+    auto cls = TClass::GetClass(typeid(T));
+    if(nullptr == cls) {
+      std::cout <<"FAILED TO GET CLASS "<<iName<<std::endl;
+      abort();
+    }
+    Serializer s;
+    auto blob = s.serialize(&iObject, cls);
+    std::vector<char> buffer(blob.begin(), blob.end());
+
+    UnrolledSerializer us(cls);
+    auto unrolledBlob = us.serialize(&iObject);
+    std::vector<char> unrolledBuffer(unrolledBlob.begin(), unrolledBlob.end());
+
+    auto readNewBuffer = [&](T& oObject) {
+      TBufferFile bufferFile{TBuffer::kRead};
+      bufferFile.SetBuffer(buffer.data(), buffer.size(), kFALSE);
+      cls->ReadBuffer(bufferFile, &oObject);
+    };
+    Deserializer d(cls);
+    auto readReused = [&](T& oObject) {
+      d.deserialize(buffer.data(), buffer.size(), &oObject);
+    };
+    UnrolledDeserializer ud(cls);
+    auto readUnrolled = [&](T& oObject) {
+      ud.deserialize(unrolledBuffer.data(), unrolledBuffer.size(), &oObject);
+    };
+
+    check(iName, "new buffer", iObject, readNewBuffer);
+    check(iName, "Deserializer", iObject, readReused);
+    check(iName, "UnrolledDeserializer", iObject, readUnrolled);
+
+    T readObject;
+    auto newBuffer = nsPerCall(iNCalls, [&]() { readNewBuffer(readObject); });
+    auto reused = nsPerCall(iNCalls, [&]() { readReused(readObject); });
+    auto unrolled = nsPerCall(iNCalls, [&]() { readUnrolled(readObject); });
+
+    std::cout <<iName<<" ("<<buffer.size()<<" bytes, unrolled "<<unrolledBuffer.size()<<" bytes)\n"
+              <<"  new buffer: "<<newBuffer<<"ns/call\n"
+              <<"  Deserializer: "<<reused<<"ns/call\n"
+              <<"  UnrolledDeserializer: "<<unrolled<<"ns/call"<<std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned int nCalls = 1000000;
+  if(argc > 1) {
+    nCalls = std::stoul(argv[1]);
+  }
+
+  bench("std::vector<int>", std::vector<int>{1,2,3}, nCalls);
+  bench("cce::tf::test::SimpleClass", cce::tf::test::SimpleClass(5), nCalls);
+  bench("cce::tf::test::TestClass", cce::tf::test::TestClass("foo", 78.9), nCalls);
+  bench("cce::tf::test::TestClassWithFloatVector", cce::tf::test::TestClassWithFloatVector({1,2,3,5}), nCalls);
+  return 0;
+}
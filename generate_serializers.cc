@@ -0,0 +1,335 @@
+/*---------------------------------------
+generate_serializers writes a C++ source file holding type specific
+serialize/deserialize functions for the classes listed in ROOT dictionary
+selection files (classes_def.xml). The functions write exactly the same
+bytes as UnrolledSerializer, but the member offsets, types and collection
+types are fixed at compile time instead of being interpreted from
+TActionSequences and TVirtualCollectionProxies at run time.
+
+Only classes whose unrolled layout is built entirely from
+  - builtin data members (and fixed length arrays of builtins)
+  - unrollable classes held by value
+  - std::vector of builtins
+  - std::vector of classes which themselves follow these rules
+are generated. All others are skipped and GeneratedSerializer falls back
+to the unrolled code. When recycling, std::vectors are resized in place so
+their elements, and the capacity of any nested std::vectors, are reused.
+
+generate_serializers <output file> [--load <dictionary library>]... [--include <header>]... <classes_def.xml>...
+  ---------------------------------------*/
+#include "common_unrolling.h"
+
+#include "TClass.h"
+#include "TSystem.h"
+#include "TStreamerInfo.h"
+#include "TStreamerElement.h"
+#include "TVirtualCollectionProxy.h"
+
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+  using namespace cce::tf;
+
+  //returns the C++ type used to stream the TStreamerInfo basic type or nullptr if not handled
+  char const* basicTypeName(int iType) {
+    switch(iType) {
+    case TVirtualStreamerInfo::kChar: return "Char_t";
+    case TVirtualStreamerInfo::kShort: return "Short_t";
+    case TVirtualStreamerInfo::kInt: return "Int_t";
+    case TVirtualStreamerInfo::kCounter: return "Int_t";
+    case TVirtualStreamerInfo::kLong: return "Long_t";
+    case TVirtualStreamerInfo::kFloat: return "Float_t";
+    case TVirtualStreamerInfo::kDouble: return "Double_t";
+    case TVirtualStreamerInfo::kUChar: return "UChar_t";
+    case TVirtualStreamerInfo::kUShort: return "UShort_t";
+    case TVirtualStreamerInfo::kUInt: return "UInt_t";
+    case TVirtualStreamerInfo::kULong: return "ULong_t";
+    case TVirtualStreamerInfo::kLong64: return "Long64_t";
+    case TVirtualStreamerInfo::kULong64: return "ULong64_t";
+    case TVirtualStreamerInfo::kBool: return "Bool_t";
+    }
+    //kDouble32, kFloat16, kBits, kCharStar, ... need special handling
+    return nullptr;
+  }
+
+  //EDataType used by collection proxies
+  char const* dataTypeName(int iType) {
+    switch(iType) {
+    case kChar_t: return "Char_t";
+    case kUChar_t: return "UChar_t";
+    case kShort_t: return "Short_t";
+    case kUShort_t: return "UShort_t";
+    case kInt_t: return "Int_t";
+    case kUInt_t: return "UInt_t";
+    case kLong_t: return "Long_t";
+    case kULong_t: return "ULong_t";
+    case kFloat_t: return "Float_t";
+    case kDouble_t: return "Double_t";
+    }
+    return nullptr;
+  }
+
+  //Holds the code for one 'level' of the unrolled layout. As in UnrolledSerializer
+  // all object members of a level are streamed before any of its collections.
+  struct Level {
+    std::ostringstream writeObjects_;
+    std::ostringstream readObjects_;
+    std::ostringstream writeCollections_;
+    std::ostringstream readCollections_;
+  };
+
+  class Generator {
+  public:
+    //returns false if the class can not be generated
+    bool generate(TClass& iClass, std::string const& iFunctionSuffix, std::ostream& oOut);
+
+  private:
+    bool addElement(TStreamerElement* iElement, TClass& iClass, long iBaseOffset, std::string const& iAddress,
+                    std::set<TClass const*>& iHierarchy, Level& oLevel);
+    bool addClassElements(TStreamerInfo& iInfo, TClass& iClass, TClass& iCheckClass, long iBaseOffset, std::string const& iAddress,
+                          std::set<TClass const*>& iHierarchy, Level& oLevel);
+
+    std::string nextVariable() { return "v"+std::to_string(nVariables_++); }
+    std::string nextAddress() { return "a"+std::to_string(nVariables_++); }
+
+    unsigned int nVariables_ = 0;
+  };
+
+  bool Generator::addClassElements(TStreamerInfo& iInfo, TClass& iClass, TClass& iCheckClass, long iBaseOffset, std::string const& iAddress,
+                                   std::set<TClass const*>& iHierarchy, Level& oLevel) {
+    TIter next(iInfo.GetElements());
+    TStreamerElement* element = nullptr;
+    while( (element = static_cast<TStreamerElement*>(next())) ) {
+      if(not unrolling::elementNeedsOwnSequence(element, &iCheckClass)) {
+        continue;
+      }
+      if(not addElement(element, iClass, iBaseOffset, iAddress, iHierarchy, oLevel)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //mirrors addUnrolledActionSequencesForElement in common_unrolling.cc
+  bool Generator::addElement(TStreamerElement* iElement, TClass& iClass, long iBaseOffset, std::string const& iAddress,
+                             std::set<TClass const*>& iHierarchy, Level& oLevel) {
+    if(not unrolling::elementNeedsOwnSequence(iElement, &iClass)) {
+      return true;
+    }
+    auto const offset = iBaseOffset + iElement->GetOffset();
+    auto ptr = iElement->GetClassPointer();
+    if(ptr) {
+      TStreamerInfo* sinfo = unrolling::buildStreamerInfo(ptr, nullptr);
+      if(unrolling::canUnroll(ptr, sinfo) and iHierarchy.end() == iHierarchy.find(ptr)) {
+        return addClassElements(*sinfo, *ptr, *ptr, offset, iAddress, iHierarchy, oLevel);
+      }
+      if(ptr->CanSplit()) {
+        auto collProxy = ptr->GetCollectionProxy();
+        if(collProxy && not collProxy->HasPointers() && collProxy->GetCollectionType() == ROOT::kSTLvector) {
+          auto valueClass = collProxy->GetValueClass();
+          if(valueClass) {
+            TStreamerInfo* valueInfo = unrolling::buildStreamerInfo(valueClass, nullptr);
+            if(unrolling::canUnroll(valueClass, valueInfo) and iHierarchy.end() == iHierarchy.find(valueClass)) {
+              iHierarchy.insert(valueClass);
+              auto vectorName = nextVariable();
+              auto elementName = nextAddress();
+              Level elementLevel;
+              //NOTE: offsets are relative to the address of the element of the container
+              if(not addClassElements(*valueInfo, *valueClass, *ptr, 0, elementName, iHierarchy, elementLevel)) {
+                return false;
+              }
+              iHierarchy.erase(valueClass);
+
+              std::string const vectorType = std::string("std::vector<")+valueClass->GetName()+">";
+              oLevel.writeCollections_ <<"  {\n"
+                "    auto const& "<<vectorName<<" = *reinterpret_cast<"<<vectorType<<" const*>("<<iAddress<<"+"<<offset<<");\n"
+                "    Int_t const size = "<<vectorName<<".size();\n"
+                "    b << size;\n"
+                "    for(auto const& e: "<<vectorName<<") {\n"
+                "      char const* "<<elementName<<" = reinterpret_cast<char const*>(&e);\n"
+                                       <<elementLevel.writeObjects_.str()<<elementLevel.writeCollections_.str()<<
+                "    }\n"
+                "  }\n";
+              oLevel.readCollections_ <<"  {\n"
+                "    auto& "<<vectorName<<" = *reinterpret_cast<"<<vectorType<<"*>("<<iAddress<<"+"<<offset<<");\n"
+                "    Int_t size;\n"
+                "    b >> size;\n"
+                "    if(not recycle) {\n"
+                "      "<<vectorName<<".clear();\n"
+                "    }\n"
+                "    "<<vectorName<<".resize(size);\n"
+                "    for(auto& e: "<<vectorName<<") {\n"
+                "      char* "<<elementName<<" = reinterpret_cast<char*>(&e);\n"
+                                      <<elementLevel.readObjects_.str()<<elementLevel.readCollections_.str()<<
+                "    }\n"
+                "  }\n";
+              return true;
+            }
+          }
+        }
+      } else {
+        auto collProxy = ptr->GetCollectionProxy();
+        if(collProxy && collProxy->GetCollectionType() == ROOT::kSTLvector and not collProxy->GetValueClass()
+           and unrolling::sequenceFinderForBuiltins(collProxy->GetType())) {
+          auto type = dataTypeName(collProxy->GetType());
+          if(not type) {
+            return false;
+          }
+          auto vectorName = nextVariable();
+          std::string const vectorType = std::string("std::vector<")+type+">";
+          //UnrolledSerializer writes each element separately, which gives the same bytes as WriteFastArray
+          oLevel.writeCollections_ <<"  {\n"
+            "    auto const& "<<vectorName<<" = *reinterpret_cast<"<<vectorType<<" const*>("<<iAddress<<"+"<<offset<<");\n"
+            "    Int_t const size = "<<vectorName<<".size();\n"
+            "    b << size;\n"
+            "    b.WriteFastArray("<<vectorName<<".data(), size);\n"
+            "  }\n";
+          oLevel.readCollections_ <<"  {\n"
+            "    auto& "<<vectorName<<" = *reinterpret_cast<"<<vectorType<<"*>("<<iAddress<<"+"<<offset<<");\n"
+            "    Int_t size;\n"
+            "    b >> size;\n"
+            "    if(not recycle) {\n"
+            "      "<<vectorName<<".clear();\n"
+            "    }\n"
+            "    "<<vectorName<<".resize(size);\n"
+            "    b.ReadFastArray("<<vectorName<<".data(), size);\n"
+            "  }\n";
+          return true;
+        }
+      }
+      //a class which is streamed by ROOT as a whole
+      return false;
+    }
+
+    auto streamerType = iElement->GetType();
+    if(streamerType > TVirtualStreamerInfo::kOffsetL and streamerType < TVirtualStreamerInfo::kOffsetP) {
+      auto type = basicTypeName(streamerType - TVirtualStreamerInfo::kOffsetL);
+      if(not type) {
+        return false;
+      }
+      auto length = iElement->GetArrayLength();
+      oLevel.writeObjects_ <<"  b.WriteFastArray(reinterpret_cast<"<<type<<" const*>("<<iAddress<<"+"<<offset<<"), "<<length<<");\n";
+      oLevel.readObjects_ <<"  b.ReadFastArray(reinterpret_cast<"<<type<<"*>("<<iAddress<<"+"<<offset<<"), "<<length<<");\n";
+      return true;
+    }
+    auto type = basicTypeName(streamerType);
+    if(not type) {
+      return false;
+    }
+    oLevel.writeObjects_ <<"  b << *reinterpret_cast<"<<type<<" const*>("<<iAddress<<"+"<<offset<<");\n";
+    oLevel.readObjects_ <<"  b >> *reinterpret_cast<"<<type<<"*>("<<iAddress<<"+"<<offset<<");\n";
+    return true;
+  }
+
+  bool Generator::generate(TClass& iClass, std::string const& iFunctionSuffix, std::ostream& oOut) {
+    if(iClass.GetCollectionProxy() or not iClass.HasDataMemberInfo() or iClass.HasCustomStreamerMember()) {
+      return false;
+    }
+    TStreamerInfo* sinfo = unrolling::buildStreamerInfo(&iClass);
+    if(not sinfo or not unrolling::canUnroll(&iClass, sinfo)) {
+      return false;
+    }
+    std::set<TClass const*> hierarchy;
+    hierarchy.insert(&iClass);
+    Level level;
+    if(not addClassElements(*sinfo, iClass, iClass, 0, "a", hierarchy, level)) {
+      return false;
+    }
+    oOut <<"//"<<iClass.GetName()<<"\n"
+      "void write_"<<iFunctionSuffix<<"(TBufferFile& b, char const* a) {\n"
+         <<level.writeObjects_.str()<<level.writeCollections_.str()<<
+      "}\n"
+      "void read_"<<iFunctionSuffix<<"(TBufferFile& b, char* a, bool recycle) {\n"
+         <<level.readObjects_.str()<<level.readCollections_.str()<<
+      "}\n\n";
+    return true;
+  }
+
+  std::vector<std::string> classNamesFromSelectionFile(std::string const& iFileName) {
+    std::ifstream file(iFileName);
+    if(not file.is_open()) {
+      std::cout <<"unable to open file "<<iFileName<<std::endl;
+      exit(1);
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    auto text = content.str();
+
+    std::vector<std::string> names;
+    std::regex const classEntry(R"(<class\s+name\s*=\s*"([^"]+)")");
+    for(auto it = std::sregex_iterator(text.begin(), text.end(), classEntry); it != std::sregex_iterator(); ++it) {
+      names.push_back((*it)[1].str());
+    }
+    return names;
+  }
+}
+
+int main(int argc, char** argv) {
+  if(argc < 2) {
+    std::cout <<"usage: generate_serializers <output file> [--load <library>]... [--include <header>]... <classes_def.xml>..."<<std::endl;
+    return 1;
+  }
+  std::string const outputName = argv[1];
+  std::vector<std::string> includes;
+  std::vector<std::string> classNames;
+  for(int i=2; i<argc; ++i) {
+    std::string arg = argv[i];
+    if(arg == "--load" and i+1 < argc) {
+      if(gSystem->Load(argv[++i]) < 0) {
+        std::cout <<"unable to load library "<<argv[i]<<std::endl;
+        return 1;
+      }
+    } else if(arg == "--include" and i+1 < argc) {
+      includes.emplace_back(argv[++i]);
+    } else {
+      auto names = classNamesFromSelectionFile(arg);
+      classNames.insert(classNames.end(), names.begin(), names.end());
+    }
+  }
+
+  std::ostringstream functions;
+  std::vector<std::string> generated;
+  Generator generator;
+  for(auto const& name: classNames) {
+    auto cls = TClass::GetClass(name.c_str());
+    if(not cls) {
+      std::cout <<"generate_serializers: no dictionary for "<<name<<std::endl;
+      continue;
+    }
+    if(generator.generate(*cls, std::to_string(generated.size()), functions)) {
+      generated.emplace_back(cls->GetName());
+    } else {
+      std::cout <<"generate_serializers: "<<name<<" will use the unrolled serializer"<<std::endl;
+    }
+  }
+
+  std::ofstream out(outputName);
+  out <<"//Generated by generate_serializers. Do not edit.\n"
+    "#include \"GeneratedSerializers.h\"\n"
+    "#include \"TBufferFile.h\"\n"
+    "#include <vector>\n";
+  for(auto const& h: includes) {
+    out <<"#include \""<<h<<"\"\n";
+  }
+  out <<"\nnamespace {\n"<<functions.str();
+  out <<"cce::tf::generated::Entry const s_entries[] = {\n";
+  for(std::size_t i=0; i< generated.size(); ++i) {
+    out <<"  {\""<<generated[i]<<"\", &write_"<<i<<", &read_"<<i<<"},\n";
+  }
+  //avoid a zero length array
+  out <<"  {nullptr, nullptr, nullptr}\n"
+    "};\n"
+    "}\n\n"
+    "namespace cce::tf::generated {\n"
+    "  Span<Entry const> entries() {\n"
+    "    return Span<Entry const>(s_entries, "<<generated.size()<<");\n"
+    "  }\n"
+    "}\n";
+  return 0;
+}
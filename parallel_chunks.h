@@ -0,0 +1,35 @@
+#if !defined(parallel_chunks_h)
+#define parallel_chunks_h
+
+#include <algorithm>
+#include <cstddef>
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+#include "tbb/task_arena.h"
+
+namespace cce::tf {
+  /*---------------------------------------
+  Calls iFunc(begin, end) for ranges covering [0, iN) items. If the items
+  take more than iChunkBytes the ranges, each about iChunkBytes long, are
+  run concurrently on separate tasks. An iChunkBytes of 0 means never split.
+
+  The calling thread only works on the chunks while waiting. Without that
+  isolation it could start unrelated tasks (e.g. another data product
+  using the same per thread state) in the middle of a serialization.
+  ---------------------------------------*/
+  template<typename F>
+  void forEachChunk(std::size_t iN, std::size_t iBytesPerItem, std::size_t iChunkBytes, F&& iFunc) {
+    if(iChunkBytes == 0 or iN*iBytesPerItem <= iChunkBytes) {
+      iFunc(std::size_t(0), iN);
+      return;
+    }
+    std::size_t const itemsPerChunk = std::max<std::size_t>(1, iChunkBytes/std::max<std::size_t>(1,iBytesPerItem));
+    tbb::this_task_arena::isolate([&]() {
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, iN, itemsPerChunk),
+                          [&](tbb::blocked_range<std::size_t> const& iRange) {
+                            iFunc(iRange.begin(), iRange.end());
+                          }, tbb::simple_partitioner());
+      });
+  }
+}
+#endif
@@ -12,7 +12,11 @@ namespace cce::tf::pds {
       return pds::Compression::kLZ4;
     } else if (compressionName == "ZSTD") {
       return pds::Compression::kZSTD;
-    } 
+    } else if (compressionName == "LZ4HC") {
+      return pds::Compression::kLZ4HC;
+    } else if (compressionName == "LongZSTD") {
+      return pds::Compression::kZSTDLong;
+    }
     return {};
   }
 
@@ -32,6 +36,15 @@ namespace cce::tf::pds {
       {
         return "ZSTD";
       }
+    case Compression::kLZ4HC:
+      {
+        return "LZ4HC";
+      }
+    case Compression::kZSTDLong:
+      {
+        //"ZSTDLong" would not be distinguishable from "ZSTD" in 4 characters
+        return "LongZSTD";
+      }
     }
     //should never get here
     return "";
@@ -42,6 +55,10 @@ namespace cce::tf::pds {
       return pds::Serialization::kRoot;
     } else if(serializationName == "ROOTUnrolled" or serializationName=="Unrolled") {
       return pds::Serialization::kRootUnrolled;
+    } else if(serializationName == "Generated") {
+      return pds::Serialization::kGenerated;
+    } else if(serializationName == "Native") {
+      return pds::Serialization::kNative;
     }
     return {};
   }
@@ -5,8 +5,24 @@
 #include <string_view>
 
 namespace cce::tf::pds {
-  enum class Compression {kNone, kLZ4, kZSTD};
-  enum class Serialization {kRoot, kRootUnrolled};
+  //kLZ4HC is read the same way as kLZ4 and kZSTDLong as kZSTD, they only differ in how the data is compressed
+  enum class Compression {kNone, kLZ4, kZSTD, kLZ4HC, kZSTDLong};
+  enum class Serialization {kRoot, kRootUnrolled, kGenerated, kNative};
+  //kEvent compresses all data products of an event together, kProduct compresses each data product on its own
+  enum class Layout {kEvent, kProduct};
+
+  //advanced ZSTD settings, a value of 0 (or false) keeps what ZSTD chooses for the compression level
+  struct ZSTDParameters {
+    int windowLog = 0;
+    //one of the ZSTD_strategy values, 1 (ZSTD_fast) to 9 (ZSTD_btultra2)
+    int strategy = 0;
+    bool longDistanceMatching = false;
+
+    bool operator==(ZSTDParameters const& iOther) const {
+      return windowLog == iOther.windowLog and strategy == iOther.strategy and longDistanceMatching == iOther.longDistanceMatching;
+    }
+    bool operator!=(ZSTDParameters const& iOther) const { return not operator==(iOther); }
+  };
 
   //returned value is guaranteed to have starting 4 
   // characters be unique for each compression factor
@@ -1,12 +1,18 @@
 #include "pds_reading.h"
+#include "shuffle_kernels.h"
 #include <cassert>
 #include <array>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
+#include <string>
+#include <stdexcept>
 
 #include "lz4.h"
 #include "zstd.h"
 
+#include "tbb/parallel_for.h"
+
 #include "TClass.h"
 #include "TBufferFile.h"
 
@@ -14,32 +20,102 @@ using namespace cce::tf::pds;
 
 namespace {
   Compression whichCompression(const char* iName) {
-  if(iName[0] == 'N') {
-    return Compression::kNone;
-  }
-  if(iName[0] == 'L') {
-    return Compression::kLZ4;
-  }
-  if(iName[0] == 'Z') {
-    return Compression::kZSTD;
+  //pds::name guarantees the first 4 characters differ for each compression
+  for(auto compression: {Compression::kNone, Compression::kLZ4, Compression::kZSTD, Compression::kLZ4HC, Compression::kZSTDLong}) {
+    if(std::strncmp(iName, name(compression), 4) == 0) {
+      return compression;
+    }
   }
   assert(false);
   return Compression::kNone;
 }
 
+  //the HC and long distance matching variants are uncompressed the same way as the plain algorithms
+  bool isLZ4(Compression iCompression) {
+    return Compression::kLZ4 == iCompression or Compression::kLZ4HC == iCompression;
+  }
+  bool isZSTD(Compression iCompression) {
+    return Compression::kZSTD == iCompression or Compression::kZSTDLong == iCompression;
+  }
+
+  //ZSTD_decompress creates and destroys a ZSTD_DCtx on each call, instead each thread reuses one
+  class ZSTDDecompressor {
+  public:
+    ZSTDDecompressor(): context_{ZSTD_createDCtx()} {
+      //long distance matching or a large windowLog can need a window beyond ZSTD's default limit
+      ZSTD_DCtx_setParameter(context_, ZSTD_d_windowLogMax, ZSTD_dParam_getBounds(ZSTD_d_windowLogMax).upperBound);
+    }
+    ~ZSTDDecompressor() { ZSTD_freeDCtx(context_); }
+    ZSTDDecompressor(ZSTDDecompressor const&) = delete;
+    ZSTDDecompressor& operator=(ZSTDDecompressor const&) = delete;
+
+    size_t decompress(void* oTo, size_t iToSize, void const* iFrom, size_t iFromSize, ZSTD_DDict const* iDictionary) {
+      if(iDictionary) {
+        return ZSTD_decompress_usingDDict(context_, oTo, iToSize, iFrom, iFromSize, iDictionary);
+      }
+      return ZSTD_decompressDCtx(context_, oTo, iToSize, iFrom, iFromSize);
+    }
+  private:
+    ZSTD_DCtx* context_;
+  };
+
+  //The uncompressed bytes are written to memory which is not initialized so anything but exactly
+  // iToSize bytes, e.g. from a corrupt frame or the wrong dictionary, must not be used.
+  void zstdDecompress(void* oTo, size_t iToSize, void const* iFrom, size_t iFromSize, DecompressionDictionary const* iDictionary) {
+    static thread_local ZSTDDecompressor s_decompressor;
+    auto size = s_decompressor.decompress(oTo, iToSize, iFrom, iFromSize, iDictionary ? iDictionary->zstdDictionary() : nullptr);
+    if(ZSTD_isError(size)) {
+      throw std::runtime_error(std::string("ZSTD failed to decompress: ")+ZSTD_getErrorName(size));
+    }
+    if(size != iToSize) {
+      throw std::runtime_error("ZSTD decompressed less bytes ("+std::to_string(size)+") than expected ("+std::to_string(iToSize)+")");
+    }
+  }
+
+  void lz4Decompress(char* oTo, size_t iToSize, char const* iFrom, size_t iFromSize) {
+    auto size = LZ4_decompress_safe(iFrom, oTo, iFromSize, iToSize);
+    if(size < 0) {
+      throw std::runtime_error("LZ4_decompress_safe failed to decompress");
+    }
+    if(size_t(size) != iToSize) {
+      throw std::runtime_error("LZ4_decompress_safe decompressed less bytes ("+std::to_string(size)+") than expected ("+std::to_string(iToSize)+")");
+    }
+  }
+
+  void uncompressInto(Compression iCompression, char const* iFrom, size_t iFromSize, char* oTo, size_t iToSize, DecompressionDictionary const* iDictionary) {
+    if(isLZ4(iCompression)) {
+      lz4Decompress(oTo, iToSize, iFrom, iFromSize);
+    } else if(isZSTD(iCompression)) {
+      zstdDecompress(oTo, iToSize, iFrom, iFromSize, iDictionary);
+    } else if(Compression::kNone == iCompression) {
+      assert(iFromSize == iToSize);
+      std::copy(iFrom, iFrom+iFromSize, oTo);
+    }
+  }
+
   struct Preamble {
     uint32_t bufferSize;
     Compression compression;
     Serialization serialization;
+    Layout layout;
+    //true if each event header ends with the level used to compress the event
+    bool hasCompressionLevel;
   };
 Preamble readPreamble(std::istream& iFile) {
   std::array<uint32_t, 4> header;
   iFile.read(reinterpret_cast<char*>(header.data()),4*4);
   assert(iFile.rdstate() == std::ios_base::goodbit);
 
-  assert(3141592*256+1 == header[0] or 3141592*256+2 == header[0]);
-  Serialization serialization = (header[0] -3141592*256-1) == 0? Serialization::kRoot : Serialization::kRootUnrolled; 
-  return {header[3], whichCompression(reinterpret_cast<const char*>(&header[2])), serialization};
+  //the serialization is in the lowest 4 bits, the layout in the next 3 and the
+  // highest bit is set if the event headers hold the compression level
+  auto const idOffset = header[0] -3141592*256-1;
+  assert(3141592*256+1 <= header[0] and header[0] < 3141592*256+256);
+  assert((idOffset & 0xF) <= static_cast<uint32_t>(Serialization::kNative));
+  assert(((idOffset >> 4) & 0x7) <= static_cast<uint32_t>(Layout::kProduct));
+  Serialization serialization{static_cast<int>(idOffset & 0xF)};
+  Layout layout{static_cast<int>((idOffset >> 4) & 0x7)};
+  bool const hasCompressionLevel = (idOffset & 0x80) != 0;
+  return {header[3], whichCompression(reinterpret_cast<const char*>(&header[2])), serialization, layout, hasCompressionLevel};
 }
 
 using buffer_iterator = std::vector<std::uint32_t>::const_iterator;
@@ -89,7 +165,8 @@ size_t bytesToWords(size_t nBytes) {
   return nBytes/4 + ( (nBytes % 4) == 0 ? 0 : 1);
 }
 
-  std::vector<ProductInfo> readProductInfo(buffer_iterator& itBuffer, buffer_iterator itEnd, std::vector<std::string> const& iClassNames) {
+  //for Layout::kProduct each data product also has the size used to shuffle its bytes
+  std::vector<ProductInfo> readProductInfo(buffer_iterator& itBuffer, buffer_iterator itEnd, std::vector<std::string> const& iClassNames, bool iHasShuffleSize) {
   assert(itBuffer != itEnd);
   //should be a loop over records, but we only have 1 for now
   auto nDataProducts = *(itBuffer++);
@@ -100,13 +177,18 @@ size_t bytesToWords(size_t nBytes) {
     assert(itBuffer < itEnd);
     auto classIndex = *(itBuffer++);
     assert(itBuffer < itEnd);
+    uint32_t shuffleSize = 0;
+    if(iHasShuffleSize) {
+      shuffleSize = *(itBuffer++);
+      assert(itBuffer < itEnd);
+    }
 
     const char* itChars = reinterpret_cast<const char*>(&(*itBuffer));
     std::string name(itChars);
     itBuffer = itBuffer + bytesToWords(name.size()+1);
     assert(itBuffer <= itEnd);
     //std::cout <<name <<" "<<classIndex<<std::endl;
-    info.emplace_back(std::move(name), classIndex, iClassNames[classIndex]);
+    info.emplace_back(std::move(name), classIndex, iClassNames[classIndex], shuffleSize);
   }
 
   return info;
@@ -136,11 +218,19 @@ std::vector<uint32_t> pds::readWords(std::istream& iFile, uint32_t bufferSize) {
   return words;
 }
 
-std::vector<ProductInfo> pds::readFileHeader(std::istream& file, Compression& compression, Serialization& serialization) {
+pds::DecompressionDictionary::DecompressionDictionary(std::vector<char> const& iBytes) {
+  if(not iBytes.empty()) {
+    dDict_ = std::shared_ptr<ZSTD_DDict>(ZSTD_createDDict(iBytes.data(), iBytes.size()), ZSTD_freeDDict);
+  }
+}
+
+std::vector<ProductInfo> pds::readFileHeader(std::istream& file, Compression& compression, Serialization& serialization, Layout& layout, std::vector<char>& oDictionary, std::size_t& oEventHeaderSizeInWords) {
   auto preamble = readPreamble(file);
   auto bufferSize = preamble.bufferSize;
   compression = preamble.compression;
   serialization = preamble.serialization;
+  layout = preamble.layout;
+  oEventHeaderSizeInWords = preamble.hasCompressionLevel ? kEventHeaderWithLevelSizeInWords : kEventHeaderSizeInWords;
 
   //1 word beyond the buffer is the crosscheck value
   std::vector<uint32_t> buffer = readWords(file, bufferSize+1);
@@ -151,31 +241,50 @@ std::vector<ProductInfo> pds::readFileHeader(std::istream& file, Compression& co
   auto types = readTypes(itBuffer, itEnd);
   //non-top level types
   readTypes(itBuffer, itEnd);
-  auto productInfo = readProductInfo(itBuffer, itEnd, types);
+  auto productInfo = readProductInfo(itBuffer, itEnd, types, layout == Layout::kProduct);
   assert(itBuffer != itEnd);
+  oDictionary.clear();
+  if(itBuffer+1 != itEnd) {
+    //optional ZSTD dictionary: size in bytes followed by the bytes padded to a word
+    auto dictionarySize = *(itBuffer++);
+    assert(itBuffer+bytesToWords(dictionarySize) < itEnd);
+    const char* itChars = reinterpret_cast<const char*>(&(*itBuffer));
+    oDictionary.assign(itChars, itChars+dictionarySize);
+    itBuffer = itBuffer + bytesToWords(dictionarySize);
+  }
   assert(itBuffer+1 == itEnd);
   //std::cout <<*itBuffer <<" "<<bufferSize<<std::endl;
   assert(*itBuffer == bufferSize);
   return productInfo;
 }
 
-bool pds::readCompressedEventBuffer(std::istream&file, EventIdentifier& iEventID, std::vector<uint32_t>& buffer) {
+bool pds::readCompressedEventBuffer(std::istream&file, EventIdentifier& iEventID, std::vector<uint32_t>& buffer, std::size_t iHeaderSizeInWords, std::optional<int>* oCompressionLevel) {
   //header structure in words
   //constexpr size_t kTransitionTypeW=0;
   constexpr size_t kEventIDMSW=3;
   constexpr size_t kEventIDLSW=4;
   constexpr size_t kRunIDW=1;
   constexpr size_t kLumiIDW=2;
+  constexpr size_t kCompressionLevelW=5;
+  assert(iHeaderSizeInWords == kEventHeaderSizeInWords or iHeaderSizeInWords == kEventHeaderWithLevelSizeInWords);
 
   //std::cout <<"readEventContent"<<std::endl;
-  std::array<uint32_t, kEventHeaderSizeInWords+1> headerBuffer;
-  file.read(reinterpret_cast<char*>(headerBuffer.data()), (kEventHeaderSizeInWords+1)*4);
+  std::array<uint32_t, kEventHeaderWithLevelSizeInWords+1> headerBuffer;
+  file.read(reinterpret_cast<char*>(headerBuffer.data()), (iHeaderSizeInWords+1)*4);
   if( file.rdstate() & std::ios_base::eofbit) {
     return false;
   }
   assert(file.rdstate() == std::ios_base::goodbit);
 
-  int32_t bufferSize = headerBuffer[kEventHeaderSizeInWords];
+  int32_t bufferSize = headerBuffer[iHeaderSizeInWords];
+  if(oCompressionLevel) {
+    if(iHeaderSizeInWords == kEventHeaderWithLevelSizeInWords) {
+      //the level is stored as a signed value since ZSTD allows negative levels
+      *oCompressionLevel = static_cast<int32_t>(headerBuffer[kCompressionLevelW]);
+    } else {
+      oCompressionLevel->reset();
+    }
+  }
 
   unsigned long long eventIDTopWord = headerBuffer[kEventIDMSW];
   eventIDTopWord = eventIDTopWord <<32;
@@ -191,28 +300,95 @@ bool pds::readCompressedEventBuffer(std::istream&file, EventIdentifier& iEventID
 }
 
 
-std::vector<uint32_t> pds::uncompressEventBuffer(pds::Compression compression, std::vector<uint32_t> const& buffer) {
+Span<uint32_t const> pds::uncompressEventBuffer(pds::Compression compression, std::vector<uint32_t> const& buffer, UninitializedBuffer<uint32_t>& oBuffer, DecompressionDictionary const* iDictionary) {
   int32_t bufferSize = buffer.size();
   //lower 2 bits are the number of bytes used in the last word of the compressed sized
   int32_t uncompressedBufferSize = buffer[0]/4;
   int32_t bytesInLastWord = buffer[0] % 4;
   int32_t compressedBufferSizeInBytes = (bufferSize-1)*4 + (bytesInLastWord == 0? 0 : (-4+bytesInLastWord));
   //std::cout <<"compressed "<<compressedBufferSizeInBytes <<" uncompressed "<<uncompressedBufferSize*4<<" extra bytes "<<bytesInLastWord<<std::endl;
-  std::vector<uint32_t> uBuffer(size_t(uncompressedBufferSize), 0);
-  if(Compression::kLZ4 == compression) {
-    LZ4_decompress_safe(reinterpret_cast<char const*>(&(*(buffer.begin()+1))), reinterpret_cast<char*>(uBuffer.data()),
-                        compressedBufferSizeInBytes,
-                        uncompressedBufferSize*4);
-  } else if(Compression::kZSTD == compression) {
-    ZSTD_decompress(uBuffer.data(), uncompressedBufferSize*4, &(*(buffer.begin()+1)), compressedBufferSizeInBytes);
-  } else if(Compression::kNone == compression) {
-    assert(buffer.size() == uBuffer.size()+2);
-    std::copy(buffer.begin()+1, buffer.begin()+buffer.size(), uBuffer.begin());
+  if(Compression::kNone == compression) {
+    //the data products are used in place
+    assert(bytesInLastWord == 0);
+    assert(bufferSize >= uncompressedBufferSize+1);
+    return Span<uint32_t const>(buffer.data()+1, uncompressedBufferSize);
+  }
+  //every word is written by the decompressor
+  oBuffer.resize(uncompressedBufferSize);
+  if(isLZ4(compression)) {
+    lz4Decompress(reinterpret_cast<char*>(oBuffer.data()), uncompressedBufferSize*4,
+                  reinterpret_cast<char const*>(&(*(buffer.begin()+1))), compressedBufferSizeInBytes);
+  } else if(isZSTD(compression)) {
+    zstdDecompress(oBuffer.data(), uncompressedBufferSize*4, &(*(buffer.begin()+1)), compressedBufferSizeInBytes, iDictionary);
+  }
+  return oBuffer.span();
+}
+
+void pds::findCompressedDataProducts(std::vector<uint32_t> const& buffer, std::vector<CompressedProduct>& oProducts) {
+  //number of data products, then a table of (product index, uncompressed bytes, compressed bytes)
+  // followed by the compressed data products each padded to a word
+  std::fill(oProducts.begin(), oProducts.end(), CompressedProduct());
+  auto itTable = buffer.begin();
+  assert(itTable != buffer.end());
+  auto const nProducts = *(itTable++);
+  auto it = itTable+3*nProducts;
+  assert(it <= buffer.end());
+  for(uint32_t i=0; i< nProducts; ++i) {
+    auto productIndex = *(itTable++);
+    auto uncompressedBytes = *(itTable++);
+    auto compressedBytes = *(itTable++);
+    //an empty data product can be at the end of the buffer so avoid dereferencing the iterator
+    oProducts[productIndex].compressed_ = Span<char const>(reinterpret_cast<char const*>(buffer.data() + (it - buffer.begin())), compressedBytes);
+    oProducts[productIndex].uncompressedBytes_ = uncompressedBytes;
+    it = it+bytesToWords(compressedBytes);
+  }
+  assert(it==buffer.end());
+}
+
+void pds::uncompressProduct(pds::Compression compression, CompressedProduct const& iProduct, UninitializedBuffer<uint32_t>& oBuffer, DecompressionDictionary const* iDictionary, unsigned int iShuffleSize) {
+  oBuffer.resize(bytesToWords(iProduct.uncompressedBytes_));
+  //the padding must be 0 as it is passed to the deserializer, the rest is overwritten
+  if(oBuffer.size() != 0) {
+    oBuffer.data()[oBuffer.size()-1] = 0;
+  }
+  auto const& compressed = iProduct.compressed_;
+  if(iShuffleSize > 1) {
+    //only needed until the bytes are unshuffled so each thread reuses the same memory
+    static thread_local UninitializedBuffer<char> s_shuffled;
+    s_shuffled.resize(iProduct.uncompressedBytes_);
+    uncompressInto(compression, compressed.data(), compressed.size(), s_shuffled.data(), iProduct.uncompressedBytes_, iDictionary);
+    shuffle::copyUnshuffled(oBuffer.data(), s_shuffled.data(), iProduct.uncompressedBytes_, iShuffleSize);
+    return;
+  }
+  uncompressInto(compression, compressed.data(), compressed.size(), reinterpret_cast<char*>(oBuffer.data()), iProduct.uncompressedBytes_, iDictionary);
+}
+
+Span<char const> pds::uncompressedProduct(pds::Compression compression, CompressedProduct const& iProduct, UninitializedBuffer<uint32_t>& oBuffer, DecompressionDictionary const* iDictionary, unsigned int iShuffleSize) {
+  if(Compression::kNone == compression and iShuffleSize <= 1) {
+    //the padding in the event buffer is 0 just as it is in oBuffer
+    return Span<char const>(iProduct.compressed_.data(), bytesToWords(iProduct.uncompressedBytes_)*4);
   }
-  return uBuffer;
+  uncompressProduct(compression, iProduct, oBuffer, iDictionary, iShuffleSize);
+  return Span<char const>(reinterpret_cast<char const*>(oBuffer.data()), oBuffer.size()*4);
 }
 
-void pds::deserializeDataProducts(buffer_iterator it, buffer_iterator itEnd, std::vector<DataProductRetriever>& dataProducts, DeserializeStrategy const& deserializers) {
+void pds::uncompressAndDeserializeDataProducts(pds::Compression compression, std::vector<uint32_t> const& buffer, std::vector<DataProductRetriever>& dataProducts, DeserializeStrategy const& deserializers, DecompressionDictionary const* iDictionary, std::vector<uint32_t> const& iShuffleSizes) {
+  std::vector<CompressedProduct> products(dataProducts.size());
+  findCompressedDataProducts(buffer, products);
+  UninitializedBuffer<uint32_t> uBuffer;
+  for(size_t index = 0; index < products.size(); ++index) {
+    if(products[index].compressed_.data() == nullptr) {
+      continue;
+    }
+    auto product = uncompressedProduct(compression, products[index], uBuffer, iDictionary, iShuffleSizes.empty() ? 0 : iShuffleSizes[index]);
+    auto readSize = deserializers[index].deserialize(product.data(), product.size(), *dataProducts[index].address());
+    dataProducts[index].setSize(readSize);
+  }
+}
+
+void pds::deserializeDataProducts(Span<uint32_t const> iBuffer, std::vector<DataProductRetriever>& dataProducts, DeserializeStrategy const& deserializers) {
+  auto it = iBuffer.begin();
+  auto itEnd = iBuffer.end();
 
   while(it < itEnd) {
     auto productIndex = *(it++);
@@ -221,7 +397,7 @@ void pds::deserializeDataProducts(buffer_iterator it, buffer_iterator itEnd, std
 
     //std::cout <<dataProducts[productIndex].name()<<" "<<dataProducts[productIndex].classType()->GetName()<<std::endl;
     //std::cout <<"storedSize "<<storedSize<<" "<<storedSize*4<<std::endl;
-    auto readSize = deserializers[productIndex].deserialize(reinterpret_cast<char const*>(&*it), storedSize*4, *dataProducts[productIndex].address());
+    auto readSize = deserializers[productIndex].deserialize(reinterpret_cast<char const*>(it), storedSize*4, *dataProducts[productIndex].address());
     dataProducts[productIndex].setSize(readSize);
     //std::cout <<" readSize "<<readSize<<"\n";
 
@@ -231,28 +407,65 @@ void pds::deserializeDataProducts(buffer_iterator it, buffer_iterator itEnd, std
   assert(it==itEnd);
 }
 
+void pds::findDataProducts(Span<uint32_t const> iBuffer, std::vector<Span<char const>>& oProducts) {
+  auto it = iBuffer.begin();
+  auto itEnd = iBuffer.end();
+  std::fill(oProducts.begin(), oProducts.end(), Span<char const>());
+  while(it < itEnd) {
+    auto productIndex = *(it++);
+    auto storedSize = *(it++);
+    oProducts[productIndex] = Span<char const>(reinterpret_cast<char const*>(it), storedSize*4);
+    it = it+storedSize;
+  }
+  assert(it==itEnd);
+}
+
 
-std::vector<char> pds::uncompressBuffer(pds::Compression compression, std::vector<char> const& buffer, uint32_t uncompressedBufferSize) {
-  std::vector<char> uBuffer(size_t(uncompressedBufferSize), 0);
-  if(Compression::kLZ4 == compression) {
-    auto size = LZ4_decompress_safe(&(*(buffer.begin())), uBuffer.data(),
-                                    buffer.size(),
-                                    uncompressedBufferSize);
-    if(size != uncompressedBufferSize) {
-      if(size > 0) {
-        std::cout <<" LZ4_decompress_safe decompressed less bytes ("<<size<<") than expected ("<<uncompressedBufferSize<<")"<<std::endl;
-      } else {
-        throw std::runtime_error("LZ4_decompress_safe failed to decompress");
-      }
-    }
-    assert(size == uncompressedBufferSize);
-  } else if(Compression::kZSTD == compression) {
-    ZSTD_decompress(uBuffer.data(), uncompressedBufferSize, &(*(buffer.begin())), buffer.size());
-  } else if(Compression::kNone == compression) {
-    assert(buffer.size() == uBuffer.size());
-    std::copy(buffer.begin(), buffer.begin()+buffer.size(), uBuffer.begin());
+Span<char const> pds::uncompressBuffer(pds::Compression compression, std::vector<char> const& buffer, uint32_t uncompressedBufferSize, UninitializedBuffer<char>& oBuffer, DecompressionDictionary const* iDictionary) {
+  if(Compression::kNone == compression) {
+    assert(buffer.size() == uncompressedBufferSize);
+    return Span<char const>(buffer.data(), buffer.size());
   }
-  return uBuffer;
+  //every byte is written by the decompressor
+  oBuffer.resize(uncompressedBufferSize);
+  char* uBuffer = oBuffer.data();
+  if(isLZ4(compression)) {
+    lz4Decompress(uBuffer, uncompressedBufferSize, &(*(buffer.begin())), buffer.size());
+  } else if(isZSTD(compression)) {
+    zstdDecompress(uBuffer, uncompressedBufferSize, &(*(buffer.begin())), buffer.size(), iDictionary);
+  }
+  return oBuffer.span();
+}
+
+Span<char const> pds::uncompressBufferInBlocks(pds::Compression compression, std::vector<char> const& buffer, uint32_t uncompressedBufferSize, UninitializedBuffer<char>& oBuffer) {
+  //number of blocks, block size then the compressed size of each block
+  assert(buffer.size() >= 2*4);
+  std::array<uint32_t, 2> header;
+  std::memcpy(header.data(), buffer.data(), 2*4);
+  auto const nBlocks = header[0];
+  std::size_t const blockSize = header[1];
+  std::vector<uint32_t> compressedSizes(nBlocks);
+  assert(buffer.size() >= (2+nBlocks)*4);
+  std::memcpy(compressedSizes.data(), buffer.data()+2*4, nBlocks*4);
+
+  std::vector<std::size_t> compressedOffsets;
+  compressedOffsets.reserve(nBlocks);
+  std::size_t offset = (2+nBlocks)*4;
+  for(auto s: compressedSizes) {
+    compressedOffsets.push_back(offset);
+    offset += s;
+  }
+  assert(offset == buffer.size());
+  assert(nBlocks*blockSize >= uncompressedBufferSize);
+
+  //every byte is written by one of the blocks
+  oBuffer.resize(uncompressedBufferSize);
+  tbb::parallel_for(uint32_t(0), nBlocks, [&](uint32_t iBlock) {
+      auto const begin = iBlock*blockSize;
+      auto const size = std::min(blockSize, oBuffer.size()-begin);
+      uncompressInto(compression, buffer.data()+compressedOffsets[iBlock], compressedSizes[iBlock], oBuffer.data()+begin, size, nullptr);
+    });
+  return oBuffer.span();
 }
 
 void pds::deserializeDataProducts(const char* it, const char* itEnd, 
@@ -282,9 +495,71 @@ void pds::deserializeDataProducts(const char* it, const char* itEnd,
   assert(it==itEnd);
 }
 
+void pds::findDataProducts(const char* it, const char* itEnd, 
+                           table_iterator itTable, table_iterator itTableEnd,
+                           std::vector<Span<char const>>& oProducts) {
+  std::fill(oProducts.begin(), oProducts.end(), Span<char const>());
+  auto itBegin = it;
+  uint32_t productIndex = 0;
+  while(it < itEnd and itTable != itTableEnd) {
+    auto start = *itTable;
+    auto next = *(++itTable);
+    auto storedSize = next - start;
+    if( storedSize != 0) {
+      oProducts[productIndex] = Span<char const>(it, storedSize);
+      it = itBegin + next;
+    }
+    ++productIndex;
+  }
+  assert(it==itEnd);
+}
+
+
+namespace {
+  void deserializeProducts(std::size_t iBegin, std::size_t iEnd, std::vector<Span<char const>> const& iProducts, 
+                           std::vector<DataProductRetriever>& dataProducts, DeserializeStrategy const& deserializers,
+                           std::vector<std::chrono::microseconds>& ioTimes) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for(auto index = iBegin; index < iEnd; ++index) {
+      auto product = iProducts[index];
+      if(product.data() != nullptr) {
+        dataProducts[index].setSize( deserializers[index].deserialize(product.data(), product.size(), *dataProducts[index].address()) );
+      }
+    }
+    ioTimes[iBegin] += 
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+  }
+}
+
+void pds::deserializeDataProductsAsync(std::vector<Span<char const>> const& iProducts, std::vector<DataProductRetriever>& dataProducts,
+                                       DeserializeStrategy const& deserializers, std::vector<std::chrono::microseconds>& ioTimes,
+                                       std::size_t iGroupBytes, TaskHolder iTask) {
+  auto group = iTask.group();
+  std::size_t begin = 0;
+  while(begin < iProducts.size()) {
+    //a data product at least iGroupBytes in size always gets its own task
+    std::size_t end = begin;
+    std::size_t bytes = 0;
+    do {
+      bytes += iProducts[end].size();
+      ++end;
+    } while(end < iProducts.size() and bytes < iGroupBytes and iProducts[end].size() < iGroupBytes);
+
+    if(end == iProducts.size()) {
+      //no need to start a new task for the last group
+      deserializeProducts(begin, end, iProducts, dataProducts, deserializers, ioTimes);
+    } else {
+      group->run([begin, end, &iProducts, &dataProducts, &deserializers, &ioTimes, task = iTask]() {
+          deserializeProducts(begin, end, iProducts, dataProducts, deserializers, ioTimes);
+        });
+    }
+    begin = end;
+  }
+}
+
 
-bool pds::skipToNextEvent(std::istream& iFile) {
-  iFile.seekg(kEventHeaderSizeInWords*4, std::ios_base::cur);
+bool pds::skipToNextEvent(std::istream& iFile, std::size_t iHeaderSizeInWords) {
+  iFile.seekg(iHeaderSizeInWords*4, std::ios_base::cur);
   if( iFile.rdstate() & std::ios_base::eofbit) {
     return false;
   }
@@ -1,17 +1,37 @@
 #if !defined(pds_reading_h)
 #define pds_reading_h
 
+#include <chrono>
 #include <istream>
+#include <memory>
+#include <optional>
 #include <vector>
 
 #include "DeserializeStrategy.h"
 #include "EventIdentifier.h"
 #include "DataProductRetriever.h"
+#include "Span.h"
+#include "UninitializedBuffer.h"
 
 #include "pds_common.h"
 
+struct ZSTD_DDict_s;
+
 namespace cce::tf::pds {
 
+  //The ZSTD dictionary the events were compressed with. It is read only so all lanes can share it.
+  class DecompressionDictionary {
+  public:
+    DecompressionDictionary() = default;
+    //empty bytes means the events were compressed without a dictionary
+    explicit DecompressionDictionary(std::vector<char> const& iBytes);
+
+    bool empty() const { return not dDict_; }
+    ZSTD_DDict_s const* zstdDictionary() const { return dDict_.get(); }
+  private:
+    std::shared_ptr<ZSTD_DDict_s> dDict_;
+  };
+
   uint32_t readword(std::istream& iFile);
 
   uint32_t readwordNoCheck(std::istream& iFile);
@@ -20,28 +40,75 @@ namespace cce::tf::pds {
 
 
   struct ProductInfo{
-  ProductInfo(std::string iName, uint32_t iIndex, std::string iClassName) : name_(std::move(iName)), index_{iIndex}, className_{iClassName} {}
+  ProductInfo(std::string iName, uint32_t iIndex, std::string iClassName, uint32_t iShuffleSize = 0) : name_(std::move(iName)), index_{iIndex}, className_{iClassName}, shuffleSize_{iShuffleSize} {}
     
     uint32_t classIndex() const {return index_;}
     std::string const& name() const { return name_;}
     std::string const& className() const { return className_;}
+    //for Layout::kProduct, the value size used to shuffle the bytes before compression, 0 if they were not shuffled
+    uint32_t shuffleSize() const { return shuffleSize_;}
     std::string className_;
     std::string name_;
     uint32_t index_;
+    uint32_t shuffleSize_;
   };
   
-  std::vector<ProductInfo> readFileHeader(std::istream&, Compression&, Serialization&);
-
   constexpr size_t kEventHeaderSizeInWords = 5;
-  bool skipToNextEvent(std::istream&); //returns true if an event was skipped
-  bool readCompressedEventBuffer(std::istream&, EventIdentifier&, std::vector<uint32_t>& buffer);
-  std::vector<uint32_t> uncompressEventBuffer(pds::Compression, std::vector<uint32_t> const& buffer);
-  void deserializeDataProducts(std::vector<uint32_t>::const_iterator, std::vector<uint32_t>::const_iterator, std::vector<DataProductRetriever>&, DeserializeStrategy const&);
+  //files written with an adaptive compression level end each event header with the level used
+  constexpr size_t kEventHeaderWithLevelSizeInWords = kEventHeaderSizeInWords+1;
+
+  //oDictionary is filled with the ZSTD dictionary stored in the header, or left empty if there is none.
+  // oEventHeaderSizeInWords is set to the size of the event headers in the file and must be passed
+  // to skipToNextEvent and readCompressedEventBuffer.
+  std::vector<ProductInfo> readFileHeader(std::istream&, Compression&, Serialization&, Layout&, std::vector<char>& oDictionary, std::size_t& oEventHeaderSizeInWords);
 
-  std::vector<char> uncompressBuffer(pds::Compression, std::vector<char> const& buffer, uint32_t uncompressedSize);
+  bool skipToNextEvent(std::istream&, std::size_t iHeaderSizeInWords = kEventHeaderSizeInWords); //returns true if an event was skipped
+  //if oCompressionLevel is given, it is set to the level recorded in the event header or reset if the file has none
+  bool readCompressedEventBuffer(std::istream&, EventIdentifier&, std::vector<uint32_t>& buffer, std::size_t iHeaderSizeInWords = kEventHeaderSizeInWords, std::optional<int>* oCompressionLevel = nullptr);
+  //Returns the uncompressed event which is written into oBuffer, meant to be reused for each event. For
+  // pds::Compression::kNone the event is used in place so the returned Span refers to buffer instead.
+  Span<uint32_t const> uncompressEventBuffer(pds::Compression, std::vector<uint32_t> const& buffer, UninitializedBuffer<uint32_t>& oBuffer, DecompressionDictionary const* iDictionary = nullptr);
+
+  //A separately compressed data product within an event buffer written using Layout::kProduct
+  struct CompressedProduct {
+    Span<char const> compressed_;
+    uint32_t uncompressedBytes_ = 0;
+  };
+  //A CompressedProduct with a nullptr compressed_.data() means the data product is not stored in the event
+  void findCompressedDataProducts(std::vector<uint32_t> const& buffer, std::vector<CompressedProduct>&);
+  //oBuffer is resized to hold the data product padded to a whole number of words.
+  // iShuffleSize must be the value given to pds::compressBuffer.
+  void uncompressProduct(pds::Compression, CompressedProduct const&, UninitializedBuffer<uint32_t>& oBuffer, DecompressionDictionary const* iDictionary = nullptr, unsigned int iShuffleSize = 0);
+  //Same as uncompressProduct but returns the data product, including its padding. For pds::Compression::kNone
+  // without shuffling that is the bytes in the event buffer and oBuffer is not used.
+  Span<char const> uncompressedProduct(pds::Compression, CompressedProduct const&, UninitializedBuffer<uint32_t>& oBuffer, DecompressionDictionary const* iDictionary = nullptr, unsigned int iShuffleSize = 0);
+  //iShuffleSizes holds ProductInfo::shuffleSize() for each data product, an empty vector means none were shuffled
+  void uncompressAndDeserializeDataProducts(pds::Compression, std::vector<uint32_t> const& buffer, std::vector<DataProductRetriever>&, DeserializeStrategy const&, DecompressionDictionary const* iDictionary = nullptr, std::vector<uint32_t> const& iShuffleSizes = {});
+  void deserializeDataProducts(Span<uint32_t const> iUncompressedEvent, std::vector<DataProductRetriever>&, DeserializeStrategy const&);
+
+  //Records where each data product is in an uncompressed event buffer, using the same
+  // layout as deserializeDataProducts, so the data products can be deserialized later
+  void findDataProducts(Span<uint32_t const> iUncompressedEvent, std::vector<Span<char const>>&);
+
+  //Returns the uncompressed bytes which are written into oBuffer, meant to be reused for each buffer. For
+  // pds::Compression::kNone the returned Span refers to buffer instead.
+  Span<char const> uncompressBuffer(pds::Compression, std::vector<char> const& buffer, uint32_t uncompressedSize, UninitializedBuffer<char>& oBuffer, DecompressionDictionary const* iDictionary = nullptr);
+  //reads a buffer written by pds::compressBufferInBlocks, the blocks are uncompressed concurrently into oBuffer
+  Span<char const> uncompressBufferInBlocks(pds::Compression, std::vector<char> const& buffer, uint32_t uncompressedSize, UninitializedBuffer<char>& oBuffer);
   void deserializeDataProducts(const char* iBufferBegin, const char* iBufferEnd, 
                                std::vector<uint32_t>::const_iterator itTableBegin, std::vector<uint32_t>::const_iterator itTableEnd, 
                                std::vector<DataProductRetriever>&, DeserializeStrategy const&);
+  void findDataProducts(const char* iBufferBegin, const char* iBufferEnd, 
+                        std::vector<uint32_t>::const_iterator itTableBegin, std::vector<uint32_t>::const_iterator itTableEnd, 
+                        std::vector<Span<char const>>&);
+
+  //Deserializes the data products found by findDataProducts using separate tasks. Data products smaller
+  // than iGroupBytes are grouped so each task deserializes at least that many bytes. The time taken
+  // by each task is added to ioTimes at the index of the task's first data product. iTask is released
+  // once all data products are deserialized and the buffer holding them must stay valid until then.
+  void deserializeDataProductsAsync(std::vector<Span<char const>> const& iProducts, std::vector<DataProductRetriever>&,
+                                    DeserializeStrategy const&, std::vector<std::chrono::microseconds>& ioTimes,
+                                    std::size_t iGroupBytes, TaskHolder iTask);
 
 }
 
@@ -1,25 +1,145 @@
 #include "pds_writer.h"
+#include "shuffle_kernels.h"
+#include "UninitializedBuffer.h"
 #include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "tbb/parallel_for.h"
 
 #include "lz4.h"
+#include "lz4hc.h"
 #include "zstd.h"
+#include "zdict.h"
+
+using cce::tf::Span;
+using cce::tf::UninitializedBuffer;
+using cce::tf::pds::ZSTDParameters;
+using cce::tf::pds::CompressionDictionary;
 
 namespace {
   static inline size_t bytesToWords(size_t nBytes) {
     return nBytes/4 + ( (nBytes % 4) == 0 ? 0 : 1);
   }
+
+  //Creating a ZSTD_CCtx for each call is costly for small events at high compression levels.
+  // Each thread keeps one and only changes its parameters when a different setting is asked for.
+  class ZSTDCompressor {
+  public:
+    ZSTDCompressor(): context_{ZSTD_createCCtx()} {}
+    ~ZSTDCompressor() { ZSTD_freeCCtx(context_); }
+    ZSTDCompressor(ZSTDCompressor const&) = delete;
+    ZSTDCompressor& operator=(ZSTDCompressor const&) = delete;
+
+    size_t compress(void* oTo, size_t iToSize, void const* iFrom, size_t iFromSize, int iLevel, ZSTDParameters const& iParameters, ZSTD_CDict const* iDictionary) {
+      if(not configured_ or iLevel != level_ or iParameters != parameters_) {
+        configure(iLevel, iParameters);
+      }
+      if(iDictionary != dictionary_) {
+        //a nullptr returns to compressing without a dictionary
+        check(ZSTD_CCtx_refCDict(context_, iDictionary));
+        dictionary_ = iDictionary;
+      }
+      return ZSTD_compress2(context_, oTo, iToSize, iFrom, iFromSize);
+    }
+  private:
+    void configure(int iLevel, ZSTDParameters const& iParameters) {
+      ZSTD_CCtx_reset(context_, ZSTD_reset_session_and_parameters);
+      check(ZSTD_CCtx_setParameter(context_, ZSTD_c_compressionLevel, iLevel));
+      if(iParameters.windowLog != 0) {
+        check(ZSTD_CCtx_setParameter(context_, ZSTD_c_windowLog, iParameters.windowLog));
+      }
+      if(iParameters.strategy != 0) {
+        check(ZSTD_CCtx_setParameter(context_, ZSTD_c_strategy, iParameters.strategy));
+      }
+      if(iParameters.longDistanceMatching) {
+        check(ZSTD_CCtx_setParameter(context_, ZSTD_c_enableLongDistanceMatching, 1));
+      }
+      level_ = iLevel;
+      parameters_ = iParameters;
+      //the reset also removed any dictionary
+      dictionary_ = nullptr;
+      configured_ = true;
+    }
+    static void check(size_t iReturn) {
+      if(ZSTD_isError(iReturn)) {
+        std::cout <<"ERROR setting ZSTD parameter "<<ZSTD_getErrorName(iReturn)<<std::endl;
+      }
+    }
+
+    ZSTD_CCtx* context_;
+    int level_ = 0;
+    ZSTDParameters parameters_;
+    ZSTD_CDict const* dictionary_ = nullptr;
+    bool configured_ = false;
+  };
+
+  ZSTD_CDict const* zstdDictionary(CompressionDictionary const* iDictionary) {
+    return iDictionary ? iDictionary->zstdDictionary() : nullptr;
+  }
+
+  ZSTDCompressor& zstdCompressor() {
+    static thread_local ZSTDCompressor s_compressor;
+    return s_compressor;
+  }
+
+  //reuses the memory for the LZ4 state on each thread rather than setting up a new one for each call
+  int lz4Compress(char const* iFrom, char* oTo, int iFromSize, int iToSize) {
+    static thread_local LZ4_stream_t s_state;
+    return LZ4_compress_fast_extState(&s_state, iFrom, oTo, iFromSize, iToSize, 1);
+  }
+
+  //the HC state is too large to be put in thread local storage directly
+  int lz4hcCompress(char const* iFrom, char* oTo, int iFromSize, int iToSize, int iLevel) {
+    static thread_local std::vector<char> s_state(LZ4_sizeofStateHC());
+    return LZ4_compress_HC_extStateHC(s_state.data(), iFrom, oTo, iFromSize, iToSize, iLevel);
+  }
+
+  //An empty frame written in place of a failed compression would make the file unreadable
+  void checkZSTDResult(size_t iResult) {
+    if(ZSTD_isError(iResult)) {
+      throw std::runtime_error(std::string("ZSTD failed to compress: ")+ZSTD_getErrorName(iResult));
+    }
+  }
+
+  //LZ4 returns 0 on failure, even an empty buffer compresses to at least 1 byte
+  void checkLZ4Result(int iResult) {
+    if(iResult <= 0) {
+      throw std::runtime_error("LZ4 failed to compress");
+    }
+  }
+
+  //The compressors need room for the worst case but usually write much less. Each thread compresses
+  // into the same uninitialized memory and only the compressed bytes are copied to the returned buffer.
+  char* compressScratch(std::size_t iBound) {
+    static thread_local UninitializedBuffer<char> s_scratch;
+    s_scratch.resize(iBound);
+    return s_scratch.data();
+  }
+
+  //kZSTDLong always uses long distance matching, the other settings are left as asked for
+  ZSTDParameters longZSTDParameters(ZSTDParameters iParameters) {
+    iParameters.longDistanceMatching = true;
+    return iParameters;
+  }
   
-  std::pair<std::vector<uint32_t>,int> lz4CompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<uint32_t> const& iBuffer) {
+  //iLevel < 0 uses the fast LZ4 compressor, otherwise it is the LZ4HC compression level
+  std::pair<std::vector<uint32_t>,int> lz4CompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Span<uint32_t const> iBuffer, int iLevel) {
     int cSize = 0;
     auto const bound = LZ4_compressBound(iBuffer.size()*4);
-    std::vector<uint32_t> cBuffer(bytesToWords(size_t(bound))+iLeadPadding+iTrailingPadding, 0);
-    cSize = LZ4_compress_default(reinterpret_cast<char const*>(&(*iBuffer.begin())), reinterpret_cast<char*>(&(*(cBuffer.begin()+iLeadPadding))), iBuffer.size()*4, bound);
-    cBuffer.resize(bytesToWords(cSize)+iLeadPadding+iTrailingPadding);
-    return {cBuffer,cSize};
+    auto from = reinterpret_cast<char const*>(iBuffer.data());
+    auto to = compressScratch(bound);
+    cSize = iLevel < 0 ? lz4Compress(from, to, iBuffer.size()*4, bound) : lz4hcCompress(from, to, iBuffer.size()*4, bound, iLevel);
+    checkLZ4Result(cSize);
+    std::vector<uint32_t> cBuffer(bytesToWords(cSize)+iLeadPadding+iTrailingPadding, 0);
+    std::memcpy(cBuffer.data()+iLeadPadding, to, cSize);
+    return {std::move(cBuffer),cSize};
   }
   
-  std::pair<std::vector<uint32_t>, int> noCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<uint32_t> const& iBuffer) {
+  std::pair<std::vector<uint32_t>, int> noCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Span<uint32_t const> iBuffer) {
     int cSize = 0;
     auto const bound = iBuffer.size()*4;
     std::vector<uint32_t> cBuffer(iBuffer.size()+iLeadPadding+iTrailingPadding, uint32_t(0));
@@ -28,60 +148,87 @@ namespace {
     return {cBuffer, cSize};
   }
   
-  std::pair<std::vector<uint32_t>, int> zstdCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<uint32_t> const& iBuffer, int compressionLevel) {
+  std::pair<std::vector<uint32_t>, int> zstdCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Span<uint32_t const> iBuffer, int compressionLevel, ZSTDParameters const& iParameters, CompressionDictionary const* iDictionary) {
     int cSize = 0;
     auto const bound = ZSTD_compressBound(iBuffer.size()*4);
-    std::vector<uint32_t> cBuffer(bytesToWords(size_t(bound))+iLeadPadding+iTrailingPadding, 0);
-    cSize = ZSTD_compress(&(*(cBuffer.begin()+iLeadPadding)), bound, &(*iBuffer.begin()),  iBuffer.size()*4, compressionLevel);
-    if(ZSTD_isError(cSize)) {
-      std::cout <<"ERROR in comparession "<<ZSTD_getErrorName(cSize)<<std::endl;
-    }
-    cBuffer.resize(bytesToWords(cSize)+iLeadPadding+iTrailingPadding);
-    return {cBuffer,cSize};
+    auto to = compressScratch(bound);
+    auto const result = zstdCompressor().compress(to, bound, iBuffer.data(),  iBuffer.size()*4, compressionLevel, iParameters, zstdDictionary(iDictionary));
+    checkZSTDResult(result);
+    cSize = result;
+    std::vector<uint32_t> cBuffer(bytesToWords(cSize)+iLeadPadding+iTrailingPadding, 0);
+    std::memcpy(cBuffer.data()+iLeadPadding, to, cSize);
+    return {std::move(cBuffer),cSize};
   }
 
 
-  std::vector<char> lz4CompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<char> const& iBuffer) {
+  std::vector<char> lz4CompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Span<char const> iBuffer, int iLevel) {
     auto const bound = LZ4_compressBound(iBuffer.size());
-    std::vector<char> cBuffer(bound+iLeadPadding+iTrailingPadding, 0);
-    auto cSize = LZ4_compress_default(&(*iBuffer.begin()), &(*(cBuffer.begin()+iLeadPadding)), iBuffer.size(), bound);
-    cBuffer.resize(cSize+iLeadPadding+iTrailingPadding);
+    auto to = compressScratch(bound);
+    auto cSize = iLevel < 0 ? lz4Compress(iBuffer.data(), to, iBuffer.size(), bound) : lz4hcCompress(iBuffer.data(), to, iBuffer.size(), bound, iLevel);
+    checkLZ4Result(cSize);
+    std::vector<char> cBuffer(cSize+iLeadPadding+iTrailingPadding, 0);
+    std::memcpy(cBuffer.data()+iLeadPadding, to, cSize);
     return cBuffer;
   }
   
-  std::vector<char> noCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<char> const& iBuffer) {
+  std::vector<char> noCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Span<char const> iBuffer) {
     std::vector<char> cBuffer(iBuffer.size()+iLeadPadding+iTrailingPadding, uint32_t(0));
     std::copy(iBuffer.begin(), iBuffer.end(), cBuffer.begin()+iLeadPadding);
     return cBuffer;
   }
   
-  std::vector<char> zstdCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<char> const& iBuffer, int compressionLevel) {
-    int cSize = 0;
+  std::vector<char> zstdCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Span<char const> iBuffer, int compressionLevel, ZSTDParameters const& iParameters, CompressionDictionary const* iDictionary) {
     auto const bound = ZSTD_compressBound(iBuffer.size());
-    std::vector<char> cBuffer(bound+iLeadPadding+iTrailingPadding, 0);
-    cSize = ZSTD_compress(&(*(cBuffer.begin()+iLeadPadding)), bound, &(*iBuffer.begin()),  iBuffer.size(), compressionLevel);
-    if(ZSTD_isError(cSize)) {
-      std::cout <<"ERROR in comparession "<<ZSTD_getErrorName(cSize)<<std::endl;
-    }
-    cBuffer.resize(cSize+iLeadPadding+iTrailingPadding);
+    auto to = compressScratch(bound);
+    auto const cSize = zstdCompressor().compress(to, bound, iBuffer.data(),  iBuffer.size(), compressionLevel, iParameters, zstdDictionary(iDictionary));
+    checkZSTDResult(cSize);
+    std::vector<char> cBuffer(cSize+iLeadPadding+iTrailingPadding, 0);
+    std::memcpy(cBuffer.data()+iLeadPadding, to, cSize);
     return cBuffer;
   }
 
 }
 
 namespace cce::tf::pds {
+
+  CompressionDictionary CompressionDictionary::train(std::vector<Span<char const>> const& iSamples, std::size_t iMaxSize, int iCompressionLevel) {
+    //ZDICT wants all the samples in one contiguous buffer
+    std::vector<char> samples;
+    std::vector<size_t> sampleSizes;
+    sampleSizes.reserve(iSamples.size());
+    for(auto const& s: iSamples) {
+      samples.insert(samples.end(), s.begin(), s.end());
+      sampleSizes.push_back(s.size());
+    }
+    CompressionDictionary dictionary;
+    dictionary.bytes_.resize(iMaxSize);
+    auto size = ZDICT_trainFromBuffer(dictionary.bytes_.data(), dictionary.bytes_.size(), samples.data(), sampleSizes.data(), sampleSizes.size());
+    if(ZDICT_isError(size)) {
+      std::cout <<"unable to train ZSTD dictionary, compressing without one: "<<ZDICT_getErrorName(size)<<std::endl;
+      return CompressionDictionary();
+    }
+    dictionary.bytes_.resize(size);
+    dictionary.cDict_ = std::shared_ptr<ZSTD_CDict>(ZSTD_createCDict(dictionary.bytes_.data(), size, iCompressionLevel), ZSTD_freeCDict);
+    return dictionary;
+  }
   
-  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<uint32_t> const& iBuffer) {
+  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Compression iAlgorithm, int iCompressionLevel, Span<uint32_t const> iBuffer, ZSTDParameters const& iZSTDParameters, CompressionDictionary const* iDictionary) {
 
     switch(iAlgorithm) {
     case Compression::kLZ4 : {
-      return lz4CompressBuffer(iLeadPadding,iTrailingPadding, iBuffer);
+      return lz4CompressBuffer(iLeadPadding,iTrailingPadding, iBuffer, -1);
+    }    
+    case Compression::kLZ4HC : {
+      return lz4CompressBuffer(iLeadPadding,iTrailingPadding, iBuffer, iCompressionLevel);
     }    
     case Compression::kNone : {
       return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer);
     } 
     case Compression::kZSTD : {
-      return zstdCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iCompressionLevel);
+      return zstdCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iCompressionLevel, iZSTDParameters, iDictionary);
+    }
+    case Compression::kZSTDLong : {
+      return zstdCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iCompressionLevel, longZSTDParameters(iZSTDParameters), iDictionary);
     }
     default:
       return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer);
@@ -89,17 +236,31 @@ namespace cce::tf::pds {
     }
   }
 
-  std::vector<char> compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<char> const& iBuffer) {
+  std::vector<char> compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Compression iAlgorithm, int iCompressionLevel, Span<char const> iBuffer, ZSTDParameters const& iZSTDParameters, CompressionDictionary const* iDictionary, unsigned int iShuffleSize) {
+
+    if(iShuffleSize > 1) {
+      //only needed until the buffer is compressed so each thread reuses the same memory
+      static thread_local UninitializedBuffer<char> s_shuffled;
+      s_shuffled.resize(iBuffer.size());
+      shuffle::copyShuffled(s_shuffled.data(), iBuffer.data(), iBuffer.size(), iShuffleSize);
+      iBuffer = s_shuffled.span();
+    }
 
     switch(iAlgorithm) {
     case Compression::kLZ4 : {
-      return lz4CompressBuffer(iLeadPadding,iTrailingPadding, iBuffer);
+      return lz4CompressBuffer(iLeadPadding,iTrailingPadding, iBuffer, -1);
+    }    
+    case Compression::kLZ4HC : {
+      return lz4CompressBuffer(iLeadPadding,iTrailingPadding, iBuffer, iCompressionLevel);
     }    
     case Compression::kNone : {
       return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer);
     } 
     case Compression::kZSTD : {
-      return zstdCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iCompressionLevel);
+      return zstdCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iCompressionLevel, iZSTDParameters, iDictionary);
+    }
+    case Compression::kZSTDLong : {
+      return zstdCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iCompressionLevel, longZSTDParameters(iZSTDParameters), iDictionary);
     }
     default:
       return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer);
@@ -107,4 +268,40 @@ namespace cce::tf::pds {
     }
   }
 
+  std::vector<char> compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<char>&& iBuffer, ZSTDParameters const& iZSTDParameters, CompressionDictionary const* iDictionary, unsigned int iShuffleSize) {
+    if(iAlgorithm == Compression::kNone and iLeadPadding == 0 and iTrailingPadding == 0 and iShuffleSize <= 1) {
+      return std::move(iBuffer);
+    }
+    return compressBuffer(iLeadPadding, iTrailingPadding, iAlgorithm, iCompressionLevel, Span<char const>(iBuffer.data(), iBuffer.size()), iZSTDParameters, iDictionary, iShuffleSize);
+  }
+
+  std::vector<char> compressBufferInBlocks(Compression iAlgorithm, int iCompressionLevel, Span<char const> iBuffer, uint32_t iBlockSize, ZSTDParameters const& iZSTDParameters) {
+    assert(iBlockSize != 0);
+    std::size_t const blockSize = iBlockSize;
+    std::size_t const nBlocks = (iBuffer.size() + blockSize - 1)/blockSize;
+    std::vector<std::vector<char>> blocks(nBlocks);
+    tbb::parallel_for(std::size_t(0), nBlocks, [&](std::size_t iBlock) {
+        auto const begin = iBlock*blockSize;
+        auto const size = std::min(blockSize, iBuffer.size()-begin);
+        blocks[iBlock] = compressBuffer(0, 0, iAlgorithm, iCompressionLevel, Span<char const>(iBuffer.data()+begin, size), iZSTDParameters);
+      });
+
+    std::vector<uint32_t> header;
+    header.reserve(2+nBlocks);
+    header.push_back(nBlocks);
+    header.push_back(iBlockSize);
+    std::size_t cSize = 0;
+    for(auto const& b: blocks) {
+      header.push_back(b.size());
+      cSize += b.size();
+    }
+    std::vector<char> cBuffer(header.size()*4+cSize);
+    std::memcpy(cBuffer.data(), header.data(), header.size()*4);
+    auto it = cBuffer.begin()+header.size()*4;
+    for(auto const& b: blocks) {
+      it = std::copy(b.begin(), b.end(), it);
+    }
+    return cBuffer;
+  }
+
 }
@@ -2,16 +2,50 @@
 #define pds_writer_h
 
 #include "pds_common.h"
+#include "Span.h"
 
+#include <memory>
 #include <utility>
 #include <vector>
 #include <cstdint>
 
+struct ZSTD_CDict_s;
+
 namespace cce::tf::pds {
 
-  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<uint32_t> const& iBuffer);
+  //A ZSTD dictionary used when compressing every event. Small events compressed independently
+  // compress poorly, a dictionary trained on the first events gives ZSTD the common content.
+  class CompressionDictionary {
+  public:
+    CompressionDictionary() = default;
+
+    //returns an empty dictionary if ZSTD can not train one from the samples
+    static CompressionDictionary train(std::vector<Span<char const>> const& iSamples, std::size_t iMaxSize, int iCompressionLevel);
+
+    bool empty() const { return bytes_.empty(); }
+    //what must be stored in the file so the events can be decompressed
+    std::vector<char> const& bytes() const { return bytes_; }
+    ZSTD_CDict_s const* zstdDictionary() const { return cDict_.get(); }
+
+  private:
+    std::vector<char> bytes_;
+    std::shared_ptr<ZSTD_CDict_s> cDict_;
+  };
+
+  //The compression contexts are kept per thread and reused for each call. iZSTDParameters and
+  // iDictionary are only used by ZSTD, a nullptr or empty iDictionary compresses without a dictionary.
+  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Compression iAlgorithm, int iCompressionLevel, Span<uint32_t const> iBuffer, ZSTDParameters const& iZSTDParameters = {}, CompressionDictionary const* iDictionary = nullptr);
+
+  //If iShuffleSize is greater than 1 the bytes are first regrouped by shuffle::copyShuffled using values of that
+  // many bytes. pds::uncompressProduct must then be given the same iShuffleSize.
+  std::vector<char> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Compression iAlgorithm, int iCompressionLevel, Span<char const> iBuffer, ZSTDParameters const& iZSTDParameters = {}, CompressionDictionary const* iDictionary = nullptr, unsigned int iShuffleSize = 0);
+  //Same as above but for Compression::kNone without padding or shuffling iBuffer is returned rather than copied
+  std::vector<char> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<char>&& iBuffer, ZSTDParameters const& iZSTDParameters = {}, CompressionDictionary const* iDictionary = nullptr, unsigned int iShuffleSize = 0);
 
-  std::vector<char> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<char> const& iBuffer);
+  //Splits iBuffer into blocks of iBlockSize bytes which are compressed concurrently, each as an independent frame.
+  // The returned buffer starts with the number of blocks, iBlockSize and the compressed size of each block,
+  // all as uint32_t, followed by the compressed blocks. Use pds::uncompressBufferInBlocks to read it back.
+  std::vector<char> compressBufferInBlocks(Compression iAlgorithm, int iCompressionLevel, Span<char const> iBuffer, uint32_t iBlockSize, ZSTDParameters const& iZSTDParameters = {});
 
 }
 
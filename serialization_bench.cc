@@ -0,0 +1,270 @@
+#include "Serializer.h"
+#include "Deserializer.h"
+#include "UnrolledSerializer.h"
+#include "UnrolledDeserializer.h"
+#include "GeneratedSerializer.h"
+#include "GeneratedDeserializer.h"
+#include "NativeSerializer.h"
+#include "NativeDeserializer.h"
+
+#include "TClass.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cms/EventAuxiliary.h"
+#include "test_classes/TestClasses.h"
+
+/*---------------------------------------
+Measures the speed of each serialization strategy for the test classes,
+edm::EventAuxiliary and any classes named on the command line (which are
+default constructed). Classes holding collections are measured for each
+collection size. Each measurement is repeated and summarized. The results
+are written as JSON so they can be compared between versions of the code.
+
+  serialization_bench [-r repetitions] [-s size,size,...] [-o output.json] [class names]
+  ---------------------------------------*/
+namespace edm::detail {
+  static std::string const invalidHash;
+  std::string const& InvalidHash() { return invalidHash;}
+}
+
+namespace {
+  using clock_type = std::chrono::high_resolution_clock;
+
+  struct Stats {
+    double min_;
+    double median_;
+    double mean_;
+    double stddev_;
+  };
+
+  Stats summarize(std::vector<double> iValues) {
+    std::sort(iValues.begin(), iValues.end());
+    double mean = std::accumulate(iValues.begin(), iValues.end(), 0.)/iValues.size();
+    double sumSq = 0;
+    for(auto v: iValues) {
+      sumSq += (v-mean)*(v-mean);
+    }
+    auto const n = iValues.size();
+    double median = (n % 2 == 1) ? iValues[n/2] : 0.5*(iValues[n/2-1]+iValues[n/2]);
+    return {iValues.front(), median, mean, n > 1 ? std::sqrt(sumSq/(n-1)) : 0.};
+  }
+
+  //returns ns per call for each repetition. The number of calls per repetition is
+  // chosen so a repetition takes at least a few milliseconds.
+  std::vector<double> measure(unsigned int iRepetitions, std::function<void()> const& iFunc) {
+    unsigned int nCalls = 1;
+    while(true) {
+      auto start = clock_type::now();
+      for(unsigned int i=0; i<nCalls; ++i) {
+        iFunc();
+      }
+      if(clock_type::now()-start > std::chrono::milliseconds(5) or nCalls > (1U<<24)) {
+        break;
+      }
+      nCalls *= 2;
+    }
+    std::vector<double> nsPerCall;
+    nsPerCall.reserve(iRepetitions);
+    for(unsigned int r=0; r<iRepetitions; ++r) {
+      auto start = clock_type::now();
+      for(unsigned int i=0; i<nCalls; ++i) {
+        iFunc();
+      }
+      nsPerCall.push_back(std::chrono::duration<double, std::nano>(clock_type::now()-start).count()/nCalls);
+    }
+    return nsPerCall;
+  }
+
+  struct Case {
+    std::string name_;
+    std::size_t collectionSize_;
+    TClass* class_;
+    std::shared_ptr<void> object_;
+  };
+
+  template<typename T, typename... ARGS>
+  Case makeCase(std::size_t iCollectionSize, ARGS&&... iArgs) {
+    auto cls = TClass::GetClass(typeid(T));
+    if(nullptr == cls) {
+      std::cout <<"FAILED TO GET CLASS "<<typeid(T).name()<<std::endl;
+      abort();
+    }
+    return {cls->GetName(), iCollectionSize, cls,
+        std::shared_ptr<void>(new T(std::forward<ARGS>(iArgs)...), [](void* iPtr) { delete static_cast<T*>(iPtr);})};
+  }
+
+  Case makeNamedCase(std::string const& iName) {
+    auto cls = TClass::GetClass(iName.c_str());
+    if(nullptr == cls) {
+      std::cout <<"FAILED TO GET CLASS "<<iName<<std::endl;
+      abort();
+    }
+    return {cls->GetName(), 0, cls, std::shared_ptr<void>(cls->New(), [cls](void* iPtr) { cls->Destructor(iPtr);})};
+  }
+
+  std::vector<Case> builtinCases(std::vector<std::size_t> const& iSizes) {
+    using namespace cce::tf::test;
+    std::vector<Case> cases;
+    cases.push_back(makeCase<SimpleClass>(0, 5));
+    cases.push_back(makeCase<TestClass>(0, "foo", 78.9));
+    cases.push_back(makeCase<TestClassWithPointerToSimpleClass>(0, 5));
+    cases.push_back(makeCase<TestClassWithUniquePointerToSimpleClass>(0, 5));
+    cases.push_back(makeCase<TestClassWithFloatCArray>(0, 3));
+    cases.push_back(makeCase<TestClassWithFloatArray>(0, std::array<float,3>{{1,2,3}}));
+    cases.push_back(makeCase<TestClassWithFloatDynamicArray>(0, 3));
+    cases.push_back(makeCase<InheritFromAbstractInheritingFromBase>(0, 3.f, 5));
+    cases.push_back(makeCase<edm::EventAuxiliary>(0, edm::EventID{1,1,1}, "32981", edm::Timestamp{0}, true, edm::EventAuxiliary::PhysicsTrigger,12));
+    for(auto size: iSizes) {
+      cases.push_back(makeCase<TestClassWithFloatVector>(size, std::vector<float>(size, 3.14f)));
+      cases.push_back(makeCase<TestClassWithSimpleClassVector>(size, std::vector<SimpleClass>(size, SimpleClass(5))));
+      cases.push_back(makeCase<TestClassWithTestClassVector>(size, std::vector<TestClass>(size, TestClass("foo", 78.9))));
+      std::map<int,float> intFloats;
+      for(std::size_t i=0; i<size; ++i) {
+        intFloats.emplace(i, 3.14f);
+      }
+      cases.push_back(makeCase<TestClassWithIntFloatMap>(size, std::move(intFloats)));
+      cases.push_back(makeCase<std::vector<TestClassWithFloatVector>>(size, size, TestClassWithFloatVector({1,2})));
+    }
+    return cases;
+  }
+
+  struct Result {
+    std::string strategy_;
+    std::size_t bytes_;
+    Stats nsPerObject_;
+    Stats mbPerSecond_;
+  };
+
+  Result makeResult(std::string iStrategy, std::size_t iBytes, std::vector<double> const& iNsPerCall) {
+    std::vector<double> mbPerSecond;
+    mbPerSecond.reserve(iNsPerCall.size());
+    for(auto ns: iNsPerCall) {
+      //bytes per ns is GB/s
+      mbPerSecond.push_back(iBytes/ns*1000.);
+    }
+    return {std::move(iStrategy), iBytes, summarize(iNsPerCall), summarize(mbPerSecond)};
+  }
+
+  template<typename S, typename D>
+  void benchStrategy(std::string const& iName, S& iSerializer, D& iDeserializer, 
+                     std::function<cce::tf::Span<char const>(S&, void const*)> const& iSerialize,
+                     Case const& iCase, unsigned int iRepetitions, std::vector<Result>& oResults) {
+    void const* object = iCase.object_.get();
+    auto blob = iSerialize(iSerializer, object);
+    std::vector<char> buffer(blob.begin(), blob.end());
+
+    oResults.push_back(makeResult(iName+"Serializer", buffer.size(),
+                                  measure(iRepetitions, [&]() { iSerialize(iSerializer, object); })));
+
+    std::unique_ptr<void, std::function<void(void*)>> readObject(iCase.class_->New(), [cls=iCase.class_](void* iPtr) { cls->Destructor(iPtr);});
+    oResults.push_back(makeResult(iName+"Deserializer", buffer.size(),
+                                  measure(iRepetitions, [&]() { iDeserializer.deserialize(buffer.data(), buffer.size(), readObject.get()); })));
+  }
+
+  std::vector<Result> bench(Case const& iCase, unsigned int iRepetitions) {
+    using namespace cce::tf;
+    std::vector<Result> results;
+    auto cls = iCase.class_;
+    {
+      Serializer s;
+      Deserializer d(cls);
+      benchStrategy<Serializer, Deserializer>("", s, d, [cls](Serializer& iS, void const* iObj) { return iS.serialize(iObj, cls); }, iCase, iRepetitions, results);
+    }
+    {
+      UnrolledSerializer s(cls);
+      UnrolledDeserializer d(cls);
+      benchStrategy<UnrolledSerializer, UnrolledDeserializer>("Unrolled", s, d, [](UnrolledSerializer& iS, void const* iObj) { return iS.serialize(iObj); }, iCase, iRepetitions, results);
+    }
+    {
+      GeneratedSerializer s(cls);
+      GeneratedDeserializer d(cls);
+      benchStrategy<GeneratedSerializer, GeneratedDeserializer>("Generated", s, d, [](GeneratedSerializer& iS, void const* iObj) { return iS.serialize(iObj); }, iCase, iRepetitions, results);
+    }
+    {
+      NativeSerializer s(cls);
+      NativeDeserializer d(cls);
+      benchStrategy<NativeSerializer, NativeDeserializer>("Native", s, d, [](NativeSerializer& iS, void const* iObj) { return iS.serialize(iObj); }, iCase, iRepetitions, results);
+    }
+    return results;
+  }
+
+  void writeStats(std::ostream& oOut, Stats const& iStats) {
+    oOut <<"{\"min\": "<<iStats.min_<<", \"median\": "<<iStats.median_<<", \"mean\": "<<iStats.mean_<<", \"stddev\": "<<iStats.stddev_<<"}";
+  }
+
+  std::vector<std::size_t> parseSizes(std::string const& iSizes) {
+    std::vector<std::size_t> sizes;
+    std::istringstream s(iSizes);
+    std::string size;
+    while(std::getline(s, size, ',')) {
+      sizes.push_back(std::stoul(size));
+    }
+    return sizes;
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned int repetitions = 10;
+  std::vector<std::size_t> sizes = {1, 100, 10000};
+  std::string outputName;
+  std::vector<std::string> classNames;
+  for(int i=1; i<argc; ++i) {
+    std::string arg = argv[i];
+    if(arg == "-r" and i+1 < argc) {
+      repetitions = std::stoul(argv[++i]);
+    } else if(arg == "-s" and i+1 < argc) {
+      sizes = parseSizes(argv[++i]);
+    } else if(arg == "-o" and i+1 < argc) {
+      outputName = argv[++i];
+    } else {
+      classNames.push_back(arg);
+    }
+  }
+  if(repetitions == 0) {
+    std::cout <<"repetitions must be larger than 0"<<std::endl;
+    return 1;
+  }
+
+  auto cases = builtinCases(sizes);
+  for(auto const& name: classNames) {
+    cases.push_back(makeNamedCase(name));
+  }
+
+  std::ofstream outputFile;
+  if(not outputName.empty()) {
+    outputFile.open(outputName);
+  }
+  std::ostream& out = outputName.empty() ? std::cout : outputFile;
+
+  out <<"{\n  \"repetitions\": "<<repetitions<<",\n  \"results\": [";
+  bool first = true;
+  for(auto const& c: cases) {
+    for(auto const& r: bench(c, repetitions)) {
+      out <<(first ? "\n" : ",\n")
+          <<"    {\"class\": \""<<c.name_<<"\", \"collectionSize\": "<<c.collectionSize_
+          <<", \"strategy\": \""<<r.strategy_<<"\", \"bytes\": "<<r.bytes_<<",\n"
+          <<"     \"nsPerObject\": ";
+      writeStats(out, r.nsPerObject_);
+      out <<",\n     \"MBPerSecond\": ";
+      writeStats(out, r.mbPerSecond_);
+      out <<"}";
+      first = false;
+    }
+    if(not outputName.empty()) {
+      std::cout <<"done "<<c.name_<<" "<<c.collectionSize_<<std::endl;
+    }
+  }
+  out <<"\n  ]\n}\n";
+  return 0;
+}
@@ -0,0 +1,212 @@
+#include "shuffle_kernels.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SHUFFLE_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace cce::tf;
+
+namespace {
+  //the kernels work on iN whole values, values [iBegin, iN) are done here
+  void scalarShuffle(char* oTo, char const* iFrom, std::size_t iBegin, std::size_t iN, unsigned int iSize) {
+    for(unsigned int k=0; k<iSize; ++k) {
+      char* to = oTo+k*iN;
+      for(std::size_t i=iBegin; i<iN; ++i) {
+        to[i] = iFrom[i*iSize+k];
+      }
+    }
+  }
+
+  void scalarUnshuffle(char* oTo, char const* iFrom, std::size_t iBegin, std::size_t iN, unsigned int iSize) {
+    for(unsigned int k=0; k<iSize; ++k) {
+      char const* from = iFrom+k*iN;
+      for(std::size_t i=iBegin; i<iN; ++i) {
+        oTo[i*iSize+k] = from[i];
+      }
+    }
+  }
+
+  void scalarShuffle(char* oTo, char const* iFrom, std::size_t iN, unsigned int iSize) {
+    scalarShuffle(oTo, iFrom, 0, iN, iSize);
+  }
+
+  void scalarUnshuffle(char* oTo, char const* iFrom, std::size_t iN, unsigned int iSize) {
+    scalarUnshuffle(oTo, iFrom, 0, iN, iSize);
+  }
+
+#if defined(SHUFFLE_KERNELS_X86)
+  /*
+    16 values of iSize bytes fill iSize 16 byte registers. pshufb first groups the
+    bytes of the values within each register by byte position, the registers then
+    hold an iSize x iSize matrix of groups which is transposed so register k holds
+    byte k of all 16 values. Unshuffling does the same steps in reverse order, the
+    transpose being its own inverse.
+  */
+  alignas(16) constexpr char kGroup2[16] = {0,2,4,6,8,10,12,14,1,3,5,7,9,11,13,15};
+  alignas(16) constexpr char kGroup4[16] = {0,4,8,12,1,5,9,13,2,6,10,14,3,7,11,15};
+  alignas(16) constexpr char kGroup8[16] = {0,8,1,9,2,10,3,11,4,12,5,13,6,14,7,15};
+
+  char const* groupMask(unsigned int iSize) {
+    switch(iSize) {
+    case 2: return kGroup2;
+    case 4: return kGroup4;
+    }
+    return kGroup8;
+  }
+
+  //the inverse of the 2 byte grouping is the 8 byte one and vice versa, the 4 byte one is its own inverse
+  char const* ungroupMask(unsigned int iSize) {
+    switch(iSize) {
+    case 2: return kGroup8;
+    case 4: return kGroup4;
+    }
+    return kGroup2;
+  }
+
+  void transpose(__m128i* v, unsigned int iSize) {
+    switch(iSize) {
+    case 2: {
+      auto t0 = _mm_unpacklo_epi64(v[0], v[1]);
+      auto t1 = _mm_unpackhi_epi64(v[0], v[1]);
+      v[0] = t0; v[1] = t1;
+      return;
+    }
+    case 4: {
+      auto t0 = _mm_unpacklo_epi32(v[0], v[1]);
+      auto t1 = _mm_unpackhi_epi32(v[0], v[1]);
+      auto t2 = _mm_unpacklo_epi32(v[2], v[3]);
+      auto t3 = _mm_unpackhi_epi32(v[2], v[3]);
+      v[0] = _mm_unpacklo_epi64(t0, t2);
+      v[1] = _mm_unpackhi_epi64(t0, t2);
+      v[2] = _mm_unpacklo_epi64(t1, t3);
+      v[3] = _mm_unpackhi_epi64(t1, t3);
+      return;
+    }
+    case 8: {
+      __m128i b[8];
+      for(unsigned int j=0; j<8; j+=2) {
+        b[j] = _mm_unpacklo_epi16(v[j], v[j+1]);
+        b[j+1] = _mm_unpackhi_epi16(v[j], v[j+1]);
+      }
+      __m128i c[8];
+      for(unsigned int j=0; j<8; j+=4) {
+        c[j] = _mm_unpacklo_epi32(b[j], b[j+2]);
+        c[j+1] = _mm_unpackhi_epi32(b[j], b[j+2]);
+        c[j+2] = _mm_unpacklo_epi32(b[j+1], b[j+3]);
+        c[j+3] = _mm_unpackhi_epi32(b[j+1], b[j+3]);
+      }
+      for(unsigned int j=0; j<4; ++j) {
+        v[2*j] = _mm_unpacklo_epi64(c[j], c[j+4]);
+        v[2*j+1] = _mm_unpackhi_epi64(c[j], c[j+4]);
+      }
+      return;
+    }
+    }
+  }
+
+  bool hasSSSE3Kernel(unsigned int iSize) {
+    return iSize == 2 or iSize == 4 or iSize == 8;
+  }
+
+  __attribute__((target("ssse3")))
+  void ssse3Shuffle(char* oTo, char const* iFrom, std::size_t iN, unsigned int iSize) {
+    if(not hasSSSE3Kernel(iSize)) {
+      scalarShuffle(oTo, iFrom, iN, iSize);
+      return;
+    }
+    auto const mask = _mm_load_si128(reinterpret_cast<__m128i const*>(groupMask(iSize)));
+    std::size_t i = 0;
+    for(; i+16 <= iN; i+=16) {
+      __m128i v[8];
+      for(unsigned int j=0; j<iSize; ++j) {
+        v[j] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(iFrom+i*iSize+j*16)), mask);
+      }
+      transpose(v, iSize);
+      for(unsigned int k=0; k<iSize; ++k) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(oTo+k*iN+i), v[k]);
+      }
+    }
+    scalarShuffle(oTo, iFrom, i, iN, iSize);
+  }
+
+  __attribute__((target("ssse3")))
+  void ssse3Unshuffle(char* oTo, char const* iFrom, std::size_t iN, unsigned int iSize) {
+    if(not hasSSSE3Kernel(iSize)) {
+      scalarUnshuffle(oTo, iFrom, iN, iSize);
+      return;
+    }
+    auto const mask = _mm_load_si128(reinterpret_cast<__m128i const*>(ungroupMask(iSize)));
+    std::size_t i = 0;
+    for(; i+16 <= iN; i+=16) {
+      __m128i v[8];
+      for(unsigned int k=0; k<iSize; ++k) {
+        v[k] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(iFrom+k*iN+i));
+      }
+      transpose(v, iSize);
+      for(unsigned int j=0; j<iSize; ++j) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(oTo+i*iSize+j*16), _mm_shuffle_epi8(v[j], mask));
+      }
+    }
+    scalarUnshuffle(oTo, iFrom, i, iN, iSize);
+  }
+#endif
+
+  using Kernel = void(*)(char*, char const*, std::size_t, unsigned int);
+  struct Choice {
+    Kernel shuffle_;
+    Kernel unshuffle_;
+    char const* name_;
+  };
+
+  Choice chooseKernel() {
+#if defined(SHUFFLE_KERNELS_X86)
+    if(__builtin_cpu_supports("ssse3")) {
+      return {&ssse3Shuffle, &ssse3Unshuffle, "SSSE3"};
+    }
+#endif
+    return {&scalarShuffle, &scalarUnshuffle, "scalar"};
+  }
+
+  Choice const& kernel() {
+    static Choice const s_choice = chooseKernel();
+    return s_choice;
+  }
+
+  //applies iKernel to the whole values at the end of the buffer
+  void apply(Kernel iKernel, void* oTo, void const* iFrom, std::size_t iNBytes, unsigned int iSize) {
+    auto to = static_cast<char*>(oTo);
+    auto from = static_cast<char const*>(iFrom);
+    if(iSize <= 1) {
+      std::memcpy(to, from, iNBytes);
+      return;
+    }
+    auto const nLeading = iNBytes % iSize;
+    std::memcpy(to, from, nLeading);
+    iKernel(to+nLeading, from+nLeading, iNBytes/iSize, iSize);
+  }
+}
+
+namespace cce::tf::shuffle {
+  void copyShuffled(void* oTo, void const* iFrom, std::size_t iNBytes, unsigned int iSize) {
+    apply(kernel().shuffle_, oTo, iFrom, iNBytes, iSize);
+  }
+
+  void copyUnshuffled(void* oTo, void const* iFrom, std::size_t iNBytes, unsigned int iSize) {
+    apply(kernel().unshuffle_, oTo, iFrom, iNBytes, iSize);
+  }
+
+  void copyShuffledScalar(void* oTo, void const* iFrom, std::size_t iNBytes, unsigned int iSize) {
+    apply(&scalarShuffle, oTo, iFrom, iNBytes, iSize);
+  }
+
+  void copyUnshuffledScalar(void* oTo, void const* iFrom, std::size_t iNBytes, unsigned int iSize) {
+    apply(&scalarUnshuffle, oTo, iFrom, iNBytes, iSize);
+  }
+
+  char const* kernelName() {
+    return kernel().name_;
+  }
+}
@@ -0,0 +1,34 @@
+#if !defined(shuffle_kernels_h)
+#define shuffle_kernels_h
+
+#include <cstddef>
+
+namespace cce::tf::shuffle {
+  /*---------------------------------------
+  Byte shuffle filter applied before compression. The bytes of iSize byte
+  values are regrouped so all the first bytes of the values come first, then
+  all the second bytes, etc. For arrays of numbers the high bytes (sign,
+  exponent) of neighboring values are then next to each other which makes
+  the buffer much easier to compress.
+
+  iNBytes does not have to be a multiple of iSize: the first iNBytes % iSize
+  bytes are copied unchanged and only the rest is shuffled. That keeps the
+  values whole when they are at the end of the buffer, as the elements of a
+  serialized std::vector are.
+
+  The fastest kernel supported by the CPU (SSSE3 or plain C++) is chosen the
+  first time a kernel is used. The ranges must not overlap.
+  ---------------------------------------*/
+
+  void copyShuffled(void* oTo, void const* iFrom, std::size_t iNBytes, unsigned int iSize);
+  //undoes copyShuffled
+  void copyUnshuffled(void* oTo, void const* iFrom, std::size_t iNBytes, unsigned int iSize);
+
+  //same as above but always use the plain C++ kernel, used for testing and benchmarks
+  void copyShuffledScalar(void* oTo, void const* iFrom, std::size_t iNBytes, unsigned int iSize);
+  void copyUnshuffledScalar(void* oTo, void const* iFrom, std::size_t iNBytes, unsigned int iSize);
+
+  //name of the kernel used by copyShuffled and copyUnshuffled
+  char const* kernelName();
+}
+#endif
@@ -0,0 +1,105 @@
+#include "Serializer.h"
+#include "Deserializer.h"
+#include "UnrolledSerializer.h"
+#include "UnrolledDeserializer.h"
+#include "swap_kernels.h"
+
+#include "TClass.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "test_classes/TestClasses.h"
+
+/*---------------------------------------
+Measures the time needed to byte swap arrays of builtins. The kernels are
+compared directly and as used by UnrolledSerializer/UnrolledDeserializer
+(which stream std::vectors and fixed length arrays of builtins in bulk)
+against ROOT's standard serialization.
+
+  swap_bench [number of floats] [number of calls]
+  ---------------------------------------*/
+namespace {
+  using clock_type = std::chrono::high_resolution_clock;
+
+  template<typename F>
+  double nsPerCall(unsigned int iNCalls, F&& iFunc) {
+    //warm up caches and allocators
+    for(unsigned int i=0; i< iNCalls/10+1; ++i) {
+      iFunc();
+    }
+    auto start = clock_type::now();
+    for(unsigned int i=0; i<iNCalls; ++i) {
+      iFunc();
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now()-start).count()/double(iNCalls);
+  }
+
+  void benchKernels(std::size_t iNFloats, unsigned int iNCalls) {
+    std::vector<float> from(iNFloats, 3.14f);
+    std::vector<float> to(iNFloats);
+    auto scalar = nsPerCall(iNCalls, [&]() {
+        cce::tf::swap::copySwappedScalar(to.data(), from.data(), from.size(), sizeof(float));
+      });
+    auto vectorized = nsPerCall(iNCalls, [&]() {
+        cce::tf::swap::copySwapped(to.data(), from.data(), from.size(), sizeof(float));
+      });
+    std::cout <<"kernels ("<<iNFloats<<" floats)\n"
+              <<"  scalar: "<<scalar<<"ns/call\n"
+              <<"  "<<cce::tf::swap::kernelName()<<": "<<vectorized<<"ns/call"<<std::endl;
+  }
+
+  template<typename T>
+  void bench(const char* iName, T const& iObject, unsigned int iNCalls) {
+    using namespace cce::tf;
+    auto cls = TClass::GetClass(typeid(T));
+    if(nullptr == cls) {
+      std::cout <<"FAILED TO GET CLASS "<<iName<<std::endl;
+      abort();
+    }
+    Serializer s;
+    auto standardWrite = nsPerCall(iNCalls, [&]() { s.serialize(&iObject, cls); });
+    auto blob = s.serialize(&iObject, cls);
+    std::vector<char> standardBuffer(blob.begin(), blob.end());
+
+    UnrolledSerializer us(cls);
+    auto unrolledWrite = nsPerCall(iNCalls, [&]() { us.serialize(&iObject); });
+    auto unrolledBlob = us.serialize(&iObject);
+    std::vector<char> unrolledBuffer(unrolledBlob.begin(), unrolledBlob.end());
+
+    T readObject;
+    Deserializer d(cls);
+    auto standardRead = nsPerCall(iNCalls, [&]() {
+        d.deserialize(standardBuffer.data(), standardBuffer.size(), &readObject);
+      });
+    UnrolledDeserializer ud(cls);
+    auto unrolledRead = nsPerCall(iNCalls, [&]() {
+        ud.deserialize(unrolledBuffer.data(), unrolledBuffer.size(), &readObject);
+      });
+
+    std::cout <<iName<<" ("<<unrolledBuffer.size()<<" bytes)\n"
+              <<"  standard write: "<<standardWrite<<"ns/call\n"
+              <<"  unrolled write: "<<unrolledWrite<<"ns/call\n"
+              <<"  standard read: "<<standardRead<<"ns/call\n"
+              <<"  unrolled read: "<<unrolledRead<<"ns/call"<<std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  std::size_t nFloats = 100000;
+  unsigned int nCalls = 1000;
+  if(argc > 1) {
+    nFloats = std::stoul(argv[1]);
+  }
+  if(argc > 2) {
+    nCalls = std::stoul(argv[2]);
+  }
+
+  benchKernels(nFloats, nCalls);
+  bench("cce::tf::test::TestClassWithFloatVector", cce::tf::test::TestClassWithFloatVector(std::vector<float>(nFloats, 3.14f)), nCalls);
+  //the array is small so do many more calls
+  bench("cce::tf::test::TestClassWithFloatCArray", cce::tf::test::TestClassWithFloatCArray(3.14f), nCalls*1000);
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include "swap_kernels.h"
+#include "RConfig.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(R__BYTESWAP) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SWAP_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace cce::tf;
+
+namespace {
+  template<typename T, typename F>
+  void scalarLoop(char* oTo, char const* iFrom, std::size_t iN, F iSwap) {
+    //memcpy avoids alignment requirements and is optimized away
+    for(std::size_t i=0; i<iN; ++i) {
+      T v;
+      std::memcpy(&v, iFrom+i*sizeof(T), sizeof(T));
+      v = iSwap(v);
+      std::memcpy(oTo+i*sizeof(T), &v, sizeof(T));
+    }
+  }
+
+  void scalar(char* oTo, char const* iFrom, std::size_t iN, unsigned int iSize) {
+#if defined(R__BYTESWAP)
+    switch(iSize) {
+    case 2:
+      scalarLoop<std::uint16_t>(oTo, iFrom, iN, [](std::uint16_t v) { return __builtin_bswap16(v);}); return;
+    case 4:
+      scalarLoop<std::uint32_t>(oTo, iFrom, iN, [](std::uint32_t v) { return __builtin_bswap32(v);}); return;
+    case 8:
+      scalarLoop<std::uint64_t>(oTo, iFrom, iN, [](std::uint64_t v) { return __builtin_bswap64(v);}); return;
+    }
+#endif
+    std::memcpy(oTo, iFrom, iN*iSize);
+  }
+
+#if defined(SWAP_KERNELS_X86)
+  //byte indices used by pshufb to reverse each value within a 16 byte block
+  alignas(16) constexpr char kReverse2[16] = {1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14};
+  alignas(16) constexpr char kReverse4[16] = {3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12};
+  alignas(16) constexpr char kReverse8[16] = {7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8};
+
+  char const* reverseMask(unsigned int iSize) {
+    switch(iSize) {
+    case 2: return kReverse2;
+    case 4: return kReverse4;
+    }
+    return kReverse8;
+  }
+
+  __attribute__((target("ssse3")))
+  void ssse3(char* oTo, char const* iFrom, std::size_t iN, unsigned int iSize) {
+    if(iSize == 1) {
+      std::memcpy(oTo, iFrom, iN);
+      return;
+    }
+    auto const mask = _mm_load_si128(reinterpret_cast<__m128i const*>(reverseMask(iSize)));
+    std::size_t const nBytes = iN*iSize;
+    std::size_t i = 0;
+    for(; i+16 <= nBytes; i+=16) {
+      auto v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(iFrom+i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(oTo+i), _mm_shuffle_epi8(v, mask));
+    }
+    scalar(oTo+i, iFrom+i, (nBytes-i)/iSize, iSize);
+  }
+
+  __attribute__((target("avx2")))
+  void avx2(char* oTo, char const* iFrom, std::size_t iN, unsigned int iSize) {
+    if(iSize == 1) {
+      std::memcpy(oTo, iFrom, iN);
+      return;
+    }
+    //pshufb works within each 128 bit lane so the same mask is used for both lanes
+    auto const mask = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<__m128i const*>(reverseMask(iSize))));
+    std::size_t const nBytes = iN*iSize;
+    std::size_t i = 0;
+    for(; i+64 <= nBytes; i+=64) {
+      auto v0 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(iFrom+i));
+      auto v1 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(iFrom+i+32));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(oTo+i), _mm256_shuffle_epi8(v0, mask));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(oTo+i+32), _mm256_shuffle_epi8(v1, mask));
+    }
+    for(; i+32 <= nBytes; i+=32) {
+      auto v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(iFrom+i));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(oTo+i), _mm256_shuffle_epi8(v, mask));
+    }
+    scalar(oTo+i, iFrom+i, (nBytes-i)/iSize, iSize);
+  }
+#endif
+
+  using Kernel = void(*)(char*, char const*, std::size_t, unsigned int);
+  struct Choice {
+    Kernel kernel_;
+    char const* name_;
+  };
+
+  Choice chooseKernel() {
+#if defined(SWAP_KERNELS_X86)
+    if(__builtin_cpu_supports("avx2")) {
+      return {&avx2, "AVX2"};
+    }
+    if(__builtin_cpu_supports("ssse3")) {
+      return {&ssse3, "SSSE3"};
+    }
+#endif
+    return {&scalar, "scalar"};
+  }
+
+  Choice const& kernel() {
+    static Choice const s_choice = chooseKernel();
+    return s_choice;
+  }
+}
+
+namespace cce::tf::swap {
+  void copySwapped(void* oTo, void const* iFrom, std::size_t iN, unsigned int iSize) {
+    kernel().kernel_(static_cast<char*>(oTo), static_cast<char const*>(iFrom), iN, iSize);
+  }
+
+  void copySwappedScalar(void* oTo, void const* iFrom, std::size_t iN, unsigned int iSize) {
+    scalar(static_cast<char*>(oTo), static_cast<char const*>(iFrom), iN, iSize);
+  }
+
+  char const* kernelName() {
+    return kernel().name_;
+  }
+}
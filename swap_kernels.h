@@ -0,0 +1,27 @@
+#if !defined(swap_kernels_h)
+#define swap_kernels_h
+
+#include <cstddef>
+
+namespace cce::tf::swap {
+  /*---------------------------------------
+  Bulk conversion between the machine byte order and the big-endian order
+  used by ROOT's TBuffer. Reversing the bytes is its own inverse so the
+  same function is used for reading and writing. On big-endian machines
+  this is a memcpy.
+
+  The fastest kernel supported by the CPU (AVX2, SSSE3 or plain C++) is
+  chosen the first time a kernel is used.
+  ---------------------------------------*/
+
+  //copies iN values, each iSize bytes long, from iFrom to oTo reversing the bytes of each value.
+  // iSize must be 1, 2, 4 or 8. The ranges must not overlap.
+  void copySwapped(void* oTo, void const* iFrom, std::size_t iN, unsigned int iSize);
+
+  //same as copySwapped but always uses the plain C++ kernel, used for testing and benchmarks
+  void copySwappedScalar(void* oTo, void const* iFrom, std::size_t iN, unsigned int iSize);
+
+  //name of the kernel used by copySwapped
+  char const* kernelName();
+}
+#endif
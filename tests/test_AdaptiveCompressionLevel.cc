@@ -0,0 +1,107 @@
+#include "catch2/catch.hpp"
+#include "AdaptiveCompressionLevel.h"
+#include "ConfigurationParameters.h"
+
+#include <thread>
+
+TEST_CASE("Test AdaptiveCompressionLevel class", "[AdaptiveCompressionLevel]") {
+  using namespace cce::tf;
+  using namespace std::chrono_literals;
+
+  SECTION("initial level is clamped") {
+    REQUIRE(AdaptiveCompressionLevel(3, 7, 1, 2).level() == 3);
+    REQUIRE(AdaptiveCompressionLevel(3, 7, 9, 2).level() == 7);
+    REQUIRE(AdaptiveCompressionLevel(3, 7, 5, 2).level() == 5);
+  }
+
+  SECTION("writer waiting lowers the level down to the minimum") {
+    AdaptiveCompressionLevel adaptive(3, 7, 5, 2, 4);
+    //nothing is queued for the writer so it is waiting on the compression
+    for(int i=0; i<4; ++i) {
+      adaptive.compressed(adaptive.level(), 10us);
+    }
+    REQUIRE(adaptive.level() == 4);
+    for(int i=0; i<100; ++i) {
+      adaptive.compressed(adaptive.level(), 10us);
+    }
+    REQUIRE(adaptive.level() == 3);
+  }
+
+  SECTION("a long writer queue raises the level up to the maximum") {
+    AdaptiveCompressionLevel adaptive(3, 7, 5, 2, 4);
+    for(int i=0; i<3; ++i) {
+      adaptive.pushedToWriter();
+    }
+    for(int i=0; i<4; ++i) {
+      adaptive.compressed(adaptive.level(), 10us);
+    }
+    REQUIRE(adaptive.level() == 6);
+    for(int i=0; i<100; ++i) {
+      adaptive.compressed(adaptive.level(), 10us);
+    }
+    REQUIRE(adaptive.level() == 7);
+  }
+
+  SECTION("a compression slower than the writer drains the queue keeps the level") {
+    AdaptiveCompressionLevel adaptive(3, 7, 5, 2, 4);
+    for(int i=0; i<3; ++i) {
+      adaptive.pushedToWriter();
+    }
+    for(int i=0; i<100; ++i) {
+      //the writer takes buffers back to back so it drains the queue much faster than 1s
+      adaptive.takenByWriter();
+      adaptive.pushedToWriter();
+      adaptive.compressed(adaptive.level(), 1s);
+    }
+    REQUIRE(adaptive.level() == 5);
+  }
+
+  SECTION("a compression faster than the writer drains the queue raises the level") {
+    AdaptiveCompressionLevel adaptive(3, 7, 5, 2, 4);
+    for(int i=0; i<3; ++i) {
+      adaptive.pushedToWriter();
+    }
+    for(int i=0; i<4; ++i) {
+      adaptive.takenByWriter();
+      adaptive.pushedToWriter();
+      std::this_thread::sleep_for(2ms);
+      adaptive.compressed(adaptive.level(), 1us);
+    }
+    REQUIRE(adaptive.level() == 6);
+  }
+
+  SECTION("a queue between 1 and the target keeps the level") {
+    AdaptiveCompressionLevel adaptive(3, 7, 5, 2, 4);
+    adaptive.pushedToWriter();
+    adaptive.pushedToWriter();
+    adaptive.takenByWriter();
+    for(int i=0; i<100; ++i) {
+      adaptive.compressed(adaptive.level(), 10us);
+    }
+    REQUIRE(adaptive.level() == 5);
+  }
+
+  SECTION("makeAdaptiveCompressionLevel") {
+    SECTION("off by default") {
+      ConfigurationParameters params(ConfigurationParameters::KeyValueMap{});
+      auto adaptive = makeAdaptiveCompressionLevel(params, pds::Compression::kZSTD, 5);
+      REQUIRE(adaptive);
+      REQUIRE(not *adaptive);
+    }
+    SECTION("on") {
+      ConfigurationParameters params(ConfigurationParameters::KeyValueMap{{"adaptiveCompression","t"}, {"minCompressionLevel","2"}, {"maxCompressionLevel","4"}});
+      auto adaptive = makeAdaptiveCompressionLevel(params, pds::Compression::kZSTDLong, 5);
+      REQUIRE(adaptive);
+      REQUIRE(*adaptive);
+      REQUIRE((*adaptive)->level() == 4);
+    }
+    SECTION("only for ZSTD") {
+      ConfigurationParameters params(ConfigurationParameters::KeyValueMap{{"adaptiveCompression","t"}});
+      REQUIRE(not makeAdaptiveCompressionLevel(params, pds::Compression::kLZ4, 5));
+    }
+    SECTION("bad range") {
+      ConfigurationParameters params(ConfigurationParameters::KeyValueMap{{"adaptiveCompression","t"}, {"minCompressionLevel","5"}, {"maxCompressionLevel","4"}});
+      REQUIRE(not makeAdaptiveCompressionLevel(params, pds::Compression::kZSTD, 5));
+    }
+  }
+}
@@ -0,0 +1,45 @@
+#include "catch2/catch.hpp"
+#include "pds_writer.h"
+#include "pds_reading.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+  std::vector<char> testBytes(std::size_t iNBytes) {
+    //repeats often enough to compress
+    std::vector<char> bytes(iNBytes);
+    for(std::size_t i=0; i<iNBytes; ++i) {
+      bytes[i] = static_cast<char>((i % 251)*(i % 7));
+    }
+    return bytes;
+  }
+}
+
+TEST_CASE("Test compressing in blocks", "[pds]") {
+  using namespace cce::tf;
+
+  uint32_t const blockSize = 1000;
+  for(auto compression: {pds::Compression::kNone, pds::Compression::kLZ4, pds::Compression::kZSTD}) {
+    //the sizes include a final partial block and a buffer smaller than one block
+    for(std::size_t nBytes: {std::size_t(0), std::size_t(1), std::size_t(blockSize-1), std::size_t(blockSize),
+                             std::size_t(3*blockSize), std::size_t(3*blockSize+17)}) {
+      DYNAMIC_SECTION(pds::name(compression)<<" bytes "<<nBytes) {
+        auto const original = testBytes(nBytes);
+        auto compressed = pds::compressBufferInBlocks(compression, 3, Span<char const>(original.data(), original.size()), blockSize);
+
+        //number of blocks, block size then the compressed size of each block
+        REQUIRE(compressed.size() >= 2*4);
+        uint32_t nBlocks;
+        std::memcpy(&nBlocks, compressed.data(), 4);
+        REQUIRE(nBlocks == (nBytes+blockSize-1)/blockSize);
+
+        UninitializedBuffer<char> buffer;
+        auto uncompressed = pds::uncompressBufferInBlocks(compression, compressed, nBytes, buffer);
+        REQUIRE(uncompressed.size() == nBytes);
+        REQUIRE(std::equal(uncompressed.begin(), uncompressed.end(), original.begin()));
+      }
+    }
+  }
+}
@@ -0,0 +1,57 @@
+#include "catch2/catch.hpp"
+#include "shuffle_kernels.h"
+
+#include <vector>
+
+namespace {
+  std::vector<char> testBytes(std::size_t iNBytes) {
+    std::vector<char> bytes(iNBytes);
+    for(std::size_t i=0; i<iNBytes; ++i) {
+      bytes[i] = static_cast<char>(i*37+11);
+    }
+    return bytes;
+  }
+}
+
+TEST_CASE("Test shuffle kernels", "[shuffle]") {
+  using namespace cce::tf::shuffle;
+
+  REQUIRE(kernelName() != nullptr);
+
+  //the lengths include ones which are not a multiple of 16 values, or of the value size,
+  // so the leading bytes and the tail done by the plain C++ loop are both exercised
+  for(unsigned int size: {2u, 3u, 4u, 8u}) {
+    for(std::size_t nValues: {0u, 1u, 15u, 16u, 17u, 33u, 100u, 1000u}) {
+      for(std::size_t nLeading: {0u, 1u}) {
+        auto const nBytes = nValues*size + (size > 1 ? nLeading % size : 0);
+        DYNAMIC_SECTION("size "<<size<<" bytes "<<nBytes) {
+          auto const original = testBytes(nBytes);
+
+          std::vector<char> shuffled(nBytes);
+          copyShuffled(shuffled.data(), original.data(), nBytes, size);
+          std::vector<char> shuffledScalar(nBytes);
+          copyShuffledScalar(shuffledScalar.data(), original.data(), nBytes, size);
+          REQUIRE(shuffled == shuffledScalar);
+
+          //the leading bytes are copied unchanged then byte k of value i is at k*nValues+i
+          auto const leading = nBytes % size;
+          for(std::size_t i=0; i<leading; ++i) {
+            REQUIRE(shuffled[i] == original[i]);
+          }
+          for(std::size_t i=0; i<nValues; ++i) {
+            for(unsigned int k=0; k<size; ++k) {
+              REQUIRE(shuffled[leading+k*nValues+i] == original[leading+i*size+k]);
+            }
+          }
+
+          std::vector<char> unshuffled(nBytes);
+          copyUnshuffled(unshuffled.data(), shuffled.data(), nBytes, size);
+          std::vector<char> unshuffledScalar(nBytes);
+          copyUnshuffledScalar(unshuffledScalar.data(), shuffled.data(), nBytes, size);
+          REQUIRE(unshuffled == unshuffledScalar);
+          REQUIRE(unshuffled == original);
+        }
+      }
+    }
+  }
+}
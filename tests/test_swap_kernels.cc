@@ -0,0 +1,61 @@
+#include "catch2/catch.hpp"
+#include "swap_kernels.h"
+#include "RConfig.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+  std::vector<char> testBytes(std::size_t iNBytes) {
+    std::vector<char> bytes(iNBytes);
+    for(std::size_t i=0; i<iNBytes; ++i) {
+      bytes[i] = static_cast<char>(i*37+11);
+    }
+    return bytes;
+  }
+}
+
+TEST_CASE("Test swap kernels", "[swap]") {
+  using namespace cce::tf::swap;
+
+  REQUIRE(kernelName() != nullptr);
+
+  for(unsigned int size: {2u, 4u, 8u}) {
+    //the lengths are around the 16 byte SSSE3 and 32 byte AVX2 widths so both the
+    // vector loops and the tail done by the plain C++ loop are exercised
+    std::vector<std::size_t> lengths = {0, 1, 1000};
+    for(std::size_t width: {16u, 32u}) {
+      auto const perVector = width/size;
+      for(std::size_t n: {perVector-1, perVector, 2*perVector, 2*perVector+1, 4*perVector+perVector-1}) {
+        lengths.push_back(n);
+      }
+    }
+    for(std::size_t nValues: lengths) {
+      //the offsets keep the source and destination from being aligned to a vector
+      for(std::size_t offset: {0u, 1u, 3u}) {
+        DYNAMIC_SECTION("size "<<size<<" values "<<nValues<<" offset "<<offset) {
+          auto const nBytes = nValues*size;
+          auto const original = testBytes(nBytes+offset);
+          char const* from = original.data()+offset;
+
+          std::vector<char> swapped(nBytes+offset+1);
+          copySwapped(swapped.data()+1, from, nValues, size);
+          std::vector<char> swappedScalar(nBytes+offset+1);
+          copySwappedScalar(swappedScalar.data()+1, from, nValues, size);
+          REQUIRE(std::equal(swapped.begin()+1, swapped.begin()+1+nBytes, swappedScalar.begin()+1));
+#if defined(R__BYTESWAP)
+          for(std::size_t i=0; i<nValues; ++i) {
+            for(unsigned int k=0; k<size; ++k) {
+              REQUIRE(swapped[1+i*size+k] == from[i*size+size-1-k]);
+            }
+          }
+#endif
+
+          std::vector<char> back(nBytes+offset);
+          copySwapped(back.data()+offset, swapped.data()+1, nValues, size);
+          REQUIRE(std::equal(back.begin()+offset, back.end(), from));
+        }
+      }
+    }
+  }
+}
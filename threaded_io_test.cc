@@ -142,7 +142,7 @@ int main(int argc, char* argv[]) {
     auto source = sourceFactory(nLanes, nEvents);
     std::unique_ptr<WaiterBase> waiter;
     if(waiterFactory) {
-      waiter = waiterFactory(nLanes, source->numberOfDataProducts());
+      waiter = waiterFactory(nLanes, source->dataProducts(0, -1));
       if(not waiter) {
         std::cout <<"failed to create Waiter "<<waiterConfig<<std::endl;
         return 1;
@@ -192,6 +192,9 @@ int main(int argc, char* argv[]) {
 
     source->printSummary();
     out->printSummary();
+    if(waiter) {
+      waiter->printSummary();
+    }
   } catch(std::exception const& e) {
     std::cout <<"Caught exception "<<e.what()<<std::endl;
   }
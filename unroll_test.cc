@@ -1,6 +1,8 @@
 #include "UnrolledSerializer.h"
 #include "UnrolledDeserializer.h"
 #include "Serializer.h"
+#include "GeneratedSerializer.h"
+#include "GeneratedDeserializer.h"
 
 #include "TClass.h"
 #include "TClonesArray.h"
@@ -9,6 +11,8 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <algorithm>
+#include <chrono>
 
 #include "cms/EventAuxiliary.h"
 #include "test_classes/TestClasses.h"
@@ -20,6 +24,86 @@ namespace edm::detail {
 
 
 namespace {
+  template<typename F>
+  double timeCalls(F&& iFunc) {
+    constexpr int kNCalls = 1000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(int i=0; i<kNCalls; ++i) {
+      iFunc();
+    }
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now()-start).count();
+  }
+
+  //compares streaming builtins in bulk to using ROOT's actions for each builtin
+  template<typename T>
+  void compareBulk(TClass* iClass, T const& iObject) {
+    using namespace cce::tf;
+    UnrolledSerializer bulk(iClass);
+    UnrolledSerializer perElement(iClass, false);
+    auto bulkBlob = bulk.serialize(&iObject);
+    auto perElementBlob = perElement.serialize(&iObject);
+    if(bulkBlob.size() != perElementBlob.size() or not std::equal(bulkBlob.begin(), bulkBlob.end(), perElementBlob.begin())) {
+      std::cout <<"bulk serialization differs from per element"<<std::endl;
+      abort();
+    }
+    std::vector<char> buffer(bulkBlob.begin(), bulkBlob.end());
+
+    auto bulkWrite = timeCalls([&]() { bulk.serialize(&iObject); });
+    auto perElementWrite = timeCalls([&]() { perElement.serialize(&iObject); });
+
+    UnrolledDeserializer bulkReader(iClass);
+    UnrolledDeserializer perElementReader(iClass, false);
+    T readObject;
+    auto bulkRead = timeCalls([&]() { bulkReader.deserialize(buffer.data(), buffer.size(), &readObject); });
+    auto perElementRead = timeCalls([&]() { perElementReader.deserialize(buffer.data(), buffer.size(), &readObject); });
+    std::cout <<"bulk speed-up write "<<perElementWrite/bulkWrite<<" read "<<perElementRead/bulkRead<<std::endl;
+  }
+
+  //The generated code is only checked against the unrolled code for the first object it sees, so
+  // a default constructed object goes first and iObject is compared here.
+  template<typename T>
+  void compareGenerated(TClass* iClass, T const& iObject) {
+    using namespace cce::tf;
+    UnrolledSerializer unrolled(iClass);
+    auto unrolledBlob = unrolled.serialize(&iObject);
+    std::vector<char> buffer(unrolledBlob.begin(), unrolledBlob.end());
+
+    GeneratedSerializer generated(iClass);
+    T const defaultObject{};
+    generated.serialize(&defaultObject);
+    auto generatedBlob = generated.serialize(&iObject);
+    if(generatedBlob.size() != buffer.size() or not std::equal(generatedBlob.begin(), generatedBlob.end(), buffer.begin())) {
+      std::cout <<"generated serialization differs from unrolled"<<std::endl;
+      abort();
+    }
+
+    GeneratedDeserializer generatedReader(iClass);
+    UnrolledDeserializer unrolledReader(iClass);
+    {
+      auto defaultBlob = unrolled.serialize(&defaultObject);
+      std::vector<char> defaultBuffer(defaultBlob.begin(), defaultBlob.end());
+      T readObject;
+      generatedReader.deserialize(defaultBuffer.data(), defaultBuffer.size(), &readObject);
+    }
+    T readObject;
+    generatedReader.deserialize(buffer.data(), buffer.size(), &readObject);
+    auto readBlob = unrolled.serialize(&readObject);
+    if(readBlob.size() != buffer.size() or not std::equal(readBlob.begin(), readBlob.end(), buffer.begin())) {
+      std::cout <<"generated deserialization differs from unrolled"<<std::endl;
+      abort();
+    }
+    std::cout <<"generated code used "<<(generated.usesGeneratedCode()? "yes":"no")<<std::endl;
+    if(not generated.usesGeneratedCode()) {
+      return;
+    }
+
+    auto unrolledWrite = timeCalls([&]() { unrolled.serialize(&iObject); });
+    auto generatedWrite = timeCalls([&]() { generated.serialize(&iObject); });
+    auto unrolledRead = timeCalls([&]() { unrolledReader.deserialize(buffer.data(), buffer.size(), &readObject); });
+    auto generatedRead = timeCalls([&]() { generatedReader.deserialize(buffer.data(), buffer.size(), &readObject); });
+    std::cout <<"generated speed-up write "<<unrolledWrite/generatedWrite<<" read "<<unrolledRead/generatedRead<<std::endl;
+  }
+
   template<typename T>
   T runTest(T const& iObject) {
   using namespace cce::tf;
@@ -45,10 +129,13 @@ namespace {
     std::cout <<"standard size "<<b.size()<<std::endl;
   }
 
+  compareGenerated(cls, iObject);
+  compareBulk(cls, iObject);
+
   UnrolledDeserializer ud(cls);
   
   T newObj;
-  ud.deserialize(buffer, &newObj);
+  ud.deserialize(buffer.data(), buffer.size(), &newObj);
 
   return newObj;
   }
@@ -3,13 +3,13 @@
 #include "configKeyValuePairs.h"
 #include <iostream>
 
-std::function<std::unique_ptr<cce::tf::WaiterBase>(unsigned int, std::size_t)>
+std::function<std::unique_ptr<cce::tf::WaiterBase>(unsigned int, std::vector<cce::tf::DataProductRetriever> const&)>
 cce::tf::waiterFactoryGenerator(std::string_view iType, std::string_view iOptions) {
-  std::function<std::unique_ptr<WaiterBase>(unsigned int, std::size_t)> waitFactory;
+  std::function<std::unique_ptr<WaiterBase>(unsigned int, std::vector<DataProductRetriever> const&)> waitFactory;
 
   auto keyValues = cce::tf::configKeyValuePairs(iOptions);
-  waitFactory = [type=std::string(iType), params=ConfigurationParameters(keyValues)](unsigned int iNLanes, size_t iNDataProducts) {
-    auto maker = WaiterFactory::get()->create(type, iNLanes, iNDataProducts, params);
+  waitFactory = [type=std::string(iType), params=ConfigurationParameters(keyValues)](unsigned int iNLanes, std::vector<DataProductRetriever> const& iDataProducts) {
+    auto maker = WaiterFactory::get()->create(type, iNLanes, iDataProducts, params);
     if(not maker) {
       return maker;
     }
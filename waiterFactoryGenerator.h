@@ -4,10 +4,12 @@
 #include <functional>
 #include <memory>
 #include <string_view>
+#include <vector>
 #include "WaiterBase.h"
+#include "DataProductRetriever.h"
 
 namespace cce::tf {
-std::function<std::unique_ptr<WaiterBase>(unsigned int, size_t)>
+std::function<std::unique_ptr<WaiterBase>(unsigned int, std::vector<DataProductRetriever> const&)>
 waiterFactoryGenerator(std::string_view iType, std::string_view iOptions);
 }
 #endif